@@ -0,0 +1,72 @@
+// Measures how long it takes to parse a large generated script into an AST and to free it again, and how
+// much the peak resident set size grows while the AST is alive.
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "parser.h"
+#include "pass_manager.h"
+
+static std::string GenerateScript(size_t target_size) {
+    std::string source_code;
+    source_code.reserve(target_size + 512);
+    for (size_t i = 0; source_code.size() < target_size; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun update_" + n + "(position, velocity, delta) {\n"
+                       "    var next = position + velocity * delta - (1.5 * delta) / 2;\n"
+                       "    if (next > 100 and !(velocity == nil) or next < -100) {\n"
+                       "        next = clamp(next, -100, 100);\n"
+                       "    } else {\n"
+                       "        print \"in range\";\n"
+                       "    }\n"
+                       "    while (next >= 0) { next = next - 1; }\n"
+                       "    return next * (delta + 1);\n"
+                       "}\n"
+                       "update_" + n + "(1, 2, 0.016);\n";
+    }
+    return source_code;
+}
+
+static double PeakRSSMegabytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / 1024; // ru_maxrss is in kilobytes on Linux
+}
+
+int main() {
+    constexpr size_t SOURCE_SIZE = 32 * 1024 * 1024;
+    constexpr int RUNS = 5;
+    const std::string source_code = GenerateScript(SOURCE_SIZE);
+    double rss_before = PeakRSSMegabytes();
+
+    double best_parse_ms = 0;
+    double best_free_ms = 0;
+    size_t node_count = 0;
+    double ast_rss = 0;
+    for (int run = 0; run < RUNS; run++) {
+        Parser parser(source_code);
+        auto start = std::chrono::steady_clock::now();
+        auto ast = parser.GenerateAST();
+        double parse_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0) {
+            ast_rss = PeakRSSMegabytes() - rss_before; // Later runs reuse the memory the first one returned
+            node_count = CountASTNodes(*ast);
+        }
+
+        start = std::chrono::steady_clock::now();
+        ast.reset();
+        double free_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || parse_ms < best_parse_ms) best_parse_ms = parse_ms;
+        if (run == 0 || free_ms < best_free_ms) best_free_ms = free_ms;
+    }
+
+    std::cout << std::left << std::setw(12) << "[SIZE (MB)]" << std::setw(12) << "[NODES]" << std::setw(14)
+              << "[PARSE (ms)]" << std::setw(14) << "[FREE (ms)]" << "[PEAK RSS GROWTH (MB)]\n";
+    std::cout << std::left << std::fixed << std::setprecision(1) << std::setw(12)
+              << static_cast<double>(source_code.size()) / (1024 * 1024) << std::setw(12) << node_count
+              << std::setw(14) << best_parse_ms << std::setw(14) << best_free_ms << ast_rss << "\n";
+    return 0;
+}
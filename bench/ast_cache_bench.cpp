@@ -0,0 +1,107 @@
+// Measures loading the AST of a 10MB script from an ASTCache against parsing it with Parser::GenerateAST (and
+// against parsing plus semantic analysis, which a cache hit also skips), and checks that both compile to the
+// same bytecode.
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "ast_cache.h"
+#include "compiler.h"
+#include "parser.h"
+#include "semantic_analyser.h"
+
+static std::string GenerateScript(size_t target_size) {
+    std::string source_code;
+    source_code.reserve(target_size + 512);
+    for (size_t i = 0; source_code.size() < target_size; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun update_" + n + "(position, velocity, delta) {\n"
+                       "    var next = position + velocity * delta - (1.5 * delta) / 2;\n"
+                       "    if (next > 100 == !(velocity == nil)) {\n"
+                       "        next = -100 * " + n + ";\n"
+                       "    } else {\n"
+                       "        print \"in range\";\n"
+                       "    }\n"
+                       "    while (next >= 0) { next = next - 1; }\n"
+                       "    return next * (delta + 1);\n"
+                       "}\n"
+                       "update_" + n + "(1, 2, 0.016);\n";
+    }
+    return source_code;
+}
+
+// Best of 5 runs, in milliseconds. step returns the AST it built, which is freed outside the measurement
+template <typename Step>
+static double Measure(Step&& step) {
+    double best_ms = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        ProgramPtr ast = step();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ast == nullptr) {
+            std::cerr << "No AST\n";
+            std::exit(1);
+        }
+        if (run == 0 || ms < best_ms) best_ms = ms;
+    }
+    return best_ms;
+}
+
+static void PrintRow(std::string_view name, double ms, double parse_ms) {
+    std::cout << std::left << std::fixed << std::setprecision(2) << std::setw(28) << name << std::setw(12) << ms
+              << parse_ms / ms << "x\n";
+}
+
+int main() {
+    constexpr size_t SOURCE_SIZE = 10 * 1024 * 1024;
+    const std::string source_code = GenerateScript(SOURCE_SIZE);
+    auto directory = std::filesystem::temp_directory_path() / ("ast_cache_bench_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    ASTCache cache(directory.string());
+
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    std::vector<uint8_t> data = ASTCache::Serialize(*ast, source_code);
+    cache.Store(*ast, source_code);
+    Compiler compiler;
+    Compiler loaded_compiler;
+    if (loaded_compiler.Compile(cache.Load(source_code).get()).GetCode() != compiler.Compile(ast.get()).GetCode()) {
+        std::cerr << "Loaded AST compiles differently\n";
+        return 1;
+    }
+    ast.reset();
+
+    double parse_ms = Measure([&] {
+        Parser parser(source_code);
+        return parser.GenerateAST();
+    });
+    double analyse_ms = Measure([&] {
+        Parser parser(source_code);
+        auto ast = parser.GenerateAST();
+        SemanticAnalyser analyser;
+        ast->accept(analyser);
+        return ast;
+    });
+    double hash_ms = Measure([&] {
+        volatile uint64_t hash = ASTCache::HashSource(source_code);
+        (void)hash;
+        return std::make_unique<Program>(std::make_unique<Arena>());
+    });
+    double deserialize_ms = Measure([&] { return ASTCache::Deserialize(data, source_code); });
+    double load_ms = Measure([&] { return cache.Load(source_code); });
+    std::filesystem::remove_all(directory);
+
+    std::cout << std::fixed << std::setprecision(1) << "Source " << static_cast<double>(source_code.size()) / (1024 * 1024)
+              << " MB, cache " << static_cast<double>(data.size()) / (1024 * 1024) << " MB\n";
+    std::cout << std::left << std::setw(28) << "[STEP]" << std::setw(12) << "[TIME (ms)]" << "[VS PARSE]\n";
+    PrintRow("GenerateAST", parse_ms, parse_ms);
+    PrintRow("GenerateAST + analyse", analyse_ms, parse_ms);
+    PrintRow("HashSource", hash_ms, parse_ms);
+    PrintRow("Deserialize (hash + build)", deserialize_ms, parse_ms);
+    PrintRow("Load (file + hash + build)", load_ms, parse_ms);
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Compares the pointer tree produced by the Parser with the FlatAST lowered from it: memory held by each,
+// how fast a full traversal is (ASTVisitor double dispatch vs switching on the node kind), and how long
+// the SemanticAnalyser and Compiler take on each representation.
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "compiler.h"
+#include "flat_ast.h"
+#include "parser.h"
+#include "pass_manager.h"
+#include "semantic_analyser.h"
+
+static std::string GenerateScript(size_t target_size) {
+    std::string source_code = "fun clamp(value, low, high) { return value; }\n";
+    source_code.reserve(target_size + 512);
+    for (size_t i = 0; source_code.size() < target_size; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun update_" + n + "(position, velocity, delta) {\n"
+                       "    var next = position + velocity * delta - (1.5 * delta) / 2;\n"
+                       "    if (next > 100 == !(velocity == nil)) {\n"
+                       "        next = clamp(next, -100, 100);\n"
+                       "    } else {\n"
+                       "        print \"in range\";\n"
+                       "    }\n"
+                       "    while (next >= 0) { next = next - 1; }\n"
+                       "    return next * (delta + 1);\n"
+                       "}\n"
+                       "update_" + n + "(1, 2, 0.016);\n";
+    }
+    return source_code;
+}
+
+static double PeakRSSMegabytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / 1024; // ru_maxrss is in kilobytes on Linux
+}
+
+// Best of RUNS, in milliseconds
+static double Measure(const std::function<void()>& function) {
+    constexpr int RUNS = 5;
+    double best_ms = 0;
+    for (int run = 0; run < RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || ms < best_ms) best_ms = ms;
+    }
+    return best_ms;
+}
+
+// The same walk as CountASTNodes, but over the FlatAST
+static size_t CountFlatNodes(const FlatAST& ast, NodeIndex index) {
+    const FlatNode& node = ast.GetNode(index);
+    size_t count = 1;
+    switch (node.kind) {
+        case NodeKind::PROGRAM:
+        case NodeKind::BLOCK:
+        case NodeKind::PARAMETERS:
+        case NodeKind::ARGUMENTS:
+            for (NodeIndex child : ast.GetChildren(node)) count += CountFlatNodes(ast, child);
+            return count;
+        case NodeKind::IDENTIFIER:
+        case NodeKind::LITERAL:
+            return count;
+        default:
+            for (NodeIndex child : {node.first, node.second, node.third}) {
+                if (child != NO_NODE) count += CountFlatNodes(ast, child);
+            }
+            return count;
+    }
+}
+
+static void PrintRow(std::string_view name, double tree, double flat) {
+    std::cout << std::left << std::setw(26) << name << std::setw(12) << tree << std::setw(12) << flat
+              << tree / flat << "x\n";
+}
+
+int main() {
+    constexpr size_t SOURCE_SIZE = 16 * 1024 * 1024;
+    const std::string source_code = GenerateScript(SOURCE_SIZE);
+
+    double rss_before = PeakRSSMegabytes();
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    double tree_rss = PeakRSSMegabytes() - rss_before;
+    FlatAST flat_ast = FlatAST::Build(*ast);
+    double flat_rss = PeakRSSMegabytes() - rss_before - tree_rss;
+
+    size_t tree_count = 0;
+    size_t flat_count = 0;
+    size_t literal_count = 0;
+    double tree_walk = Measure([&] { tree_count = CountASTNodes(*ast); });
+    double flat_walk = Measure([&] { flat_count = CountFlatNodes(flat_ast, flat_ast.GetRoot()); });
+    // Children are stored before their parents, so passes that don't need the tree shape can skip the walk
+    double flat_scan = Measure([&] {
+        literal_count = 0;
+        for (const FlatNode& node : flat_ast.GetNodes()) literal_count += node.kind == NodeKind::LITERAL;
+    });
+    if (tree_count != flat_count) {
+        std::cerr << "Node count mismatch: " << tree_count << " vs " << flat_count << "\n";
+        return 1;
+    }
+
+    double tree_analyse = Measure([&] { SemanticAnalyser analyser; ast->accept(analyser); });
+    double flat_analyse = Measure([&] { SemanticAnalyser analyser; analyser.Analyse(flat_ast); });
+    double tree_compile = Measure([&] { Compiler compiler; auto chunk = compiler.Compile(ast.get()); });
+    double flat_compile = Measure([&] { Compiler compiler; auto chunk = compiler.Compile(flat_ast); });
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Source: " << static_cast<double>(source_code.size()) / (1024 * 1024) << " MB, "
+              << tree_count << " nodes, " << literal_count << " literals\n";
+    std::cout << "FlatAST tables: " << static_cast<double>(flat_ast.MemoryUsage()) / (1024 * 1024) << " MB ("
+              << static_cast<double>(flat_ast.MemoryUsage()) / static_cast<double>(flat_count) << " bytes/node)\n\n";
+    std::cout << std::left << std::setw(26) << "" << std::setw(12) << "[TREE]" << std::setw(12) << "[FLAT]"
+              << "[RATIO]\n";
+    PrintRow("RSS growth (MB)", tree_rss, flat_rss);
+    PrintRow("Traversal (ms)", tree_walk, flat_walk);
+    PrintRow("Linear scan (ms)", tree_walk, flat_scan);
+    PrintRow("SemanticAnalyser (ms)", tree_analyse, flat_analyse);
+    PrintRow("Compiler (ms)", tree_compile, flat_compile);
+    return 0;
+}
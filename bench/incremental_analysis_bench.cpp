@@ -0,0 +1,99 @@
+// Measures per-keystroke latency of IncrementalAnalyser on a 50K line file while text is typed into it, one
+// character per edit, and compares it with checking the whole file again (GenerateAST and SemanticAnalyser).
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "incremental_analyser.h"
+#include "parser.h"
+#include "semantic_analyser.h"
+
+static std::string GenerateScript(size_t line_count) {
+    std::string source_code = "var limit = 100;\n";
+    for (size_t i = 0; std::count(source_code.begin(), source_code.end(), '\n') < line_count; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun update_" + n + "(position, velocity, delta) {\n"
+                       "    var next = position + velocity * delta - (1.5 * delta) / " + n + ";\n"
+                       "    if (next > limit == !(velocity == nil)) {\n"
+                       "        next = -limit * " + n + ";\n"
+                       "    } else {\n"
+                       "        print \"in range " + n + "\";\n"
+                       "    }\n"
+                       "    while (next >= 0) { next = next - 1; }\n"
+                       "    return next * (delta + " + n + ");\n"
+                       "}\n"
+                       "var state_" + n + " = update_" + n + "(1, 2, 3);\n";
+    }
+    return source_code;
+}
+
+static double Milliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Types text at offset one character at a time, returns the latency of each keystroke
+static std::vector<double> Type(IncrementalAnalyser& analyser, size_t offset, const std::string& text) {
+    std::vector<double> latencies;
+    for (size_t i = 0; i < text.size(); i++) {
+        auto start = std::chrono::steady_clock::now();
+        analyser.Edit(offset + i, 0, text.substr(i, 1));
+        latencies.push_back(Milliseconds(start));
+    }
+    return latencies;
+}
+
+static void PrintRow(const std::string& name, std::vector<double> latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    double mean = 0;
+    for (double latency : latencies) mean += latency / latencies.size();
+    std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(28) << name << std::setw(12) << mean
+              << std::setw(12) << latencies[latencies.size() / 2] << latencies.back() << "\n";
+}
+
+int main() {
+    const std::string source_code = GenerateScript(50000);
+    std::cout << "Lines: " << std::count(source_code.begin(), source_code.end(), '\n')
+              << ", size: " << source_code.size() / 1024 << " KB\n";
+
+    // Typing goes through states that don't parse, the Parser reports those on std::cerr
+    std::ostringstream parse_errors;
+    auto* old_buffer = std::cerr.rdbuf(parse_errors.rdbuf());
+
+    double full_ms = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        Parser parser(source_code);
+        auto ast = parser.GenerateAST();
+        std::vector<std::string> errors;
+        SemanticAnalyser analyser;
+        analyser.SetDiagnostics(&errors);
+        ast->accept(analyser);
+        double ms = Milliseconds(start);
+        if (run == 0 || ms < full_ms) full_ms = ms;
+    }
+    auto start = std::chrono::steady_clock::now();
+    IncrementalAnalyser analyser(source_code);
+    double initial_ms = Milliseconds(start);
+
+    // Offsets are looked up again after each run of typing, the earlier ones moved the text
+    auto in_body = Type(analyser, analyser.GetSource().find("{", source_code.find("fun update_2500(")) + 1,
+                        "\n    var typed = next * 2 + limit;");
+    auto at_top_level = Type(analyser, analyser.GetSource().find("var state_2500"), "print limit * 3;\n");
+    // Every character changes the function's name, so each keystroke also re-checks its caller
+    auto in_name = Type(analyser, analyser.GetSource().find("(position", source_code.find("fun update_2500(")),
+                        "_renamed");
+    std::cerr.rdbuf(old_buffer);
+
+    std::cout << "Full check (ms): " << std::fixed << std::setprecision(3) << full_ms
+              << ", incremental setup (ms): " << initial_ms << "\n";
+    std::cout << std::left << std::setw(28) << "[KEYSTROKES]" << std::setw(12) << "[MEAN (ms)]" << std::setw(12)
+              << "[P50 (ms)]" << "[MAX (ms)]\n";
+    PrintRow("function body", in_body);
+    PrintRow("top-level statement", at_top_level);
+    PrintRow("function name", in_name);
+    return 0;
+}
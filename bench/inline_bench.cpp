@@ -0,0 +1,70 @@
+// Compares the inliner at different size thresholds on a script made of small helper functions.
+// Reports the time spent in the inliner, the total front-end time (parse + inlining + compile) and the
+// size of the generated bytecode. The VM does not execute calls yet and a call currently compiles to
+// just its arguments, so the bytecode size of calls that were not inlined is understated.
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "compiler.h"
+#include "inliner.h"
+#include "parser.h"
+#include "pass_manager.h"
+
+static std::string GenerateHelperScript(size_t call_sites) {
+    std::string source_code = R"(
+        fun get_rate() { return 0.25; }
+        fun add(a, b) { return a + b; }
+        fun mul(a, b) { return a * b; }
+        fun square(x) { return mul(x, x); }
+        fun lerp(a, b, t) { return add(a, mul(t, b - a)); }
+        fun clamp_low(x, low) { return x * (x > low) + low; }
+        fun tax(price) { return add(price, mul(price, get_rate())); }
+    )";
+    for (size_t i = 0; i < call_sites; i++) {
+        auto n = std::to_string(i % 97);
+        source_code += "tax(" + n + ") + square(" + n + ") - lerp(1, " + n + ", 0.5);\n";
+    }
+    return source_code;
+}
+
+int main() {
+    constexpr size_t CALL_SITES = 5000;
+    constexpr int RUNS = 3;
+    const std::string source_code = GenerateHelperScript(CALL_SITES);
+
+    std::cout << "Helper-heavy script: " << CALL_SITES << " statements, " << source_code.size() << " bytes\n";
+    std::cout << std::left << std::setw(12) << "[THRESHOLD]" << std::setw(12) << "[INLINED]"
+              << std::setw(16) << "[INLINER (ms)]" << std::setw(18) << "[FRONT END (ms)]" << "[BYTECODE (B)]\n";
+
+    for (size_t threshold : {0, 2, 4, 8, 16, 32}) {
+        double best_total_ms = 0;
+        double best_inliner_ms = 0;
+        size_t inlined = 0;
+        size_t bytecode_size = 0;
+        for (int run = 0; run < RUNS; run++) {
+            auto start = std::chrono::steady_clock::now();
+            Parser parser(source_code);
+            auto ast = parser.GenerateAST();
+            PassManager pass_manager(OptLevel::O2);
+            auto inliner = std::make_unique<Inliner>(threshold);
+            Inliner* inliner_ptr = inliner.get();
+            pass_manager.AddASTPass(std::move(inliner), OptLevel::O2);
+            pass_manager.RunASTPasses(*ast);
+            Compiler compiler;
+            Chunk chunk = compiler.Compile(ast.get());
+            double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            double inliner_ms = pass_manager.GetStats()[0].wall_time_ms;
+            if (run == 0 || total_ms < best_total_ms) best_total_ms = total_ms;
+            if (run == 0 || inliner_ms < best_inliner_ms) best_inliner_ms = inliner_ms;
+            inlined = inliner_ptr->GetInlinedCount();
+            bytecode_size = chunk.Size();
+        }
+        std::cout << std::left << std::setw(12) << threshold << std::setw(12) << inlined
+                  << std::setw(16) << std::fixed << std::setprecision(2) << best_inliner_ms
+                  << std::setw(18) << best_total_ms << bytecode_size << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Measures startup (parsing, analysis and compilation) of a script that declares a large library of functions
+// but calls only a few of them, compiling every body up front and compiling bodies lazily on their first call.
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "compiler.h"
+#include "parser.h"
+#include "semantic_analyser.h"
+
+static constexpr size_t CALLED_COUNT = 10;
+
+static std::string GenerateScript(size_t function_count) {
+    std::string source_code;
+    for (size_t i = 0; i < function_count; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun update_" + n + "(position, velocity, delta) {\n"
+                       "    var next = position + velocity * delta - (1.5 * delta) / " + n + ";\n"
+                       "    if (next > 100 == !(velocity == nil)) {\n"
+                       "        next = -100 * " + n + ";\n"
+                       "    } else {\n"
+                       "        print \"in range " + n + "\";\n"
+                       "    }\n"
+                       "    while (next >= 0) { next = next - 1; }\n"
+                       "    return next * (delta + " + n + ");\n"
+                       "}\n";
+    }
+    for (size_t i = 0; i < CALLED_COUNT; i++) {
+        source_code += "var result_" + std::to_string(i) + " = update_" + std::to_string(i * function_count / CALLED_COUNT) + "(1, 2, 3);\n";
+    }
+    return source_code;
+}
+
+// Best of 5 runs, in milliseconds. code_size is the number of bytes of code compiled
+static double Measure(const std::string& source_code, bool lazy, size_t& code_size) {
+    double best_ms = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        Parser parser(source_code);
+        auto ast = parser.GenerateAST();
+        SemanticAnalyser analyser;
+        Compiler compiler;
+        Chunk chunk;
+        if (lazy) {
+            analyser.DeclareGlobals(*ast);
+            chunk = compiler.CompileLazily(ast.get(), analyser);
+        } else {
+            ast->accept(analyser);
+            chunk = compiler.Compile(ast.get());
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || ms < best_ms) best_ms = ms;
+        code_size = chunk.Size();
+        for (const auto& function : compiler.GetFunctions()) code_size += function.Size();
+    }
+    return best_ms;
+}
+
+int main() {
+    std::cout << std::left << std::setw(12) << "[FUNCTIONS]" << std::setw(10) << "[MODE]" << std::setw(12)
+              << "[TIME (ms)]" << std::setw(14) << "[CODE (B)]" << "[SPEEDUP]\n";
+    for (size_t function_count : {1000, 5000, 20000}) {
+        const std::string source_code = GenerateScript(function_count);
+        size_t eager_size = 0;
+        size_t lazy_size = 0;
+        double eager_ms = Measure(source_code, false, eager_size);
+        double lazy_ms = Measure(source_code, true, lazy_size);
+        std::cout << std::left << std::fixed << std::setprecision(2) << std::setw(12) << function_count
+                  << std::setw(10) << "eager" << std::setw(12) << eager_ms << std::setw(14) << eager_size << "1.00x\n"
+                  << std::setw(12) << function_count << std::setw(10) << "lazy" << std::setw(12) << lazy_ms
+                  << std::setw(14) << lazy_size << eager_ms / lazy_ms << "x\n";
+    }
+    return 0;
+}
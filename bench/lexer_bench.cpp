@@ -0,0 +1,133 @@
+// Measures lexing throughput (MB/s) of Lexer::ReadNextToken on large generated sources, and the memory
+// of the tokens when stored as std::vector<Token> compared to TokenBuffer, and the scaling of ParallelLexer.
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lexer.h"
+#include "parallel_lexer.h"
+
+// Code-like source with a typical mix of identifiers, keywords, numbers, strings, operators and comments
+static std::string GenerateCode(size_t target_size) {
+    std::string source_code;
+    source_code.reserve(target_size + 256);
+    for (size_t i = 0; source_code.size() < target_size; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun helper_" + n + "(first_arg, second_arg) {\n"
+                       "    // compute something for entry " + n + "\n"
+                       "    var result_value = first_arg * 3.25 + second_arg / " + n + ";\n"
+                       "    if (result_value >= 100 and !(second_arg == nil)) {\n"
+                       "        print \"large value in helper " + n + "\";\n"
+                       "    } else {\n"
+                       "        result_value = -result_value <= 0 or false;\n"
+                       "    }\n"
+                       "    return result_value != true;\n"
+                       "}\n";
+    }
+    return source_code;
+}
+
+// Almost only identifiers and keywords, so keyword classification dominates
+static std::string GenerateIdentifiers(size_t target_size) {
+    std::string source_code;
+    source_code.reserve(target_size + 256);
+    for (size_t i = 0; source_code.size() < target_size; i++) {
+        auto n = std::to_string(i);
+        source_code += "var alpha_" + n + " = beta and gamma or not_a_keyword;\n"
+                       "if counter while value return fun print true false nil else printer variable\n"
+                       "x y z iffy andrew orbit whilst returned funny nil_value truest falsehood elsewhere\n";
+    }
+    return source_code;
+}
+
+// Mostly whitespace and string literals, like a generated config file
+static std::string GenerateConfig(size_t target_size) {
+    std::string source_code;
+    source_code.reserve(target_size + 256);
+    for (size_t i = 0; source_code.size() < target_size; i++) {
+        auto n = std::to_string(i);
+        source_code += "var config_" + n + " =                    \"/usr/local/share/application/data/" + n + "/settings.json\";\n"
+                       "        \n"
+                       "    // ----------------------------------------------------------------------------\n";
+    }
+    return source_code;
+}
+
+static void Run(const std::string& name, const std::string& source_code) {
+    constexpr int RUNS = 5;
+    double best_seconds = 0;
+    size_t token_count = 0;
+    for (int run = 0; run < RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        Lexer lexer(source_code);
+        size_t count = 0;
+        while (lexer.ReadNextToken().type != TT::END) count++;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || seconds < best_seconds) best_seconds = seconds;
+        token_count = count;
+    }
+    double megabytes = static_cast<double>(source_code.size()) / (1024 * 1024);
+    std::cout << std::left << std::setw(10) << name << std::setw(12) << std::fixed << std::setprecision(1) << megabytes
+              << std::setw(12) << token_count << std::setw(12) << std::setprecision(2) << best_seconds * 1000
+              << std::setprecision(1) << megabytes / best_seconds << "\n";
+}
+
+// Compares the memory of TokenizeAll and TokenizeToBuffer for the same source
+static void RunMemory(const std::string& name, const std::string& source_code) {
+    std::vector<Token> tokens = Lexer(source_code).TokenizeAll();
+    TokenBuffer token_buffer = Lexer(source_code).TokenizeToBuffer();
+    size_t buffer_without_lines = token_buffer.MemoryUsage();
+    (void)token_buffer.GetLine(token_buffer.Size() - 1); // Builds the newline index
+
+    double vector_megabytes = static_cast<double>(tokens.capacity() * sizeof(Token)) / (1024 * 1024);
+    double buffer_megabytes = static_cast<double>(buffer_without_lines) / (1024 * 1024);
+    double buffer_lines_megabytes = static_cast<double>(token_buffer.MemoryUsage()) / (1024 * 1024);
+    std::cout << std::left << std::setw(10) << name << std::fixed << std::setprecision(1)
+              << std::setw(18) << vector_megabytes << std::setw(18) << buffer_megabytes
+              << std::setw(18) << buffer_lines_megabytes << vector_megabytes / buffer_lines_megabytes << "x\n";
+}
+
+// Compares Lexer::TokenizeToBuffer with ParallelLexer for increasing thread counts
+static void RunParallel(const std::string& name, const std::string& source_code) {
+    auto time = [](auto&& tokenize) {
+        double best_seconds = 0;
+        for (int run = 0; run < 3; run++) {
+            auto start = std::chrono::steady_clock::now();
+            tokenize();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (run == 0 || seconds < best_seconds) best_seconds = seconds;
+        }
+        return best_seconds;
+    };
+    double megabytes = static_cast<double>(source_code.size()) / (1024 * 1024);
+    double sequential = time([&] { return Lexer(source_code).TokenizeToBuffer().Size(); });
+    std::cout << std::left << std::setw(10) << name << std::setw(10) << "1 (seq)" << std::fixed << std::setprecision(1)
+              << megabytes / sequential << "\n";
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        double seconds = time([&] { return ParallelLexer(source_code, threads).TokenizeAll().Size(); });
+        std::cout << std::left << std::setw(10) << name << std::setw(10) << threads << megabytes / seconds << "\n";
+    }
+}
+
+int main() {
+    constexpr size_t SOURCE_SIZE = 32 * 1024 * 1024;
+    std::cout << std::left << std::setw(10) << "[SOURCE]" << std::setw(12) << "[SIZE (MB)]" << std::setw(12) << "[TOKENS]"
+              << std::setw(12) << "[TIME (ms)]" << "[MB/s]\n";
+    Run("code", GenerateCode(SOURCE_SIZE));
+    Run("idents", GenerateIdentifiers(SOURCE_SIZE));
+    Run("config", GenerateConfig(SOURCE_SIZE));
+
+    std::cout << "\n" << std::left << std::setw(10) << "[SOURCE]" << std::setw(18) << "[VECTOR (MB)]"
+              << std::setw(18) << "[BUFFER (MB)]" << std::setw(18) << "[+LINES (MB)]" << "[REDUCTION]\n";
+    RunMemory("code", GenerateCode(SOURCE_SIZE));
+    RunMemory("idents", GenerateIdentifiers(SOURCE_SIZE));
+    RunMemory("config", GenerateConfig(SOURCE_SIZE));
+
+    std::cout << "\n" << std::left << std::setw(10) << "[SOURCE]" << std::setw(10) << "[THREADS]" << "[MB/s]\n";
+    RunParallel("code", GenerateCode(4 * SOURCE_SIZE));
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Measures semantic analysis of scripts made of thousands of functions, serially and with the function bodies
+// analysed on several threads, and checks that both report the same number of errors.
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "parser.h"
+#include "semantic_analyser.h"
+
+static std::string GenerateLibrary(size_t function_count) {
+    std::string source_code;
+    for (size_t i = 0; i < function_count; i++) {
+        auto n = std::to_string(i);
+        source_code += "var scale_" + n + " = " + n + ";\n"
+                       "fun update_" + n + "(position, velocity, delta) {\n"
+                       "    var next = position + velocity * delta - (1.5 * delta) / scale_" + n + ";\n"
+                       "    if (next > 100 == !(velocity == nil)) {\n"
+                       "        var clamped = -100 * scale_" + n + ";\n"
+                       "        next = clamped;\n"
+                       "    } else {\n"
+                       "        print update_" + n + "(next, velocity, delta);\n"
+                       "    }\n"
+                       "    while (next >= 0) { var step = 1; next = next - step; }\n"
+                       "    return next * (delta + scale_" + n + ");\n"
+                       "}\n";
+    }
+    return source_code;
+}
+
+// Best of 5 runs, in milliseconds
+static double Measure(Program& program, size_t thread_count, size_t& error_count) {
+    double best_ms = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        SemanticAnalyser analyser;
+        analyser.Analyse(program, thread_count);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || ms < best_ms) best_ms = ms;
+        error_count = analyser.GetErrorCount();
+    }
+    return best_ms;
+}
+
+int main() {
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << std::left << std::setw(12) << "[FUNCTIONS]" << std::setw(12) << "[THREADS]" << std::setw(12)
+              << "[TIME (ms)]" << "[SPEEDUP]\n";
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (size_t function_count : {1000, 5000, 20000}) {
+        const std::string source_code = GenerateLibrary(function_count);
+        Parser parser(source_code);
+        auto ast = parser.GenerateAST();
+
+        size_t serial_errors = 0;
+        double serial_ms = Measure(*ast, 1, serial_errors);
+        std::cout << std::left << std::fixed << std::setprecision(2) << std::setw(12) << function_count
+                  << std::setw(12) << "serial" << std::setw(12) << serial_ms << "1.00x\n";
+        for (size_t thread_count = 2; thread_count <= max_threads; thread_count *= 2) {
+            size_t errors = 0;
+            double ms = Measure(*ast, thread_count, errors);
+            if (errors != serial_errors) {
+                std::cerr << "Error count differs from the serial analysis with " << thread_count << " threads\n";
+                return 1;
+            }
+            std::cout << std::left << std::setw(12) << function_count << std::setw(12) << thread_count
+                      << std::setw(12) << ms << serial_ms / ms << "x\n";
+        }
+    }
+    return 0;
+}
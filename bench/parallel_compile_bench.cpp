@@ -0,0 +1,70 @@
+// Measures Compiler::Compile on scripts made of thousands of functions, serially and with the function bodies
+// compiled on several threads, and checks that both produce the same bytecode.
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "compiler.h"
+#include "parser.h"
+
+static std::string GenerateLibrary(size_t function_count) {
+    std::string source_code;
+    for (size_t i = 0; i < function_count; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun update_" + n + "(position, velocity, delta) {\n"
+                       "    var next = position + velocity * delta - (1.5 * delta) / " + n + ";\n"
+                       "    if (next > 100 == !(velocity == nil)) {\n"
+                       "        next = -100 * " + n + ";\n"
+                       "    } else {\n"
+                       "        print \"in range " + n + "\";\n"
+                       "    }\n"
+                       "    while (next >= 0) { next = next - 1; }\n"
+                       "    return next * (delta + " + n + ");\n"
+                       "}\n";
+    }
+    return source_code;
+}
+
+// Best of 5 runs, in milliseconds
+static double Measure(Program* program, size_t thread_count, Chunk& chunk) {
+    double best_ms = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        Compiler compiler;
+        chunk = thread_count == 0 ? compiler.Compile(program) : compiler.Compile(program, thread_count);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || ms < best_ms) best_ms = ms;
+    }
+    return best_ms;
+}
+
+int main() {
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << std::left << std::setw(12) << "[FUNCTIONS]" << std::setw(12) << "[THREADS]" << std::setw(12)
+              << "[TIME (ms)]" << "[SPEEDUP]\n";
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (size_t function_count : {1000, 5000, 20000}) {
+        const std::string source_code = GenerateLibrary(function_count);
+        Parser parser(source_code);
+        auto ast = parser.GenerateAST();
+
+        Chunk serial_chunk;
+        double serial_ms = Measure(ast.get(), 0, serial_chunk);
+        std::cout << std::left << std::fixed << std::setprecision(2) << std::setw(12) << function_count
+                  << std::setw(12) << "serial" << std::setw(12) << serial_ms << "1.00x\n";
+        for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+            Chunk chunk;
+            double ms = Measure(ast.get(), thread_count, chunk);
+            if (chunk.GetCode() != serial_chunk.GetCode() || chunk.GetConstants().size() != serial_chunk.GetConstants().size()) {
+                std::cerr << "Bytecode differs from the serial build with " << thread_count << " threads\n";
+                return 1;
+            }
+            std::cout << std::left << std::setw(12) << function_count << std::setw(12) << thread_count
+                      << std::setw(12) << ms << serial_ms / ms << "x\n";
+        }
+    }
+    return 0;
+}
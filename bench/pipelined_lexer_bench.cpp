@@ -0,0 +1,59 @@
+// Measures front-end throughput (MB/s of source turned into an AST by Parser::GenerateAST) with the lexer
+// running inline in the parser and with it running on its own thread through PipelinedLexer.
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "parser.h"
+
+static std::string GenerateCode(size_t target_size) {
+    std::string source_code;
+    source_code.reserve(target_size + 256);
+    for (size_t i = 0; source_code.size() < target_size; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun helper_" + n + "(first_arg, second_arg) {\n"
+                       "    // compute something for entry " + n + "\n"
+                       "    var result_value = first_arg * 3.25 + second_arg / " + n + ";\n"
+                       "    if (result_value >= 100 and !(second_arg == nil)) {\n"
+                       "        print \"large value in helper " + n + "\";\n"
+                       "    } else {\n"
+                       "        result_value = -result_value <= 0 or false;\n"
+                       "    }\n"
+                       "    return result_value != true;\n"
+                       "}\n";
+    }
+    return source_code;
+}
+
+// Best of 5 runs, in seconds
+static double Measure(const std::string& source_code, bool pipelined) {
+    double best_seconds = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            Parser parser(source_code, pipelined);
+            auto ast = parser.GenerateAST();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || seconds < best_seconds) best_seconds = seconds;
+    }
+    return best_seconds;
+}
+
+int main() {
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << std::left << std::setw(12) << "[SIZE (MB)]" << std::setw(16) << "[INLINE (MB/s)]"
+              << std::setw(20) << "[PIPELINED (MB/s)]" << "[SPEEDUP]\n";
+    for (size_t size_mb : {1, 8, 32, 64}) {
+        const std::string source_code = GenerateCode(size_mb * 1024 * 1024);
+        double megabytes = static_cast<double>(source_code.size()) / (1024 * 1024);
+        double inline_seconds = Measure(source_code, false);
+        double pipelined_seconds = Measure(source_code, true);
+        std::cout << std::left << std::fixed << std::setprecision(1) << std::setw(12) << megabytes
+                  << std::setw(16) << megabytes / inline_seconds << std::setw(20) << megabytes / pipelined_seconds
+                  << std::setprecision(2) << inline_seconds / pipelined_seconds << "x\n";
+    }
+    return 0;
+}
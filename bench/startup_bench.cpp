@@ -0,0 +1,78 @@
+// Measures the time from source text to a finished chunk for short scripts, once through the AST
+// (GenerateAST, SemanticAnalyser, Compiler, no passes) and once through the single-pass Parser::GenerateChunk.
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "compiler.h"
+#include "parser.h"
+#include "semantic_analyser.h"
+
+static std::string GenerateScript(size_t target_size) {
+    std::string source_code = "fun clamp(value, low, high) { return value; }\n";
+    for (size_t i = 0; source_code.size() < target_size; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun update_" + n + "(position, velocity, delta) {\n"
+                       "    var next = position + velocity * delta - (1.5 * delta) / 2;\n"
+                       "    if (next > 100 == !(velocity == nil)) {\n"
+                       "        next = clamp(next, -100, 100);\n"
+                       "    } else {\n"
+                       "        print \"in range\";\n"
+                       "    }\n"
+                       "    while (next >= 0) { next = next - 1; }\n"
+                       "    return next * (delta + 1);\n"
+                       "}\n"
+                       "update_" + n + "(1, 2, 0.016);\n";
+    }
+    return source_code;
+}
+
+// Median of as many runs as fit in roughly 200ms, in microseconds
+static double Measure(const std::function<size_t()>& function, size_t& code_size) {
+    std::vector<double> samples;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while (samples.size() < 20 || (std::chrono::steady_clock::now() < deadline && samples.size() < 10000)) {
+        auto start = std::chrono::steady_clock::now();
+        code_size = function();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+int main() {
+    std::cout << std::left << std::setw(12) << "[SIZE (KB)]" << std::setw(12) << "[LINES]" << std::setw(14)
+              << "[AST (us)]" << std::setw(20) << "[SINGLE PASS (us)]" << "[SPEEDUP]\n";
+    for (size_t size_kb : {1, 4, 16, 64, 100}) {
+        const std::string source_code = GenerateScript(size_kb * 1024);
+        size_t tree_code_size = 0;
+        size_t single_pass_code_size = 0;
+        double tree_us = Measure([&] {
+            Parser parser(source_code);
+            auto ast = parser.GenerateAST();
+            SemanticAnalyser analyser;
+            ast->accept(analyser);
+            Compiler compiler;
+            return compiler.Compile(ast.get()).Size();
+        }, tree_code_size);
+        double single_pass_us = Measure([&] {
+            Parser parser(source_code);
+            SemanticAnalyser analyser;
+            return parser.GenerateChunk(analyser).Size();
+        }, single_pass_code_size);
+        if (tree_code_size != single_pass_code_size) {
+            std::cerr << "Chunk size mismatch: " << tree_code_size << " vs " << single_pass_code_size << "\n";
+            return 1;
+        }
+
+        std::cout << std::left << std::fixed << std::setprecision(1) << std::setw(12)
+                  << static_cast<double>(source_code.size()) / 1024 << std::setw(12)
+                  << std::count(source_code.begin(), source_code.end(), '\n') << std::setw(14) << tree_us
+                  << std::setw(20) << single_pass_us << std::setprecision(2) << tree_us / single_pass_us << "x\n";
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+// Bump allocator for objects that all die together, like the nodes of one AST. Objects are never destroyed
+// individually, freeing the Arena releases all of its blocks at once. Everything allocated from it has to
+// either be trivially destructible or only own memory that also comes from the Arena (std::pmr containers
+// constructed with GetResource()).
+class Arena {
+public:
+    explicit Arena(size_t initial_size = 4096)
+        : resource_(initial_size) {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    template <typename T, typename... Args>
+    T* Make(Args&&... args) {
+        void* memory = resource_.allocate(sizeof(T), alignof(T));
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    [[nodiscard]] std::pmr::memory_resource* GetResource() { return &resource_; }
+private:
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+#endif //ARENA_H
@@ -4,9 +4,12 @@
 #include <utility>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <type_traits>
 #include <variant>
 
+#include "arena.h"
 #include "value.h"
 #include "lexer.h"
 
@@ -33,31 +36,33 @@ class Literal;
 class Parameters;
 class Arguments;
 
-using ASTNodePtr = std::unique_ptr<ASTNode>;
+// Nodes are allocated from the Arena owned by their Program, so everything except the Program itself is
+// referenced through plain non-owning pointers and freed all at once together with the Program.
+using ASTNodePtr = ASTNode*;
 using ProgramPtr = std::unique_ptr<Program>;
-using DeclarationPtr = std::unique_ptr<Declaration>; // Abstract class
-using FunDeclPtr = std::unique_ptr<FunDecl>;
-using VarDeclPtr = std::unique_ptr<VarDecl>;
-using StatementPtr = std::unique_ptr<Statement>; // Abstract class
-using ExprStmtPtr = std::unique_ptr<ExprStmt>;
-using IfStmtPtr = std::unique_ptr<IfStmt>;
-using PrintStmtPtr = std::unique_ptr<PrintStmt>;
-using ReturnStmtPtr = std::unique_ptr<ReturnStmt>;
-using WhileStmtPtr = std::unique_ptr<WhileStmt>;
-using BlockPtr = std::unique_ptr<Block>;
-using ExpressionPtr = std::unique_ptr<Expression>; // Abstract class
-using AssignmentPtr = std::unique_ptr<Assignment>;
-using BinaryPtr = std::unique_ptr<Binary>;
-using UnaryPtr = std::unique_ptr<Unary>;
-using CallPtr = std::unique_ptr<Call>;
-using IdentifierPtr = std::unique_ptr<Identifier>;
-using LiteralPtr = std::unique_ptr<Literal>;
-using ParametersPtr = std::unique_ptr<Parameters>;
-using ArgumentsPtr = std::unique_ptr<Arguments>;
-
+using DeclarationPtr = Declaration*; // Abstract class
+using FunDeclPtr = FunDecl*;
+using VarDeclPtr = VarDecl*;
+using StatementPtr = Statement*; // Abstract class
+using ExprStmtPtr = ExprStmt*;
+using IfStmtPtr = IfStmt*;
+using PrintStmtPtr = PrintStmt*;
+using ReturnStmtPtr = ReturnStmt*;
+using WhileStmtPtr = WhileStmt*;
+using BlockPtr = Block*;
+using ExpressionPtr = Expression*; // Abstract class
+using AssignmentPtr = Assignment*;
+using BinaryPtr = Binary*;
+using UnaryPtr = Unary*;
+using CallPtr = Call*;
+using IdentifierPtr = Identifier*;
+using LiteralPtr = Literal*;
+using ParametersPtr = Parameters*;
+using ArgumentsPtr = Arguments*;
+
+// No virtual destructor, nodes are never deleted (see Arena)
 class ASTNode {
 public:
-    virtual ~ASTNode() = default;
     virtual void accept(ASTVisitor &visitor) = 0;
 };
 
@@ -83,16 +88,17 @@ public:
     virtual void visit(Arguments &node) = 0;
 };
 
+// The root of the AST, owns the Arena all other nodes are allocated from
 class Program : public ASTNode {
 public:
-    std::vector<DeclarationPtr> declarations;
+    explicit Program(std::unique_ptr<Arena> arena)
+        : arena(std::move(arena)), declarations(this->arena->GetResource()) {}
+    std::unique_ptr<Arena> arena; // Declared first, so it is destroyed last
+    std::pmr::vector<DeclarationPtr> declarations;
     void accept(ASTVisitor &visitor) override;
 };
 
-class Declaration : public ASTNode {
-public:
-    virtual ~Declaration() = default;
-};
+class Declaration : public ASTNode {};
 
 class FunDecl : public Declaration {
 public:
@@ -109,10 +115,7 @@ public:
     void accept(ASTVisitor &visitor) override;
 };
 
-class Statement : public Declaration {
-public:
-    virtual ~Statement() = default;
-};
+class Statement : public Declaration {};
 
 class ExprStmt : public Statement {
 public:
@@ -149,14 +152,13 @@ public:
 
 class Block : public Statement {
 public:
-    std::vector<DeclarationPtr> declarations;
+    explicit Block(Arena& arena)
+        : declarations(arena.GetResource()) {}
+    std::pmr::vector<DeclarationPtr> declarations;
     void accept(ASTVisitor &visitor) override;
 };
 
-class Expression : public ASTNode {
-public:
-    virtual ~Expression() = default;
-};
+class Expression : public ASTNode {};
 
 class Assignment : public Expression {
 public:
@@ -189,7 +191,8 @@ public:
 
 class Identifier : public Expression {
 public:
-    std::string_view name;
+    std::string_view name;         // Only used for error messages and debug output
+    SymbolId symbol = NO_SYMBOL;   // Used for every comparison and lookup
     void accept(ASTVisitor &visitor) override;
 };
 
@@ -202,13 +205,17 @@ public:
 
 class Parameters : public ASTNode {
 public:
-    std::vector<IdentifierPtr> identifiers;
+    explicit Parameters(Arena& arena)
+        : identifiers(arena.GetResource()) {}
+    std::pmr::vector<IdentifierPtr> identifiers;
     void accept(ASTVisitor &visitor) override;
 };
 
 class Arguments : public ASTNode {
 public:
-    std::vector<ExpressionPtr> expressions;
+    explicit Arguments(Arena& arena)
+        : expressions(arena.GetResource()) {}
+    std::pmr::vector<ExpressionPtr> expressions;
     void accept(ASTVisitor &visitor) override;
 };
 
@@ -230,4 +237,13 @@ inline void Literal::accept(ASTVisitor &visitor) { visitor.visit(*this); }
 inline void Parameters::accept(ASTVisitor &visitor) { visitor.visit(*this); }
 inline void Arguments::accept(ASTVisitor &visitor) { visitor.visit(*this); }
 
+// Destructors of nodes never run, so apart from the arena backed vectors they must not own anything
+static_assert(std::is_trivially_destructible_v<FunDecl> && std::is_trivially_destructible_v<VarDecl> &&
+              std::is_trivially_destructible_v<ExprStmt> && std::is_trivially_destructible_v<IfStmt> &&
+              std::is_trivially_destructible_v<PrintStmt> && std::is_trivially_destructible_v<ReturnStmt> &&
+              std::is_trivially_destructible_v<WhileStmt> && std::is_trivially_destructible_v<Assignment> &&
+              std::is_trivially_destructible_v<Binary> && std::is_trivially_destructible_v<Unary> &&
+              std::is_trivially_destructible_v<Call> && std::is_trivially_destructible_v<Identifier> &&
+              std::is_trivially_destructible_v<Literal>);
+
 #endif //AST_H
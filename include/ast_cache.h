@@ -0,0 +1,40 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+
+// Saves the AST of a script that parsed and analysed without errors, so that running the same script again
+// can skip lexing, parsing and semantic analysis. The cache is keyed by a hash of the source code, and the
+// loaded AST points into that source exactly like one from Parser::GenerateAST: names and string literals
+// are views into it and SymbolIds are the ones the Lexer handed out.
+//
+// The format is the FlatAST order written out: every node is one byte (its kind and which of its children
+// are present) followed by a short payload, children before their parent. Loading rebuilds the tree in a
+// single loop over those bytes with a stack of finished nodes, without tokenizing or recursing.
+class ASTCache {
+public:
+    explicit ASTCache(std::string directory); // The directory has to exist
+
+    // The cached AST of source_code, or nullptr if there is none, or it is from another format version or
+    // truncated
+    [[nodiscard]] ProgramPtr Load(std::string_view source_code) const;
+    // Only store programs without parse or semantic errors, Load trusts whatever it finds. Returns false if
+    // the file couldn't be written, the cache is only an optimisation so this is not an error
+    bool Store(Program& program, std::string_view source_code) const;
+    [[nodiscard]] std::string GetPath(std::string_view source_code) const;
+
+    static uint64_t HashSource(std::string_view source_code);
+    static std::vector<uint8_t> Serialize(Program& program, std::string_view source_code);
+    // nullptr unless data is a complete cache of exactly this source_code
+    static ProgramPtr Deserialize(std::span<const uint8_t> data, std::string_view source_code);
+private:
+    std::string directory_;
+};
+
+#endif //AST_CACHE_H
@@ -0,0 +1,54 @@
+#ifndef AST_WALK_H
+#define AST_WALK_H
+
+#include <vector>
+
+#include "ast.h"
+
+// Machine generated code can nest expressions millions of levels deep, so nothing walks expressions by
+// recursing on the C++ stack. These helpers keep the path to the current expression on an explicit stack
+// instead. Statements still nest through recursion, they can't get deep without also getting long.
+
+// Appends the slots of expression's operands in evaluation order: both sides of a Binary, the operand of a
+// Unary, the value of an Assignment and the arguments of a Call. The variable of an Assignment and the callee
+// of a Call are names, not operands, so they are not included.
+void AppendOperands(Expression& expression, std::vector<ExpressionPtr*>& operands);
+
+// Calls on_exit(slot) for root and every expression below it, operands before the expressions that use them
+// (the order they are evaluated and compiled in). slot is the pointer that refers to the expression, so
+// on_exit may replace the expression, after its operands have been handled. Null expressions are skipped.
+template <typename OnExit>
+void WalkExpression(ExpressionPtr& root, OnExit&& on_exit) {
+    struct Frame {
+        ExpressionPtr* slot;
+        bool expanded;
+    };
+    std::vector<Frame> stack = {{&root, false}};
+    std::vector<ExpressionPtr*> operands;
+    while (!stack.empty()) {
+        Frame frame = stack.back();
+        if (frame.expanded || *frame.slot == nullptr) {
+            stack.pop_back();
+            if (*frame.slot != nullptr) on_exit(*frame.slot);
+            continue;
+        }
+        stack.back().expanded = true;
+        operands.clear();
+        AppendOperands(**frame.slot, operands);
+        // Pushed in reverse, so the first operand is handled first
+        for (auto it = operands.rbegin(); it != operands.rend(); ++it) stack.push_back({*it, false});
+    }
+}
+
+// Same order as WalkExpression, for walks that only read
+template <typename OnExit>
+void WalkExpression(const Expression* root, OnExit&& on_exit) {
+    auto slot = const_cast<ExpressionPtr>(root);
+    WalkExpression(slot, [&](ExpressionPtr& expression) { on_exit(static_cast<const Expression*>(expression)); });
+}
+
+// Calls accept(visitor) on root and every expression below it in the order of WalkExpression. Visitors that
+// use this only handle the expression itself in their visit functions and leave the operands to the walk.
+void VisitExpression(ExpressionPtr root, ASTVisitor& visitor);
+
+#endif //AST_WALK_H
@@ -1,59 +1,43 @@
 #ifndef CHUNK_H
 #define CHUNK_H
 
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
 #include "ast.h"
-
-enum class OpCode {
-    CONSTANT,
-    ADD,
-    SUBTRACT,
-    MULTIPLY,
-    DIVIDE,
-    POP,
-    NEGATE,
-    NOT,
-    EQUAL,
-    GREATER,
-    LESS,
-    JUMP,
-    JUMP_IF_FALSE,
-};
-
-using OP = OpCode;
-
-struct OpDefinition {
-    std::string name;
-    size_t operand_count;
-};
-
-const inline std::unordered_map<OP, OpDefinition> OP_DEFINITIONS = {
-    {OP::CONSTANT, {"CONSTANT", 1}},
-    {OP::ADD, {"ADD", 0}},
-    {OP::SUBTRACT, {"SUBTRACT", 0}},
-    {OP::MULTIPLY, {"MULTIPLY", 0}},
-    {OP::DIVIDE, {"DIVIDE", 0}},
-    {OP::POP, {"POP", 0}},
-    {OP::NEGATE, {"NEGATE", 0}},
-    {OP::NOT, {"NOT", 0}},
-    {OP::EQUAL, {"EQUAL", 0}},
-    {OP::GREATER, {"GREATER", 0}},
-    {OP::LESS, {"LESS", 0}},
-    {OP::JUMP, {"JUMP", 2}},
-    {OP::JUMP_IF_FALSE, {"JUMP_IF_FALSE", 2}},
-};
+#include "opcodes.h"
 
 class Chunk {
 public:
+    static constexpr uint32_t MAX_CONSTANTS = 1 << 24; // CONSTANT_LONG has a 24 bit operand
+
     void Write(uint8_t byte);
-    uint8_t AddConstant(Value constant);
+    void Append(const std::vector<uint8_t>& code); // Writes all of code at once
+    void Patch(size_t offset, uint8_t byte); // Overwrites an already written byte, used for jump offsets
+    void ReplaceCode(std::vector<uint8_t> code); // Used by bytecode passes, keeps the constants
+    uint32_t AddConstant(Value constant); // Returns the index of an equal constant if there already is one
     [[nodiscard]] const std::vector<uint8_t>& GetCode() const; // for debug printing
     [[nodiscard]] const std::vector<Value>& GetConstants() const;
     [[nodiscard]] size_t Size() const;
+    [[nodiscard]] size_t InstructionCount() const; // Number of opcodes, excluding operands
+
+    // Set by the Verifier. Modifying the code resets it, since the chunk then has to be verified again
+    void SetMaxStackDepth(size_t max_stack_depth);
+    [[nodiscard]] std::optional<size_t> GetMaxStackDepth() const;
 private:
+    // Constants are deduplicated by value. Doubles are compared by their bits, so that 0 and -0 stay apart
+    struct ConstantHash {
+        size_t operator()(const Value& value) const;
+    };
+    struct ConstantEqual {
+        bool operator()(const Value& lhs, const Value& rhs) const;
+    };
+
     std::vector<uint8_t> code_;
     std::vector<Value> constants_;
+    std::unordered_map<Value, uint32_t, ConstantHash, ConstantEqual> constant_indices_;
+    std::optional<size_t> max_stack_depth_;
 };
 
 #endif //CHUNK_H
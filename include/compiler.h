@@ -1,6 +1,10 @@
 #ifndef COMPILER_H
 #define COMPILER_H
 
+#include <unordered_map>
+#include <vector>
+
+#include "flat_ast.h"
 #include "parser.h"
 #include "semantic_analyser.h"
 #include "chunk.h"
@@ -8,6 +12,15 @@
 class Compiler : public ASTVisitor {
 public:
     Chunk Compile(Program* program);
+    // Compiles the bodies of top-level functions on thread_count threads, then joins everything in source
+    // order. Produces exactly the same chunk as Compile(program)
+    Chunk Compile(Program* program, size_t thread_count);
+    // Leaves the bodies of top-level functions out, their declarations only add a stub to the function table.
+    // The first call to a function has analyser.AnalyseFunction check its body and compiles it into its own
+    // chunk, and the calls in that body are followed in turn. Expects analyser.DeclareGlobals(*program)
+    Chunk CompileLazily(Program* program, SemanticAnalyser& analyser);
+    [[nodiscard]] const std::vector<Chunk>& GetFunctions() const; // Compiled by CompileLazily, in order of first call
+    Chunk Compile(const FlatAST& ast); // Emits the same code as compiling the tree the FlatAST was built from
     void visit(Program &node) override;
     void visit(FunDecl &node) override;
     void visit(VarDecl &node) override;
@@ -25,12 +38,34 @@ public:
     void visit(Literal &node) override;
     void visit(Parameters &node) override;
     void visit(Arguments &node) override;
-private:
+
+    // Used by the visitors above, and directly by the single-pass Parser::GenerateChunk
+    Chunk TakeChunk(); // Returns everything emitted so far and starts over with an empty chunk
     void Emit(OpCode op_code);
+    void EmitBinary(TokenType op);
+    void EmitUnary(TokenType op);
     uint32_t EmitJump(OpCode jump_type);
+    void PatchJump(uint32_t jump_end); // Makes the jump ending at jump_end land on the next emitted instruction
     void EmitWithOperand(OpCode op_code, uint8_t operand);
+    void EmitConstant(Value value); // Uses CONSTANT_LONG once the index doesn't fit in one byte
+    // Emits the code of a chunk compiled by another Compiler as if it had been compiled here. Its constants
+    // are added to this chunk, and jumps are adjusted where constant instructions change width
+    void EmitChunk(const Chunk& chunk);
 private:
+    void EmitConstantIndex(uint32_t index);
+    void CompileNode(const FlatAST& ast, NodeIndex index);
+    void CompileExpression(const FlatAST& ast, NodeIndex index); // Skips NO_NODE
+private:
+    struct LazyFunction {
+        FunDecl* declaration;
+        bool called;
+    };
+
     Chunk cur_chunk_;
+    bool lazy_ = false; // Set while CompileLazily runs
+    std::unordered_map<SymbolId, LazyFunction> lazy_functions_;
+    std::vector<FunDecl*> called_functions_; // Bodies to compile, in order of first call
+    std::vector<Chunk> functions_;
 };
 
 #endif //COMPILER_H
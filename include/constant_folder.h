@@ -0,0 +1,41 @@
+#ifndef CONSTANT_FOLDER_H
+#define CONSTANT_FOLDER_H
+
+#include <optional>
+
+#include "pass_manager.h"
+
+// Replaces operators whose operands are all literals with the resulting literal,
+// e.g. 1 + 2 * 3 becomes 7. Operations that would fail at runtime (like dividing by 0 or adding a
+// string to a number) are left alone so that the VM still reports them, and so are operators the Compiler
+// can't emit (and, or), which have to fail the same way at every -O level.
+class ConstantFolder : public ASTPass, private ASTVisitor {
+public:
+    [[nodiscard]] std::string_view Name() const override;
+    void Run(Program& program) override;
+private:
+    void visit(Program &node) override;
+    void visit(FunDecl &node) override;
+    void visit(VarDecl &node) override;
+    void visit(ExprStmt &node) override;
+    void visit(IfStmt &node) override;
+    void visit(PrintStmt &node) override;
+    void visit(ReturnStmt &node) override;
+    void visit(WhileStmt &node) override;
+    void visit(Block &node) override;
+    void visit(Assignment &node) override;
+    void visit(Binary &node) override;
+    void visit(Unary &node) override;
+    void visit(Call &node) override;
+    void visit(Identifier &node) override;
+    void visit(Literal &node) override;
+    void visit(Parameters &node) override;
+    void visit(Arguments &node) override;
+
+    void Fold(ExpressionPtr& expression); // Folds expression bottom up, replacing it in place
+    static void FoldOperation(ExpressionPtr& expression); // Folds one operator whose operands are already folded
+    static std::optional<Value> FoldBinary(TokenType op, const Value& left, const Value& right);
+    static std::optional<Value> FoldUnary(TokenType op, const Value& value);
+};
+
+#endif //CONSTANT_FOLDER_H
@@ -7,6 +7,7 @@
 #include "lexer.h"
 #include "ast.h"
 #include "chunk.h"
+#include "pass_manager.h"
 
 namespace Debug {
     class ASTStringVisitor : public ASTVisitor {
@@ -43,6 +44,7 @@ namespace Debug {
     std::string GetASTString(ASTNode* head);
     std::string GetExpressionStr(const Expression* expression);
     std::string VariantToString(Value val);
+    std::string GetPassStatsStr(const std::vector<PassStats>& stats);
 }
 
 // Used for printing TokenTypes in unit tests
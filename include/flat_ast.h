@@ -0,0 +1,133 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+
+using NodeIndex = uint32_t;
+constexpr NodeIndex NO_NODE = UINT32_MAX;
+
+// One kind per concrete ASTNode class
+enum class NodeKind : uint8_t {
+    PROGRAM,
+    FUN_DECL,
+    VAR_DECL,
+    EXPR_STMT,
+    IF_STMT,
+    PRINT_STMT,
+    RETURN_STMT,
+    WHILE_STMT,
+    BLOCK,
+    ASSIGNMENT,
+    BINARY,
+    UNARY,
+    CALL,
+    IDENTIFIER,
+    LITERAL,
+    PARAMETERS,
+    ARGUMENTS,
+};
+
+// What first/second/third hold depends on the kind, unused fields are NO_NODE:
+//   PROGRAM, BLOCK, PARAMETERS, ARGUMENTS  first = start in the child list, second = child count
+//   FUN_DECL                               name, parameters (or NO_NODE), body
+//   VAR_DECL, ASSIGNMENT                   variable, expression
+//   EXPR_STMT, PRINT_STMT, RETURN_STMT     expression
+//   IF_STMT                                condition, if body, else body (or NO_NODE)
+//   WHILE_STMT                             condition, body
+//   BINARY                                 left, right (op holds the operator)
+//   UNARY                                  expression (op holds the operator)
+//   CALL                                   callee, arguments (or NO_NODE)
+//   IDENTIFIER                             symbol, index of the name
+//   LITERAL                                index of the value
+struct FlatNode {
+    NodeKind kind;
+    TokenType op = TT::END;
+    uint32_t first = NO_NODE;
+    uint32_t second = NO_NODE;
+    uint32_t third = NO_NODE;
+};
+static_assert(sizeof(FlatNode) == 16);
+
+// The AST stored contiguously: nodes refer to their children by 32 bit index instead of by pointer and are
+// traversed by switching on their kind instead of through an ASTVisitor. Children are always stored before
+// their parent, so the root is the last node. Literal values, identifier names and the children of list
+// nodes live in side tables, which keeps every node the same size.
+class FlatAST {
+public:
+    static FlatAST Build(Program& program); // Lowers a tree produced by Parser::GenerateAST
+
+    [[nodiscard]] NodeIndex GetRoot() const { return static_cast<NodeIndex>(nodes_.size() - 1); }
+    [[nodiscard]] const FlatNode& GetNode(NodeIndex index) const { return nodes_[index]; }
+    [[nodiscard]] const std::vector<FlatNode>& GetNodes() const { return nodes_; }
+    [[nodiscard]] size_t Size() const { return nodes_.size(); }
+
+    // Only valid for nodes of the matching kind (see FlatNode)
+    [[nodiscard]] std::span<const NodeIndex> GetChildren(const FlatNode& node) const {
+        return {children_.data() + node.first, node.second};
+    }
+    [[nodiscard]] const Value& GetValue(const FlatNode& node) const { return values_[node.first]; }
+    [[nodiscard]] SymbolId GetSymbol(const FlatNode& node) const { return node.first; }
+    [[nodiscard]] std::string_view GetName(const FlatNode& node) const { return names_[node.second]; }
+
+    [[nodiscard]] size_t MemoryUsage() const; // Bytes held by all tables
+
+    // Calls on_exit(index) for root and every expression below it without recursing, operands first. Visits
+    // the same expressions in the same order as WalkExpression in ast_walk.h does on the tree
+    template <typename OnExit>
+    void WalkExpression(NodeIndex root, OnExit&& on_exit) const;
+private:
+    friend class FlatASTBuilder;
+
+    std::vector<FlatNode> nodes_;
+    std::vector<NodeIndex> children_;
+    std::vector<Value> values_;
+    std::vector<std::string_view> names_;
+};
+
+template <typename OnExit>
+void FlatAST::WalkExpression(NodeIndex root, OnExit&& on_exit) const {
+    struct Frame {
+        NodeIndex index;
+        bool expanded;
+    };
+    std::vector<Frame> stack = {{root, false}};
+    while (!stack.empty()) {
+        Frame frame = stack.back();
+        if (frame.expanded || frame.index == NO_NODE) {
+            stack.pop_back();
+            if (frame.index != NO_NODE) on_exit(frame.index);
+            continue;
+        }
+        stack.back().expanded = true;
+        // Operands are pushed in reverse, so the first one is handled first
+        const FlatNode& node = nodes_[frame.index];
+        switch (node.kind) {
+            case NodeKind::BINARY:
+                stack.push_back({node.second, false});
+                stack.push_back({node.first, false});
+                break;
+            case NodeKind::UNARY:
+                stack.push_back({node.first, false});
+                break;
+            case NodeKind::ASSIGNMENT:
+                stack.push_back({node.second, false});
+                break;
+            case NodeKind::CALL:
+                if (node.second == NO_NODE) break;
+                for (NodeIndex argument : GetChildren(nodes_[node.second]) | std::views::reverse) {
+                    stack.push_back({argument, false});
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+#endif //FLAT_AST_H
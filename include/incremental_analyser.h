@@ -0,0 +1,84 @@
+#ifndef INCREMENTAL_ANALYSER_H
+#define INCREMENTAL_ANALYSER_H
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "interner.h"
+#include "symbol_table.h"
+
+// Keeps a source file checked while it is being edited, for an editor integration or a REPL. The source is
+// split into units, one per top-level declaration, each with its own text and Program. An edit re-lexes and
+// re-parses the units around it until the parse ends on the start of an old unit again, then re-runs the
+// SemanticAnalyser on the new units and on the units that use a global whose declaration changed.
+//
+// The errors are the ones the SemanticAnalyser reports for the whole file, in the same order. Units with parse
+// errors are not analysed (the Parser reports those errors itself), but still declare their name if it parsed.
+class IncrementalAnalyser {
+public:
+    struct EditStats {
+        size_t reparsed_count = 0;   // Units parsed, including units parsed past the edit to find the end of it
+        size_t reanalysed_count = 0;
+    };
+
+    explicit IncrementalAnalyser(std::string_view source_code);
+    // Replaces removed_length characters at offset with inserted_text, throws std::out_of_range if they aren't
+    // all in the source
+    void Edit(size_t offset, size_t removed_length, std::string_view inserted_text);
+    [[nodiscard]] std::string GetSource() const;
+    [[nodiscard]] std::vector<std::string> GetErrors() const;
+    [[nodiscard]] size_t GetErrorCount() const;
+    [[nodiscard]] size_t GetParseErrorCount() const; // Number of units with parse errors
+    [[nodiscard]] size_t GetUnitCount() const;
+    [[nodiscard]] const EditStats& GetLastEditStats() const; // Of the last Edit, or of the constructor
+private:
+    // What a unit declares in the global scope, symbol is NO_SYMBOL for statements
+    struct Signature {
+        SymbolId symbol = NO_SYMBOL;
+        SymbolType type = SymbolType::VARIABLE;
+        size_t parameter_count = 0;
+        bool operator==(const Signature& other) const = default;
+    };
+
+    struct Unit {
+        std::shared_ptr<const std::string> buffer; // The text was parsed from here, names in the AST point into it
+        std::string_view text;  // The declaration and the whitespace after it, the first unit also gets what is before
+        ProgramPtr program;     // Holds the declaration, nullptr if text is only whitespace
+        bool had_parse_error = false;
+        Signature signature;
+        std::vector<SymbolId> uses; // Every name in the declaration, sorted
+        std::vector<std::string> errors;
+        size_t newline_count = 0;
+        size_t begin = 0;       // Offset of text in the source
+        size_t line = 0;        // Of the start of text
+        size_t position = 0;    // Index in units_
+    };
+    using UnitPtr = std::unique_ptr<Unit>;
+
+    // Parses buffer from its start into units. Stops after a unit that ends on one of boundaries, the ascending
+    // offsets in buffer where old units start, and returns that boundary's index. Returns boundaries.size() if
+    // buffer was parsed to the end instead
+    static size_t ParseUnits(const std::shared_ptr<const std::string>& buffer, size_t line,
+                             const std::vector<size_t>& boundaries, std::vector<UnitPtr>& units);
+    void Resolve(Unit& unit); // Moves the unit's names over to interner_, and fills in signature and uses
+    void Analyse(Unit& unit);
+    void Renumber(size_t first); // Updates begin, line and position of the units from first on
+    void AddDeclaration(const Unit& unit);
+    void RemoveDeclaration(const Unit& unit);
+    [[nodiscard]] const Unit* FindDeclaration(SymbolId symbol, size_t position) const; // First, if before position
+    [[nodiscard]] size_t FindUnit(size_t offset) const; // The unit whose text contains offset
+private:
+    std::vector<UnitPtr> units_;
+    Interner interner_;             // Shared by all units, each unit's Parser interns on its own
+    std::deque<std::string> names_; // Owns the names in interner_, since units and their text come and go
+    std::unordered_map<SymbolId, std::vector<const Unit*>> declarations_; // The units declaring each global
+    size_t error_count_ = 0;
+    EditStats last_edit_;
+};
+
+#endif //INCREMENTAL_ANALYSER_H
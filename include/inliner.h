@@ -0,0 +1,56 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include <unordered_map>
+
+#include "pass_manager.h"
+#include "symbol_table.h"
+
+// Replaces calls to small top-level functions with the body of the function.
+// A function can be inlined if its body is a single 'return <expression>;' where the expression
+// only uses literals, parameters and operators, and the expression has at most threshold nodes.
+// Calls inside function bodies are inlined first, so helpers calling other helpers collapse too.
+//
+// Arguments are substituted for the parameters. Since Lox evaluates every argument exactly once
+// and from left to right, an argument with side effects is only substituted if that is still the case
+// after inlining, otherwise the call is left alone.
+class Inliner : public ASTPass, private ASTVisitor {
+public:
+    static constexpr size_t DEFAULT_THRESHOLD = 16;
+
+    explicit Inliner(size_t threshold = DEFAULT_THRESHOLD);
+    [[nodiscard]] std::string_view Name() const override;
+    void Run(Program& program) override;
+    [[nodiscard]] size_t GetInlinedCount() const;
+private:
+    void visit(Program &node) override;
+    void visit(FunDecl &node) override;
+    void visit(VarDecl &node) override;
+    void visit(ExprStmt &node) override;
+    void visit(IfStmt &node) override;
+    void visit(PrintStmt &node) override;
+    void visit(ReturnStmt &node) override;
+    void visit(WhileStmt &node) override;
+    void visit(Block &node) override;
+    void visit(Assignment &node) override;
+    void visit(Binary &node) override;
+    void visit(Unary &node) override;
+    void visit(Call &node) override;
+    void visit(Identifier &node) override;
+    void visit(Literal &node) override;
+    void visit(Parameters &node) override;
+    void visit(Arguments &node) override;
+
+    void Inline(ExpressionPtr& expression); // Inlines every eligible call inside expression
+    bool TryInlineCall(ExpressionPtr& expression);
+    void AddCandidate(FunDecl& function);
+    void CountDeclarations(Declaration& declaration);
+private:
+    size_t threshold_;
+    size_t inlined_count_;
+    Arena* arena_; // Of the Program being run on, inlined bodies are copied into it
+    SymbolTable functions_; // Top-level functions that can be inlined
+    std::unordered_map<SymbolId, size_t> declaration_counts_;
+};
+
+#endif //INLINER_H
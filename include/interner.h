@@ -0,0 +1,34 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+// Dense id of an interned identifier, equal names always get the same id
+using SymbolId = uint32_t;
+constexpr SymbolId NO_SYMBOL = std::numeric_limits<SymbolId>::max(); // Tokens that aren't identifiers
+
+// Maps identifier names to dense SymbolIds, so that everything after the lexer can compare and look up
+// identifiers by integer. Names are stored as string_views, so they have to outlive the Interner
+// (like Token::lexeme, they normally point into the source code).
+class Interner {
+public:
+    SymbolId Intern(std::string_view name);
+    [[nodiscard]] SymbolId Find(std::string_view name) const; // NO_SYMBOL if name was never interned
+    [[nodiscard]] std::string_view GetName(SymbolId symbol) const;
+    [[nodiscard]] size_t Size() const;
+private:
+    static size_t Hash(std::string_view name);
+    [[nodiscard]] size_t FindSlot(std::string_view name, size_t hash) const; // Slot of name, or the empty slot it would go in
+    void Grow();
+private:
+    // Open addressing with linear probing, slots_ holds SymbolIds (NO_SYMBOL if empty) and always has a
+    // power of two size. Interning doesn't allocate per name, only when the table or names_ grow.
+    std::vector<SymbolId> slots_;
+    std::vector<std::string_view> names_; // Indexed by SymbolId
+    std::vector<size_t> hashes_;          // Indexed by SymbolId, so growing doesn't rehash the names
+};
+
+#endif //INTERNER_H
@@ -1,15 +1,20 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <array>
+#include <cstdint>
+#include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
-#include <unordered_map>
+
+#include "interner.h"
 
 
 /**
  *  TOKENS
  */
-enum class TokenType {
+enum class TokenType : uint8_t {
     // Single-character tokens.
     LEFT_PAREN, RIGHT_PAREN,
     LEFT_BRACE, RIGHT_BRACE,
@@ -32,11 +37,12 @@ enum class TokenType {
 };
 
 using TT = TokenType;
+constexpr size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TT::END) + 1;
 
 /*
  *  KEYWORDS
  */
-const std::unordered_map<std::string, TokenType> KEYWORDS = {
+constexpr std::array<std::pair<std::string_view, TokenType>, 12> KEYWORDS = {{
     {"fun",    TT::FUN},
     {"or",     TT::OR},
     {"and",    TT::AND},
@@ -49,22 +55,71 @@ const std::unordered_map<std::string, TokenType> KEYWORDS = {
     {"false",  TT::FALSE},
     {"nil",    TT::NIL},
     {"else",   TT::ELSE},
-};
+}};
+
+// Returns the keyword's TokenType or TT::IDENTIFIER, backed by a perfect hash table built at compile time
+[[nodiscard]] TokenType LookupKeyword(std::string_view lexeme);
 
 struct Token {
     TokenType type;
+    SymbolId symbol; // Interned lexeme for IDENTIFIER tokens, NO_SYMBOL otherwise
     std::string_view lexeme;
     size_t line;
 
-    Token(TokenType type, std::string_view lexeme, size_t line)
-        : type(type), lexeme(lexeme), line(line) {}
+    Token(TokenType type, std::string_view lexeme, size_t line, SymbolId symbol = NO_SYMBOL)
+        : type(type), symbol(symbol), lexeme(lexeme), line(line) {}
+};
+
+// Structure of arrays alternative to std::vector<Token> for large sources, about 13 bytes per token instead of 32.
+// Lexemes are stored as 32 bit offset/length into the source (error tokens store an index into errors_
+// as their length) and lines are computed on demand from an index of newline offsets, built on first use.
+class TokenBuffer {
+public:
+    explicit TokenBuffer(std::string_view source_code);
+    static size_t EstimateTokenCount(size_t source_size); // Used to reserve capacity up front
+
+    void Reserve(size_t token_count);
+    void Push(const Token& token, size_t offset); // offset is where the token starts in the source
+    // Appends other[begin, end), mapping its symbols through symbol_map and shifting the lines of its error
+    // tokens. Both buffers have to be over the same source, used to merge the output of several lexers.
+    void Append(const TokenBuffer& other, size_t begin, size_t end, size_t error_line_offset,
+                const std::vector<SymbolId>& symbol_map);
+    void ShrinkToFit(); // Releases the capacity left over from Reserve
+
+    [[nodiscard]] size_t Size() const;
+    [[nodiscard]] uint32_t GetOffset(size_t index) const; // Where the token starts in the source, sorted
+    [[nodiscard]] TokenType GetType(size_t index) const;
+    [[nodiscard]] SymbolId GetSymbol(size_t index) const;
+    [[nodiscard]] std::string_view GetLexeme(size_t index) const;
+    [[nodiscard]] size_t GetLine(size_t index) const; // Not thread safe the first time, since it builds the index
+    [[nodiscard]] Token Get(size_t index) const;
+    [[nodiscard]] size_t MemoryUsage() const; // Bytes allocated for the token arrays and the newline index
+private:
+    void BuildLineIndex() const;
+private:
+    std::string_view source_code_;
+    std::vector<TokenType> types_;
+    std::vector<SymbolId> symbols_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> lengths_;
+    struct ErrorToken {
+        std::string_view message;
+        size_t line;
+    };
+    std::vector<ErrorToken> errors_; // Indexed by lengths_ of ERROR tokens
+    mutable std::vector<uint32_t> newline_offsets_;
+    mutable bool has_line_index_ = false;
 };
 
 class Lexer {
 public:
     explicit Lexer(std::string_view source_code);
+    Lexer(std::string_view source_code, size_t start_index, size_t start_line); // Starts between two tokens
     std::vector<Token> TokenizeAll(); // Tokenizes entire source file, only used for testing and debugging
+    TokenBuffer TokenizeToBuffer(); // Same tokens as TokenizeAll, for tokenizing large sources up front
     Token ReadNextToken();
+    [[nodiscard]] size_t GetTokenStart() const; // Source offset of the last token, also valid for error tokens
+    [[nodiscard]] const Interner& GetInterner() const;
 private:
     // Lexer Control Functions
     char Advance();
@@ -88,6 +143,7 @@ private:
     size_t cur_index_;
     size_t start_index_;
     size_t cur_line_;
+    Interner interner_; // Identifiers are interned as they are read
 };
 
 #endif //LEXER_H
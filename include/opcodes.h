@@ -0,0 +1,66 @@
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/**
+ *  OPCODES
+ *  Single source for every opcode. Adding a line here adds the enum value, its metadata,
+ *  a VM handler declaration (VM::Op<NAME>) and its entry in the VM dispatch table.
+ *
+ *  X(name, operand_width, pops, pushes)
+ *      operand_width: size of the operand in bytes (little endian), 0 if there is none
+ *      pops/pushes:   stack effect, used by the Verifier
+ */
+#define OPCODE_LIST(X)                \
+    X(CONSTANT,      1, 0, 1)         \
+    X(CONSTANT_LONG, 3, 0, 1)         \
+    X(ADD,           0, 2, 1)         \
+    X(SUBTRACT,      0, 2, 1)         \
+    X(MULTIPLY,      0, 2, 1)         \
+    X(DIVIDE,        0, 2, 1)         \
+    X(POP,           0, 1, 0)         \
+    X(NEGATE,        0, 1, 1)         \
+    X(NOT,           0, 1, 1)         \
+    X(EQUAL,         0, 2, 1)         \
+    X(GREATER,       0, 2, 1)         \
+    X(LESS,          0, 2, 1)         \
+    X(JUMP,          2, 0, 0)         \
+    X(JUMP_IF_FALSE, 2, 1, 0)
+
+// JUMP:          forward offset, relative to the end of the instruction
+// JUMP_IF_FALSE: pops the condition, then jumps like JUMP if it is falsey
+enum class OpCode : uint8_t {
+#define X(name, operand_width, pops, pushes) name,
+    OPCODE_LIST(X)
+#undef X
+};
+
+using OP = OpCode;
+
+struct OpDefinition {
+    std::string_view name;
+    uint8_t operand_width;
+    uint8_t pops;
+    uint8_t pushes;
+};
+
+inline constexpr std::array OP_DEFINITIONS = {
+#define X(name, operand_width, pops, pushes) OpDefinition{#name, operand_width, pops, pushes},
+    OPCODE_LIST(X)
+#undef X
+};
+
+inline constexpr size_t OPCODE_COUNT = OP_DEFINITIONS.size();
+
+constexpr bool IsValidOpCode(uint8_t byte) {
+    return byte < OPCODE_COUNT;
+}
+
+constexpr const OpDefinition& GetOpDefinition(OP op) {
+    return OP_DEFINITIONS[static_cast<size_t>(op)];
+}
+
+#endif //OPCODES_H
@@ -0,0 +1,37 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Calls task(i) for every i in [0, count) on up to thread_count threads (the calling thread is one of them).
+// Threads pull the next index from a shared counter, so a thread that finishes its tasks early keeps taking
+// new ones instead of idling. If tasks throw, the exception of the lowest index is rethrown once all are done.
+template <typename Task>
+void ParallelFor(size_t count, size_t thread_count, Task&& task) {
+    thread_count = std::clamp<size_t>(thread_count, 1, std::max<size_t>(count, 1));
+    std::atomic<size_t> next_index = 0;
+    std::vector<std::exception_ptr> errors(count);
+    auto worker = [&] {
+        for (size_t i = next_index++; i < count; i = next_index++) {
+            try {
+                task(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; i++) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+
+    auto error = std::find_if(errors.begin(), errors.end(), [](const auto& error) { return error != nullptr; });
+    if (error != errors.end()) std::rethrow_exception(*error);
+}
+
+#endif //PARALLEL_FOR_H
@@ -0,0 +1,50 @@
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "interner.h"
+#include "lexer.h"
+
+// Tokenizes very large sources on several threads, producing exactly the tokens and symbol ids of
+// Lexer::TokenizeToBuffer. The source is split into segments that start right after a newline, and every
+// segment is lexed speculatively as if it started between two tokens. That only fails when a string literal
+// crosses the split (comments end at the newline). The segments are merged in order, and a segment whose
+// guess was wrong is re-lexed from the real position until its tokens line up with the speculative ones.
+class ParallelLexer {
+public:
+    static constexpr size_t MIN_SEGMENT_SIZE = 1 << 20; // Smaller segments aren't worth a thread
+
+    explicit ParallelLexer(std::string_view source_code, size_t thread_count = std::thread::hardware_concurrency(),
+                           size_t min_segment_size = MIN_SEGMENT_SIZE);
+    TokenBuffer TokenizeAll();
+    [[nodiscard]] const Interner& GetInterner() const;
+private:
+    struct Segment {
+        size_t begin;
+        size_t end;
+        TokenBuffer tokens;   // Tokens that start in [begin, end), and the END token if it was reached
+        Interner interner;    // Segment local symbol ids, remapped when merging
+        size_t lookahead = 0; // Start of the first token at or after end, the next segment should begin there
+        size_t newline_count = 0;
+
+        Segment(std::string_view source_code, size_t begin, size_t end)
+            : begin(begin), end(end), tokens(source_code) {}
+    };
+
+    [[nodiscard]] std::vector<Segment> Split() const;
+    void LexSegment(Segment& segment) const;
+    void LexSegments(std::vector<Segment>& segments) const;
+    // Appends segment tokens [begin, end) to result with their symbols interned into interner_
+    void Append(TokenBuffer& result, const TokenBuffer& tokens, const Interner& interner, size_t begin, size_t end,
+                size_t error_line_offset);
+private:
+    std::string_view source_code_;
+    size_t thread_count_;
+    size_t min_segment_size_;
+    Interner interner_;
+};
+
+#endif //PARALLEL_LEXER_H
@@ -1,17 +1,40 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <functional>
+#include <array>
+#include <vector>
 
 #include "ast.h"
+#include "chunk.h"
 #include "lexer.h"
+#include "pipelined_lexer.h"
+
+class Compiler;
+class SemanticAnalyser;
 
 class Parser {
 public:
-    explicit Parser(std::string_view source_code);
+    // With pipelined_lexing the source is lexed on a separate thread (PipelinedLexer) while it is being parsed.
+    // The thread starts with the first token, so a Parser that is never used lexes nothing
+    explicit Parser(std::string_view source_code, bool pipelined_lexing = false);
+    Parser(std::string_view source_code, size_t start_index, size_t start_line); // Starts between two tokens
     ProgramPtr GenerateAST();
-    ExpressionPtr ParseExpression();
+    // Streaming mode: parses only the next top-level declaration, into a Program with an Arena of its own, so
+    // it can be compiled, run and freed before the rest of the source is parsed. nullptr once the source is done
+    ProgramPtr GenerateNextDeclaration();
+    // Single-pass mode: emits bytecode while parsing and runs the analyser's checks as each construct is
+    // parsed, without building an AST. Produces the same chunk as compiling GenerateAST's result without passes
+    Chunk GenerateChunk(SemanticAnalyser& analyser);
+    ExpressionPtr ParseExpression(); // Only used for testing, the expression lives as long as the Parser
+    // Maps Identifier::symbol back to names. With pipelined lexing only safe once the whole source was parsed
+    [[nodiscard]] const Interner& GetInterner() const;
+    // Source offset of the next token to be parsed, after GenerateNextDeclaration that is where the next
+    // declaration starts. Not available with pipelined lexing, the lexer is ahead of the parser then
+    [[nodiscard]] size_t GetOffset() const;
+    [[nodiscard]] bool HadError() const;
 private:
+    Parser(Lexer lexer, size_t source_size, bool pipelined_lexing);
+
     // Pratt Parsing
     enum class Precedence {
         NONE,
@@ -27,12 +50,20 @@ private:
         PRIMARY
     };
 
+    // Every parse function gets wrapped by Prefix/Infix, so that they can share one member pointer type
+    using PrefixFn = ExpressionPtr (Parser::*)();
+    using InfixFn = ExpressionPtr (Parser::*)(ExpressionPtr);
     struct ParseRule {
-        std::function<ExpressionPtr()> prefix;
-        std::function<ExpressionPtr(ExpressionPtr)> infix;
-        Precedence precedence;
+        PrefixFn prefix = nullptr;
+        InfixFn infix = nullptr;
+        Precedence precedence = Precedence::NONE;
     };
-    std::unordered_map<TokenType, ParseRule> pratt_table_;
+    static const std::array<ParseRule, TOKEN_TYPE_COUNT> PRATT_TABLE; // Indexed by TokenType, built at compile time
+
+    template <auto ParseFn>
+    ExpressionPtr Prefix();
+    template <auto ParseFn>
+    ExpressionPtr Infix(ExpressionPtr left);
 
 private:
     // Control functions
@@ -42,7 +73,7 @@ private:
     bool Match(TT type); // Checks if cur_token_ == type and advances
 
     // ParseRules
-    ParseRule GetRule(TokenType type);
+    static const ParseRule& GetRule(TokenType type);
 
     // Statements
     DeclarationPtr ParseDeclaration();
@@ -58,17 +89,70 @@ private:
 
     // Expressions
     ExpressionPtr ParsePrecedence(Precedence precedence);
-    AssignmentPtr ParseAssignment(ExpressionPtr left);
+    ExpressionPtr ParseAssignment(ExpressionPtr left); // Returns left if it can't be assigned to
     BinaryPtr ParseBinary(ExpressionPtr left);
     UnaryPtr ParseUnary();
     LiteralPtr ParseLiteral();
     ExpressionPtr ParseGrouping();
-    CallPtr ParseCall(ExpressionPtr left);
+    ExpressionPtr ParseCall(ExpressionPtr left); // Returns left if it can't be called
     IdentifierPtr ParseIdentifier();
 
     // Parse Other
     ParametersPtr ParseParameters();
-    ArgumentsPtr ParseArguments();
+
+    // Single-pass mode (parser_single_pass.cpp), one Compile function per Parse function above
+    // A bare identifier isn't checked until the next token shows whether it is a value, a callee or an
+    // assignment target, so expressions report it back to whoever consumes them. symbol is NO_SYMBOL otherwise
+    struct Operand {
+        std::string_view name;
+        SymbolId symbol = NO_SYMBOL;
+    };
+    using CompilePrefixFn = Operand (Parser::*)();
+    using CompileInfixFn = Operand (Parser::*)(Operand);
+    struct CompileRule {
+        CompilePrefixFn prefix = nullptr;
+        CompileInfixFn infix = nullptr;
+    };
+    static const std::array<CompileRule, TOKEN_TYPE_COUNT> COMPILE_TABLE; // Precedences come from PRATT_TABLE
+
+    void CompileDeclaration();
+    void CompileFunDecl();
+    void CompileVarDecl();
+    void CompileIfStmt();
+    void CompilePrintStmt();
+    void CompileReturnStmt();
+    void CompileWhileStmt();
+    void CompileBlock();
+    void CompileStatement();
+    void CompileExprStmt();
+
+    void CompileValue(Precedence precedence); // CompilePrecedence for an expression whose value is used
+    Operand CompilePrecedence(Precedence precedence);
+    Operand CompileAssignment(Operand left);
+    Operand CompileBinary(Operand left);
+    Operand CompileUnary();
+    Operand CompileLiteral();
+    Operand CompileGrouping();
+    Operand CompileCall(Operand left);
+    Operand CompileIdentifier();
+
+    Value ParseLiteralValue(); // Shared by ParseLiteral and CompileLiteral
+
+    // Expressions are parsed without recursing on the C++ stack, so that nesting depth is only limited by memory.
+    // A parse function that needs an operand pushes a PendingOperator and returns, ParsePrecedence then parses
+    // the operand at operand_precedence and hands it to Resume (or CompileResume), which finishes the operator
+    struct PendingOperator {
+        enum class Kind : uint8_t { UNARY, BINARY, ASSIGNMENT, GROUPING, ARGUMENT };
+        Kind kind;
+        Precedence precedence;         // Of the expression the operator is part of, restored by Resume
+        ExpressionPtr node = nullptr;  // The node the operand belongs to, nullptr for groupings and in single-pass mode
+        TokenType op = TT::END;        // Single-pass mode: the operator of a Unary or Binary
+        Operand target{};              // Single-pass mode: the assigned variable or the callee
+        size_t argument_count = 0;     // Single-pass mode: arguments before this one
+    };
+    PendingOperator& Suspend(PendingOperator::Kind kind, Precedence operand_precedence);
+    ExpressionPtr Resume(ExpressionPtr operand);
+    Operand CompileResume(Operand operand);
 
     // Error Handling
     void ErrorAt(Token& token, std::string msg);
@@ -76,6 +160,15 @@ private:
     void Synchronize();
 private:
     Lexer lexer_;
+    bool pipelined_lexing_;
+    std::unique_ptr<PipelinedLexer> pipeline_; // Reads from lexer_ on its own thread, set on the first token
+    size_t source_size_;
+    Arena* arena_; // Where new nodes go, the Program's Arena or expression_arena_
+    std::unique_ptr<Arena> expression_arena_; // Owns the nodes returned by ParseExpression
+    Compiler* compiler_;        // Only set during GenerateChunk
+    SemanticAnalyser* analyser_; // Only set during GenerateChunk
+    std::vector<PendingOperator> pending_; // Innermost operator last
+    Precedence precedence_;      // Of the expression being parsed
     Token prev_token_;
     Token cur_token_;
     bool panic_mode_;  // switches between true/false when encountering errors and synchronizing
@@ -0,0 +1,80 @@
+#ifndef PASS_MANAGER_H
+#define PASS_MANAGER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.h"
+#include "chunk.h"
+
+enum class OptLevel {
+    O0, // No passes, fastest compile for short-lived scripts
+    O1, // Cheap local passes (folding, peephole)
+    O2, // Everything, including more expensive passes (inlining)
+};
+
+class ASTPass {
+public:
+    virtual ~ASTPass() = default;
+    [[nodiscard]] virtual std::string_view Name() const = 0;
+    virtual void Run(Program& program) = 0;
+};
+
+class BytecodePass {
+public:
+    virtual ~BytecodePass() = default;
+    [[nodiscard]] virtual std::string_view Name() const = 0;
+    virtual void Run(Chunk& chunk) = 0;
+};
+
+// One row per executed pass. before/after are AST node counts for AST passes
+// and instruction counts for bytecode passes. Passes that run more than once (once per declaration in
+// streaming mode) keep a single row with the sums.
+struct PassStats {
+    std::string name;
+    double wall_time_ms;
+    size_t before;
+    size_t after;
+};
+
+// Runs an ordered list of passes between Parser::GenerateAST and Compiler::Compile (AST passes)
+// and after Compiler::Compile (bytecode passes). A pass only runs if the current OptLevel is at least
+// the level it was registered with and it has not been disabled by name.
+class PassManager {
+public:
+    explicit PassManager(OptLevel opt_level);
+    static PassManager CreateDefault(OptLevel opt_level); // Registers the default pipeline
+
+    void AddASTPass(std::unique_ptr<ASTPass> pass, OptLevel min_level);
+    void AddBytecodePass(std::unique_ptr<BytecodePass> pass, OptLevel min_level);
+    void DisablePass(std::string_view pass_name);
+
+    void RunASTPasses(Program& program);
+    void RunBytecodePasses(Chunk& chunk);
+
+    [[nodiscard]] const std::vector<PassStats>& GetStats() const;
+    [[nodiscard]] OptLevel GetOptLevel() const;
+private:
+    [[nodiscard]] bool IsEnabled(std::string_view pass_name, OptLevel min_level) const;
+    void Record(std::string_view pass_name, double wall_time_ms, size_t before, size_t after);
+private:
+    template <typename PassType>
+    struct Entry {
+        std::unique_ptr<PassType> pass;
+        OptLevel min_level;
+    };
+
+    OptLevel opt_level_;
+    std::vector<Entry<ASTPass>> ast_passes_;
+    std::vector<Entry<BytecodePass>> bytecode_passes_;
+    std::unordered_set<std::string> disabled_passes_;
+    std::vector<PassStats> stats_;
+};
+
+// Used for the before/after columns in PassStats
+size_t CountASTNodes(ASTNode& node);
+
+#endif //PASS_MANAGER_H
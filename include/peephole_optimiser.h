@@ -0,0 +1,26 @@
+#ifndef PEEPHOLE_OPTIMISER_H
+#define PEEPHOLE_OPTIMISER_H
+
+#include "pass_manager.h"
+
+// Removes short instruction sequences that have no effect:
+//   CONSTANT(_LONG) x, POP        -> (nothing)
+//   <bool producing op>, NOT, NOT -> <bool producing op>
+// Jumps are retargeted after removal. Chunks containing jumps with targets
+// outside the chunk are left untouched.
+class PeepholeOptimiser : public BytecodePass {
+public:
+    [[nodiscard]] std::string_view Name() const override;
+    void Run(Chunk& chunk) override;
+private:
+    struct Instruction {
+        OP op;
+        uint64_t operand;
+        size_t offset;     // Offset in the original chunk
+        bool is_jump_target;
+    };
+    static bool Decode(const Chunk& chunk, std::vector<Instruction>& instructions);
+    static bool TryReduceTail(std::vector<Instruction>& output);
+};
+
+#endif //PEEPHOLE_OPTIMISER_H
@@ -0,0 +1,54 @@
+#ifndef PIPELINED_LEXER_H
+#define PIPELINED_LEXER_H
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "lexer.h"
+
+// Runs a Lexer on its own thread, so that lexing overlaps with parsing. Tokens are passed through a lock-free
+// single-producer/single-consumer ring buffer. Each side keeps its position in a plain member and only
+// publishes it to the other side once per batch, so the shared atomics (and their cache lines) are touched
+// once every BATCH_SIZE tokens instead of once per token. A side that runs out of tokens or space publishes
+// what it has and waits until the other side catches up: it yields for a short while and then blocks, so a
+// lexer thread that filled the ring doesn't burn a core while the parser is busy.
+class PipelinedLexer {
+public:
+    static constexpr size_t CAPACITY = 1 << 14;  // Tokens in the ring, a power of two
+    static constexpr size_t BATCH_SIZE = 256;    // Tokens handled between two publications of a position
+    static constexpr size_t SPIN_COUNT = 64;     // Yields before a waiting side blocks
+
+    explicit PipelinedLexer(Lexer& lexer); // Starts the lexer thread. lexer must not be used until destruction
+    PipelinedLexer(const PipelinedLexer&) = delete;
+    PipelinedLexer& operator=(const PipelinedLexer&) = delete;
+    ~PipelinedLexer(); // Stops the lexer thread, even if not all tokens were read
+
+    Token ReadNextToken(); // Same tokens as Lexer::ReadNextToken, END is repeated once reached
+private:
+    void Produce(); // Body of the lexer thread
+    static void Publish(std::atomic<size_t>& position, size_t value); // Stores value and wakes the other side
+    static void WaitForChange(const std::atomic<size_t>& position, size_t old); // Returns once position != old
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    Lexer& lexer_;
+    std::vector<Token> ring_;
+
+    // Written by the lexer thread: tokens written so far. Read by the consumer
+    alignas(64) std::atomic<size_t> written_ = 0;
+    // Written by the consumer: tokens read so far, which frees their slots. Read by the lexer thread
+    alignas(64) std::atomic<size_t> read_ = 0;
+    std::atomic<bool> stop_ = false;
+
+    // Consumer side only
+    alignas(64) size_t read_index_ = 0;
+    size_t readable_end_ = 0;      // Last value of written_ the consumer saw
+    std::optional<Token> end_;     // Set once END has been read
+
+    std::thread thread_;           // Last, so that it only starts once everything above is initialised
+};
+
+#endif //PIPELINED_LEXER_H
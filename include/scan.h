@@ -0,0 +1,31 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <string_view>
+
+// Bulk scanning kernels used by the Lexer for long runs of whitespace, comments and string literals.
+// On x86 they process 16 (SSE2) or 32 (AVX2) bytes at a time, elsewhere they fall back to a scalar loop.
+// Every kernel also stops at '\0', since the Lexer treats it as the end of the source.
+namespace Scan {
+    enum class Kernel {
+        SCALAR,
+        SSE2,
+        AVX2,
+    };
+
+    [[nodiscard]] bool IsSupported(Kernel kernel);
+    void SetKernel(Kernel kernel); // Defaults to the best supported kernel, only meant for tests and benchmarks
+    [[nodiscard]] Kernel GetKernel();
+
+    // Returns the index of the first character at or after index that isn't ' ', '\t', '\r' or '\n'
+    // and adds the number of skipped newlines to line
+    size_t SkipWhitespace(std::string_view text, size_t index, size_t& line);
+
+    // Returns the index of the first '\n' at or after index (the end of a // comment)
+    size_t FindLineEnd(std::string_view text, size_t index);
+
+    // Returns the index of the first '"' at or after index and adds the number of skipped newlines to line
+    size_t FindStringEnd(std::string_view text, size_t index, size_t& line);
+}
+
+#endif //SCAN_H
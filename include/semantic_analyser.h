@@ -1,14 +1,28 @@
 #ifndef SEMANTIC_ANALYSER_H
 #define SEMANTIC_ANALYSER_H
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "ast.h"
+#include "flat_ast.h"
 #include "symbol_table.h"
 
 class SemanticAnalyser : public ASTVisitor {
 public:
     SemanticAnalyser();
+    void Analyse(const FlatAST& ast); // Reports the same errors as visiting the tree the FlatAST was built from
+    // Declares the top-level names in order, then checks the bodies of top-level functions on thread_count
+    // threads. Reports the same errors, in the same order, as program.accept(*this)
+    void Analyse(Program& program, size_t thread_count);
+    // Lazy analysis, used together with Compiler::CompileLazily. DeclareGlobals checks everything but the
+    // bodies of top-level functions, AnalyseFunction then checks one of those bodies once it is needed.
+    // Errors in bodies that are never needed are never reported
+    void DeclareGlobals(Program& program);
+    void AnalyseFunction(FunDecl& function);
+    [[nodiscard]] size_t GetErrorCount() const;
+    void SetDiagnostics(std::vector<std::string>* diagnostics); // While set, errors are appended instead of printed
     void visit(Program &node) override;
     void visit(FunDecl &node) override;
     void visit(VarDecl &node) override;
@@ -26,14 +40,41 @@ public:
     void visit(Literal &node) override;
     void visit(Parameters &node) override;
     void visit(Arguments &node) override;
-private:
+
+    // One check per construct, in source order. The visitors above are built from these, and the single-pass
+    // Parser::GenerateChunk calls them directly while it parses
+    void DeclareFunction(std::string_view name, SymbolId symbol_id, size_t parameter_count);
+    void DeclareVariable(std::string_view name, SymbolId symbol_id);
+    void DeclareParameter(std::string_view name, SymbolId symbol_id);
+    void CheckAssignment(std::string_view name, SymbolId symbol_id);
+    void CheckIdentifier(std::string_view name, SymbolId symbol_id); // An identifier used as a value
+    void CheckCall(std::string_view name, SymbolId symbol_id, size_t call_argument_count);
     void PushScope();
     void PopScope();
+private:
+    // Checks one top-level function body against the global scope of globals, seeing only the names declared
+    // up to the declaration_index'th top-level declaration. Errors go to diagnostics instead of std::cerr if set
+    SemanticAnalyser(const SemanticAnalyser& globals, size_t declaration_index, std::vector<std::string>* diagnostics);
+    // Everything but the top-level function bodies, in order. Returns the indices of the top-level functions.
+    // Errors of the i'th declaration go to (*diagnostics)[i] if diagnostics is set
+    std::vector<size_t> AnalyseGlobals(Program& program, std::vector<std::vector<std::string>>* diagnostics);
+    void AnalyseFunctionBody(FunDecl& node);
+    void AnalyseNode(const FlatAST& ast, NodeIndex index);
+    void AnalyseExpression(const FlatAST& ast, NodeIndex index); // Skips NO_NODE
     void Error(std::string msg);
-    bool CheckSymbol(std::string msg);
-    const Symbol* GetSymbol(std::string msg);
+    bool CheckSymbol(SymbolId symbol_id);
+    const Symbol* GetSymbol(SymbolId symbol_id);
+    [[nodiscard]] const Symbol* GetGlobal(SymbolId symbol_id, size_t declaration_index) const;
 private:
-    std::vector<SymbolTable> scopes_;
+    ScopeChain scopes_;
+    size_t error_count_ = 0;
+    std::vector<std::string>* diagnostics_ = nullptr; // Buffers errors while set
+    // Filled by AnalyseGlobals: the top-level declaration each new global came from, and each function whose
+    // body was skipped. Kept after DeclareGlobals until the next call, for AnalyseFunction
+    std::unordered_map<SymbolId, size_t> global_order_;
+    std::unordered_map<const FunDecl*, size_t> deferred_functions_;
+    const SemanticAnalyser* globals_ = nullptr;
+    size_t declaration_index_ = 0;
 };
 
 #endif //SEMANTIC_ANALYSER_H
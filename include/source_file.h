@@ -0,0 +1,35 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Owns the text of a script. Regular files are memory mapped read-only and lexed in place (the Lexer is
+// bounded by the length, so no terminator or copy is needed). Pipes, terminals and other files that can't
+// be mapped are read into a buffer instead. Tokens, the AST and string constants in a Chunk all point into
+// GetText(), so the SourceFile has to outlive them.
+class SourceFile {
+public:
+    static SourceFile Open(const std::string& path); // "-" reads stdin, throws std::runtime_error on failure
+    static SourceFile FromDescriptor(int fd, const std::string& name); // Doesn't take ownership of fd
+
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    ~SourceFile();
+
+    [[nodiscard]] std::string_view GetText() const;
+    [[nodiscard]] bool IsMapped() const;
+private:
+    SourceFile() = default;
+    void Unmap();
+private:
+    const char* mapping_ = nullptr; // Set if the file is memory mapped
+    size_t mapping_size_ = 0;
+    std::vector<char> buffer_;      // Used when the file couldn't be mapped, unlike std::string moving it keeps the data in place
+};
+
+#endif //SOURCE_FILE_H
@@ -1,10 +1,16 @@
 #ifndef SYMBOL_TABLE_H
 #define SYMBOL_TABLE_H
 
-#include <string>
+#include <cstdint>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <variant>
+#include <vector>
+
+#include "interner.h"
+
+class FunDecl;
 
 enum class SymbolType {
     VARIABLE,
@@ -12,16 +18,18 @@ enum class SymbolType {
 };
 
 struct VariableInfo {
-    std::string name;
-    VariableInfo(std::string name)
-        : name(std::move(name)) {}
+    std::string_view name;
+    VariableInfo(std::string_view name)
+        : name(name) {}
 };
 
 struct FunctionInfo {
-    std::string name;
+    std::string_view name;
     size_t parameter_count;
-    FunctionInfo(std::string name, size_t parameter_count)
-        : name(std::move(name)), parameter_count(parameter_count) {}
+    const FunDecl* declaration; // Only set by passes that need the body, e.g. the Inliner
+    size_t body_size;           // Number of AST nodes in the body, 0 if unknown
+    FunctionInfo(std::string_view name, size_t parameter_count, const FunDecl* declaration = nullptr, size_t body_size = 0)
+        : name(name), parameter_count(parameter_count), declaration(declaration), body_size(body_size) {}
 };
 
 struct Symbol {
@@ -31,14 +39,39 @@ struct Symbol {
         : type(type), object(std::move(object)) {}
 };
 
+// Keyed by the SymbolId the Lexer assigned to the name
 class SymbolTable {
 public:
-    bool AddSymbol(std::string symbol_name, Symbol symbol);
-    [[nodiscard]] bool Contains(std::string symbol_name) const;
-    [[nodiscard]] const Symbol* GetSymbol(std::string symbol_name) const;
+    bool AddSymbol(SymbolId symbol_id, Symbol symbol);
+    [[nodiscard]] bool Contains(SymbolId symbol_id) const;
+    [[nodiscard]] const Symbol* GetSymbol(SymbolId symbol_id) const;
 private:
-    std::unordered_map<std::string, Symbol> table_;
+    std::unordered_map<SymbolId, Symbol> table_;
 };
 
+// Every scope of a nesting of scopes in one table. Each SymbolId maps to its innermost binding, which links to
+// the binding it shadows. bindings_ is both the stack of bindings and the undo log: popping a scope removes
+// its bindings and restores what they shadowed. Lookups take O(1) however deep the nesting, and once the
+// vectors and the map have grown, pushing and popping scopes doesn't allocate
+class ScopeChain {
+public:
+    void PushScope();
+    void PopScope();
+    bool AddSymbol(SymbolId symbol_id, Symbol symbol); // False if the innermost scope already has symbol_id
+    [[nodiscard]] const Symbol* GetSymbol(SymbolId symbol_id) const; // From the innermost scope that has it
+    [[nodiscard]] size_t Depth() const;
+private:
+    static constexpr uint32_t NO_BINDING = UINT32_MAX;
+
+    struct Binding {
+        SymbolId symbol_id;
+        uint32_t shadowed; // NO_BINDING if there is no outer binding of symbol_id
+        Symbol symbol;
+    };
+
+    std::vector<Binding> bindings_;
+    std::vector<uint32_t> scope_starts_; // Index of the first binding of each scope
+    std::unordered_map<SymbolId, uint32_t> innermost_; // NO_BINDING once the last binding is popped
+};
 
 #endif //SYMBOL_TABLE_H
@@ -0,0 +1,24 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include <string>
+
+#include "chunk.h"
+
+// Checks that a chunk is well formed before the VM runs it: every instruction is complete, constants
+// and jump targets are in bounds, no instruction pops more values than are on the stack and every
+// path reaching an instruction arrives with the same stack depth. On success the maximum stack depth
+// is stored in the chunk, which lets the VM skip bounds checks on every push and pop.
+class Verifier {
+public:
+    // initial_depth values are already on the stack when the chunk starts, like the globals of earlier chunks
+    // in streaming mode. The stored maximum depth doesn't include them
+    bool Verify(Chunk& chunk, size_t initial_depth = 0);
+    [[nodiscard]] const std::string& GetError() const;
+private:
+    bool Error(size_t offset, std::string msg);
+private:
+    std::string error_;
+};
+
+#endif //VERIFIER_H
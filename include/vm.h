@@ -1,6 +1,7 @@
 #ifndef VM_H
 #define VM_H
 
+#include <array>
 #include <optional>
 
 #include "ast.h"
@@ -9,8 +10,13 @@
 
 class VM {
 public:
+    VM(); // Without a chunk, everything is run through Interpret(const Chunk&)
     VM(const Chunk& chunk);
-    void Interpret();
+    bool Interpret(); // Returns false if the chunk couldn't be run to the end
+    // Runs chunk on the current stack, so values left behind by earlier chunks (global variables) are kept.
+    // Used by streaming mode, which runs one chunk per top-level declaration
+    bool Interpret(const Chunk& chunk);
+    [[nodiscard]] size_t GetStackDepth() const; // Values left on the stack, what the next chunk starts with
     void SetDebug(Logger logger);
 private:
     bool InterpretNext();
@@ -21,13 +27,24 @@ private:
     void Error(std::string msg) const;
     OP NextInstruction();
 
+    // One handler per opcode, generated from OPCODE_LIST
+#define X(name, operand_width, pops, pushes) bool Op##name();
+    OPCODE_LIST(X)
+#undef X
+    using OpHandler = bool (VM::*)();
+    static constexpr std::array<OpHandler, OPCODE_COUNT> DISPATCH_TABLE = {
+#define X(name, operand_width, pops, pushes) &VM::Op##name,
+        OPCODE_LIST(X)
+#undef X
+    };
+
     // Used for debugging, prints an opcode and potential operand to debug logger
     void PrintStatus() const;
     void PrintStack() const;
     void PrintChunkDebugInfo() const;
     [[nodiscard]] bool HasDebugLogger() const;
 private:
-    const Chunk& chunk_;
+    const Chunk* chunk_;
     int pc_;
     static constexpr int MAX_STACK_SIZE_ = 2048;
     std::array<Value, MAX_STACK_SIZE_> stack_;
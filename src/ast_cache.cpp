@@ -0,0 +1,521 @@
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+#include <unistd.h>
+
+#include "ast_cache.h"
+#include "flat_ast.h"
+#include "source_file.h"
+
+// Layout, fixed width fields in native byte order (the cache never leaves the machine that wrote it):
+//   uint32 MAGIC, uint32 VERSION, uint64 source hash, uint64 source size
+//   varint node count, varint symbol count, then per symbol varint offset and length of its name in the source
+//   the nodes in FlatAST order, each a header byte (NodeKind in the low 5 bits, the high 3 bits say which of
+//   first/second/third are present, or hold the LiteralTag) followed by:
+//     PROGRAM, BLOCK, PARAMETERS, ARGUMENTS  varint child count
+//     BINARY, UNARY                          operator byte
+//     IDENTIFIER                             varint symbol
+//     LITERAL                                varint for INTEGER, 8 bytes for NUMBER, varint offset and length for STRING
+// Bump VERSION whenever this layout, NodeKind or TokenType changes.
+namespace {
+    constexpr uint32_t MAGIC = 0x4341584c; // "LXAC"
+    constexpr uint32_t VERSION = 1;
+    constexpr int KIND_BITS = 5;
+    static_assert(static_cast<int>(NodeKind::ARGUMENTS) < 1 << KIND_BITS);
+
+    enum class LiteralTag : uint8_t { NIL, FALSE, TRUE, INTEGER, NUMBER, STRING };
+
+    uint8_t Header(NodeKind kind, unsigned bits) {
+        return static_cast<uint8_t>(static_cast<unsigned>(kind) | bits << KIND_BITS);
+    }
+
+    class Writer {
+    public:
+        void Byte(uint8_t byte) { bytes_.push_back(byte); }
+        void Varint(uint64_t value) {
+            for (; value >= 0x80; value >>= 7) bytes_.push_back(static_cast<uint8_t>(value | 0x80));
+            bytes_.push_back(static_cast<uint8_t>(value));
+        }
+        template <typename T>
+        void Fixed(T value) {
+            auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+            bytes_.insert(bytes_.end(), bytes, bytes + sizeof(T));
+        }
+        std::vector<uint8_t> Take() { return std::move(bytes_); }
+    private:
+        std::vector<uint8_t> bytes_;
+    };
+
+    // Reading past the end sets failed_ and returns zeros, so callers only check once per node
+    class Reader {
+    public:
+        explicit Reader(std::span<const uint8_t> data) : next_(data.data()), end_(data.data() + data.size()) {}
+        uint8_t Byte() {
+            if (next_ == end_) {
+                failed_ = true;
+                return 0;
+            }
+            return *next_++;
+        }
+        uint64_t Varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t byte = Byte();
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) return value;
+            }
+            failed_ = true;
+            return 0;
+        }
+        template <typename T>
+        T Fixed() {
+            T value{};
+            if (static_cast<size_t>(end_ - next_) < sizeof(T)) {
+                failed_ = true;
+                return value;
+            }
+            std::memcpy(&value, next_, sizeof(T));
+            next_ += sizeof(T);
+            return value;
+        }
+        [[nodiscard]] bool Failed() const { return failed_; }
+        [[nodiscard]] bool AtEnd() const { return next_ == end_; }
+    private:
+        const uint8_t* next_;
+        const uint8_t* end_;
+        bool failed_ = false;
+    };
+
+    // Offset of text in source, everything the Parser puts in the AST is a view into the source
+    size_t OffsetIn(std::string_view source_code, std::string_view text) {
+        if (text.empty()) return 0;
+        auto begin = reinterpret_cast<uintptr_t>(source_code.data());
+        auto position = reinterpret_cast<uintptr_t>(text.data());
+        if (position < begin || position + text.size() > begin + source_code.size()) {
+            throw std::invalid_argument("AST text is not part of the source code");
+        }
+        return position - begin;
+    }
+
+    void WriteLiteral(Writer& writer, const Value& value, std::string_view source_code) {
+        if (value.IsNil()) {
+            writer.Byte(Header(NodeKind::LITERAL, static_cast<unsigned>(LiteralTag::NIL)));
+        } else if (value.IsBool()) {
+            auto tag = value.AsBool() ? LiteralTag::TRUE : LiteralTag::FALSE;
+            writer.Byte(Header(NodeKind::LITERAL, static_cast<unsigned>(tag)));
+        } else if (value.IsString()) {
+            writer.Byte(Header(NodeKind::LITERAL, static_cast<unsigned>(LiteralTag::STRING)));
+            writer.Varint(OffsetIn(source_code, value.AsString()));
+            writer.Varint(value.AsString().size());
+        } else {
+            // Most number literals in scripts are small integers, which fit in a byte or two as a varint
+            double number = value.AsDouble();
+            if (number >= 0 && number < 0x1p53 && std::trunc(number) == number && !std::signbit(number)) {
+                writer.Byte(Header(NodeKind::LITERAL, static_cast<unsigned>(LiteralTag::INTEGER)));
+                writer.Varint(static_cast<uint64_t>(number));
+            } else {
+                writer.Byte(Header(NodeKind::LITERAL, static_cast<unsigned>(LiteralTag::NUMBER)));
+                writer.Fixed(number);
+            }
+        }
+    }
+
+    // Rebuilds the tree from the node stream. Finished nodes wait on stack_ until their parent pops them, in the
+    // reverse of the order FlatASTBuilder appended them. Popping checks the kind, so a node can only ever end up
+    // in a field of a matching type
+    class ProgramReader {
+    public:
+        ProgramReader(Reader& reader, std::string_view source_code, const std::vector<std::string_view>& names,
+                      Program& program, size_t node_count)
+            : reader_(reader), source_code_(source_code), names_(names), program_(program),
+              arena_(*program.arena) {
+            stack_.reserve(std::min<size_t>(node_count, 1 << 16));
+        }
+
+        // Returns false if the stream is truncated or isn't a well formed tree
+        bool Read(size_t node_count) {
+            for (size_t i = 0; i < node_count && !failed_; i++) {
+                uint8_t header = reader_.Byte();
+                auto kind = static_cast<NodeKind>(header & ((1 << KIND_BITS) - 1));
+                unsigned bits = header >> KIND_BITS;
+                if (kind == NodeKind::PROGRAM && i + 1 != node_count) return false;
+                ReadNode(kind, bits);
+                failed_ |= reader_.Failed();
+            }
+            return !failed_ && stack_.empty() && reader_.AtEnd();
+        }
+    private:
+        struct Entry {
+            ASTNode* node;
+            NodeKind kind;
+        };
+
+        template <typename T>
+        static bool Accepts(NodeKind kind) {
+            if constexpr (std::is_same_v<T, Declaration>) return kind >= NodeKind::FUN_DECL && kind <= NodeKind::BLOCK;
+            else if constexpr (std::is_same_v<T, Statement>) return kind >= NodeKind::EXPR_STMT && kind <= NodeKind::BLOCK;
+            else if constexpr (std::is_same_v<T, Expression>) return kind >= NodeKind::ASSIGNMENT && kind <= NodeKind::LITERAL;
+            else if constexpr (std::is_same_v<T, Block>) return kind == NodeKind::BLOCK;
+            else if constexpr (std::is_same_v<T, Identifier>) return kind == NodeKind::IDENTIFIER;
+            else if constexpr (std::is_same_v<T, Parameters>) return kind == NodeKind::PARAMETERS;
+            else return kind == NodeKind::ARGUMENTS;
+        }
+
+        template <typename T>
+        T* Pop(bool present = true) {
+            if (!present) return nullptr;
+            if (stack_.empty() || !Accepts<T>(stack_.back().kind)) {
+                failed_ = true;
+                return nullptr;
+            }
+            auto* node = static_cast<T*>(stack_.back().node);
+            stack_.pop_back();
+            return node;
+        }
+
+        template <typename T>
+        void PopList(std::pmr::vector<T*>& list) {
+            uint64_t count = reader_.Varint();
+            if (count > stack_.size()) {
+                failed_ = true;
+                return;
+            }
+            size_t first = stack_.size() - count;
+            list.reserve(count);
+            for (size_t i = first; i < stack_.size(); i++) {
+                if (!Accepts<T>(stack_[i].kind)) {
+                    failed_ = true;
+                    return;
+                }
+                list.push_back(static_cast<T*>(stack_[i].node));
+            }
+            stack_.resize(first);
+        }
+
+        // Nil for views outside the source, which also makes Read fail
+        std::string_view Text(uint64_t offset, uint64_t length) {
+            if (offset > source_code_.size() || length > source_code_.size() - offset) {
+                failed_ = true;
+                return {};
+            }
+            return source_code_.substr(offset, length);
+        }
+
+        void ReadNode(NodeKind kind, unsigned bits) {
+            bool first = bits & 1;
+            bool second = bits & 2;
+            bool third = bits & 4;
+            ASTNode* result;
+            switch (kind) {
+                case NodeKind::PROGRAM:
+                    PopList(program_.declarations);
+                    return;
+                case NodeKind::FUN_DECL: {
+                    auto* node = arena_.Make<FunDecl>();
+                    node->body = Pop<Block>(third);
+                    node->parameters = Pop<Parameters>(second);
+                    node->name = Pop<Identifier>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::VAR_DECL: {
+                    auto* node = arena_.Make<VarDecl>();
+                    node->expression = Pop<Expression>(second);
+                    node->variable = Pop<Identifier>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::EXPR_STMT: {
+                    auto* node = arena_.Make<ExprStmt>();
+                    node->expression = Pop<Expression>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::IF_STMT: {
+                    auto* node = arena_.Make<IfStmt>();
+                    node->else_body = Pop<Statement>(third);
+                    node->if_body = Pop<Statement>(second);
+                    node->condition = Pop<Expression>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::PRINT_STMT: {
+                    auto* node = arena_.Make<PrintStmt>();
+                    node->expression = Pop<Expression>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::RETURN_STMT: {
+                    auto* node = arena_.Make<ReturnStmt>();
+                    node->expression = Pop<Expression>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::WHILE_STMT: {
+                    auto* node = arena_.Make<WhileStmt>();
+                    node->body = Pop<Statement>(second);
+                    node->condition = Pop<Expression>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::BLOCK: {
+                    auto* node = arena_.Make<Block>(arena_);
+                    PopList(node->declarations);
+                    result = node;
+                    break;
+                }
+                case NodeKind::ASSIGNMENT: {
+                    // The variable was appended after the value
+                    auto* node = arena_.Make<Assignment>();
+                    node->variable = Pop<Identifier>(first);
+                    node->expression = Pop<Expression>(second);
+                    result = node;
+                    break;
+                }
+                case NodeKind::BINARY: {
+                    auto* node = arena_.Make<Binary>();
+                    node->op = static_cast<TokenType>(reader_.Byte());
+                    node->right_expression = Pop<Expression>(second);
+                    node->left_expression = Pop<Expression>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::UNARY: {
+                    auto* node = arena_.Make<Unary>();
+                    node->op = static_cast<TokenType>(reader_.Byte());
+                    node->expression = Pop<Expression>(first);
+                    result = node;
+                    break;
+                }
+                case NodeKind::CALL: {
+                    // The callee was appended after the arguments
+                    auto* node = arena_.Make<Call>();
+                    node->callee = Pop<Identifier>(first);
+                    node->arguments = Pop<Arguments>(second);
+                    result = node;
+                    break;
+                }
+                case NodeKind::IDENTIFIER: {
+                    auto* node = arena_.Make<Identifier>();
+                    uint64_t symbol = reader_.Varint();
+                    if (symbol >= names_.size()) {
+                        failed_ = true;
+                        return;
+                    }
+                    node->symbol = static_cast<SymbolId>(symbol);
+                    node->name = names_[symbol];
+                    result = node;
+                    break;
+                }
+                case NodeKind::LITERAL: {
+                    auto* node = arena_.Make<Literal>();
+                    switch (static_cast<LiteralTag>(bits)) {
+                        case LiteralTag::NIL: break;
+                        case LiteralTag::FALSE: node->value = false; break;
+                        case LiteralTag::TRUE: node->value = true; break;
+                        case LiteralTag::INTEGER: node->value = static_cast<double>(reader_.Varint()); break;
+                        case LiteralTag::NUMBER: node->value = reader_.Fixed<double>(); break;
+                        case LiteralTag::STRING: {
+                            uint64_t offset = reader_.Varint();
+                            node->value = Text(offset, reader_.Varint());
+                            break;
+                        }
+                        default:
+                            failed_ = true;
+                            return;
+                    }
+                    result = node;
+                    break;
+                }
+                case NodeKind::PARAMETERS: {
+                    auto* node = arena_.Make<Parameters>(arena_);
+                    PopList(node->identifiers);
+                    result = node;
+                    break;
+                }
+                case NodeKind::ARGUMENTS: {
+                    auto* node = arena_.Make<Arguments>(arena_);
+                    PopList(node->expressions);
+                    result = node;
+                    break;
+                }
+                default:
+                    failed_ = true;
+                    return;
+            }
+            stack_.push_back({result, kind});
+        }
+    private:
+        Reader& reader_;
+        std::string_view source_code_;
+        const std::vector<std::string_view>& names_; // Indexed by SymbolId
+        Program& program_;
+        Arena& arena_;
+        std::vector<Entry> stack_;
+        bool failed_ = false;
+    };
+
+    constexpr uint64_t PRIME_1 = 0x9e3779b185ebca87ull;
+    constexpr uint64_t PRIME_2 = 0xc2b2ae3d27d4eb4full;
+
+    uint64_t HashRound(uint64_t lane, uint64_t word) {
+        return std::rotl(lane + word * PRIME_2, 31) * PRIME_1;
+    }
+
+    uint64_t Load64(const char* bytes) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+}
+
+ASTCache::ASTCache(std::string directory) : directory_(std::move(directory)) {}
+
+ProgramPtr ASTCache::Load(std::string_view source_code) const {
+    std::optional<SourceFile> file;
+    try {
+        file = SourceFile::Open(GetPath(source_code));
+    } catch (const std::runtime_error&) {
+        return nullptr; // Not cached yet
+    }
+    std::string_view data = file->GetText();
+    return Deserialize({reinterpret_cast<const uint8_t*>(data.data()), data.size()}, source_code);
+}
+
+bool ASTCache::Store(Program& program, std::string_view source_code) const {
+    std::vector<uint8_t> data = Serialize(program, source_code);
+    // Written next to the final path and renamed over it, so Load never sees a partially written file
+    std::string path = GetPath(source_code);
+    std::string temporary_path = path + "." + std::to_string(::getpid()) + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file.flush()) {
+            std::error_code error;
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary_path, path, error);
+    if (error) std::filesystem::remove(temporary_path, error);
+    return !error;
+}
+
+std::string ASTCache::GetPath(std::string_view source_code) const {
+    static constexpr char digits[] = "0123456789abcdef";
+    uint64_t hash = HashSource(source_code);
+    std::string name(16, '0');
+    for (size_t i = name.size(); i-- > 0; hash >>= 4) name[i] = digits[hash & 0xf];
+    return (std::filesystem::path(directory_) / (name + ".ast")).string();
+}
+
+// xxHash64 style: four independent lanes over 32 byte stripes keep the multiplier busy, so hashing a large
+// script costs a fraction of a millisecond per megabyte
+uint64_t ASTCache::HashSource(std::string_view source_code) {
+    const char* next = source_code.data();
+    const char* end = next + source_code.size();
+    uint64_t hash = PRIME_1 ^ source_code.size();
+    if (source_code.size() >= 32) {
+        uint64_t lanes[4] = {PRIME_1 + PRIME_2, PRIME_2, 0, 0 - PRIME_1};
+        for (; end - next >= 32; next += 32) {
+            for (int i = 0; i < 4; i++) lanes[i] = HashRound(lanes[i], Load64(next + 8 * i));
+        }
+        for (uint64_t lane : lanes) hash = HashRound(hash, lane);
+    }
+    for (; end - next >= 8; next += 8) hash = HashRound(hash, Load64(next));
+    for (; next < end; next++) hash = HashRound(hash, static_cast<uint8_t>(*next));
+    // Final avalanche, every input bit affects every output bit
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_1;
+    return hash ^ hash >> 32;
+}
+
+std::vector<uint8_t> ASTCache::Serialize(Program& program, std::string_view source_code) {
+    FlatAST ast = FlatAST::Build(program);
+
+    std::vector<std::string_view> names; // Indexed by SymbolId
+    for (const FlatNode& node : ast.GetNodes()) {
+        if (node.kind != NodeKind::IDENTIFIER) continue;
+        SymbolId symbol = ast.GetSymbol(node);
+        if (symbol == NO_SYMBOL) throw std::invalid_argument("AST identifier without a symbol");
+        if (symbol >= names.size()) names.resize(symbol + 1);
+        names[symbol] = ast.GetName(node);
+    }
+
+    Writer writer;
+    writer.Fixed(MAGIC);
+    writer.Fixed(VERSION);
+    writer.Fixed(HashSource(source_code));
+    writer.Fixed(static_cast<uint64_t>(source_code.size()));
+    writer.Varint(ast.Size());
+    writer.Varint(names.size());
+    for (std::string_view name : names) {
+        writer.Varint(OffsetIn(source_code, name));
+        writer.Varint(name.size());
+    }
+
+    for (const FlatNode& node : ast.GetNodes()) {
+        unsigned present = (node.first != NO_NODE) | (node.second != NO_NODE) << 1 | (node.third != NO_NODE) << 2;
+        switch (node.kind) {
+            case NodeKind::PROGRAM:
+            case NodeKind::BLOCK:
+            case NodeKind::PARAMETERS:
+            case NodeKind::ARGUMENTS:
+                writer.Byte(Header(node.kind, 0));
+                writer.Varint(node.second);
+                break;
+            case NodeKind::IDENTIFIER:
+                writer.Byte(Header(node.kind, 0));
+                writer.Varint(ast.GetSymbol(node));
+                break;
+            case NodeKind::LITERAL:
+                WriteLiteral(writer, ast.GetValue(node), source_code);
+                break;
+            case NodeKind::BINARY:
+            case NodeKind::UNARY:
+                writer.Byte(Header(node.kind, present));
+                writer.Byte(static_cast<uint8_t>(node.op));
+                break;
+            default:
+                writer.Byte(Header(node.kind, present));
+                break;
+        }
+    }
+    return writer.Take();
+}
+
+ProgramPtr ASTCache::Deserialize(std::span<const uint8_t> data, std::string_view source_code) {
+    Reader reader(data);
+    if (reader.Fixed<uint32_t>() != MAGIC || reader.Fixed<uint32_t>() != VERSION ||
+        reader.Fixed<uint64_t>() != HashSource(source_code) || reader.Fixed<uint64_t>() != source_code.size()) {
+        return nullptr;
+    }
+
+    uint64_t node_count = reader.Varint();
+    uint64_t symbol_count = reader.Varint();
+    // Every symbol takes at least two bytes, which also bounds the allocation for a corrupt count
+    if (reader.Failed() || node_count == 0 || symbol_count > data.size() / 2) return nullptr;
+    std::vector<std::string_view> names(symbol_count);
+    for (auto& name : names) {
+        uint64_t offset = reader.Varint();
+        uint64_t length = reader.Varint();
+        if (offset > source_code.size() || length > source_code.size() - offset) return nullptr;
+        name = source_code.substr(offset, length);
+    }
+    if (reader.Failed()) return nullptr;
+
+    // Sized the way Parser::GenerateAST sizes it
+    auto program = std::make_unique<Program>(std::make_unique<Arena>(std::max<size_t>(source_code.size(), 4096)));
+    ProgramReader program_reader(reader, source_code, names, *program, node_count);
+    if (!program_reader.Read(node_count)) return nullptr;
+    return program;
+}
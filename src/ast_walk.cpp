@@ -0,0 +1,43 @@
+#include "ast_walk.h"
+
+namespace {
+    // One virtual call per expression instead of a chain of dynamic_casts
+    class OperandCollector : public ASTVisitor {
+    public:
+        explicit OperandCollector(std::vector<ExpressionPtr*>& operands) : operands_(operands) {}
+        void visit(Program &node) override {}
+        void visit(FunDecl &node) override {}
+        void visit(VarDecl &node) override {}
+        void visit(ExprStmt &node) override {}
+        void visit(IfStmt &node) override {}
+        void visit(PrintStmt &node) override {}
+        void visit(ReturnStmt &node) override {}
+        void visit(WhileStmt &node) override {}
+        void visit(Block &node) override {}
+        void visit(Assignment &node) override { operands_.push_back(&node.expression); }
+        void visit(Binary &node) override {
+            operands_.push_back(&node.left_expression);
+            operands_.push_back(&node.right_expression);
+        }
+        void visit(Unary &node) override { operands_.push_back(&node.expression); }
+        void visit(Call &node) override {
+            if (node.arguments == nullptr) return;
+            for (auto& argument : node.arguments->expressions) operands_.push_back(&argument);
+        }
+        void visit(Identifier &node) override {}
+        void visit(Literal &node) override {}
+        void visit(Parameters &node) override {}
+        void visit(Arguments &node) override {}
+    private:
+        std::vector<ExpressionPtr*>& operands_;
+    };
+}
+
+void AppendOperands(Expression &expression, std::vector<ExpressionPtr*> &operands) {
+    OperandCollector collector(operands);
+    expression.accept(collector);
+}
+
+void VisitExpression(ExpressionPtr root, ASTVisitor &visitor) {
+    WalkExpression(root, [&](ExpressionPtr& expression) { expression->accept(visitor); });
+}
@@ -1,12 +1,36 @@
+#include <bit>
+#include <stdexcept>
+
 #include "chunk.h"
 
 void Chunk::Write(uint8_t byte) {
     code_.push_back(byte);
+    max_stack_depth_.reset();
+}
+
+void Chunk::Append(const std::vector<uint8_t>& code) {
+    code_.insert(code_.end(), code.begin(), code.end());
+    max_stack_depth_.reset();
+}
+
+void Chunk::Patch(size_t offset, uint8_t byte) {
+    code_.at(offset) = byte;
+    max_stack_depth_.reset();
 }
 
-uint8_t Chunk::AddConstant(Value constant) {
+void Chunk::ReplaceCode(std::vector<uint8_t> code) {
+    code_ = std::move(code);
+    max_stack_depth_.reset();
+}
+
+uint32_t Chunk::AddConstant(Value constant) {
+    auto it = constant_indices_.find(constant);
+    if (it != constant_indices_.end()) return it->second;
+    if (constants_.size() >= MAX_CONSTANTS) throw std::length_error("Too many constants in one chunk");
+    auto index = static_cast<uint32_t>(constants_.size());
     constants_.push_back(constant);
-    return constants_.size() - 1;
+    constant_indices_.emplace(constant, index);
+    return index;
 }
 
 const std::vector<uint8_t>& Chunk::GetCode() const {
@@ -20,3 +44,31 @@ const std::vector<Value> & Chunk::GetConstants() const {
 size_t Chunk::Size() const {
     return code_.size();
 }
+
+size_t Chunk::InstructionCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < code_.size(); i += 1 + GetOpDefinition(static_cast<OP>(code_[i])).operand_width) {
+        count++;
+    }
+    return count;
+}
+
+void Chunk::SetMaxStackDepth(size_t max_stack_depth) {
+    max_stack_depth_ = max_stack_depth;
+}
+
+std::optional<size_t> Chunk::GetMaxStackDepth() const {
+    return max_stack_depth_;
+}
+
+size_t Chunk::ConstantHash::operator()(const Value &value) const {
+    if (value.IsDouble()) return std::hash<uint64_t>{}(std::bit_cast<uint64_t>(value.AsDouble()));
+    return std::hash<Value::InternalVal>{}(value.Get());
+}
+
+bool Chunk::ConstantEqual::operator()(const Value &lhs, const Value &rhs) const {
+    if (lhs.IsDouble() && rhs.IsDouble()) {
+        return std::bit_cast<uint64_t>(lhs.AsDouble()) == std::bit_cast<uint64_t>(rhs.AsDouble());
+    }
+    return lhs == rhs;
+}
@@ -1,4 +1,8 @@
+#include <utility>
+
 #include "compiler.h"
+#include "ast_walk.h"
+#include "parallel_for.h"
 
 Chunk Compiler::Compile(Program* program) {
     const Chunk new_chunk_;
@@ -7,6 +11,68 @@ Chunk Compiler::Compile(Program* program) {
     return cur_chunk_;
 }
 
+Chunk Compiler::Compile(Program* program, size_t thread_count) {
+    if (thread_count <= 1) return Compile(program);
+
+    // Top-level function bodies don't depend on anything emitted before them, so each is compiled on its own
+    std::vector<FunDecl*> functions;
+    for (auto* declaration : program->declarations) {
+        if (auto* function = dynamic_cast<FunDecl*>(declaration)) functions.push_back(function);
+    }
+    std::vector<Chunk> bodies(functions.size());
+    ParallelFor(functions.size(), thread_count, [&](size_t i) {
+        Compiler compiler;
+        functions[i]->accept(compiler);
+        bodies[i] = compiler.TakeChunk();
+    });
+
+    // Then everything is put together in source order, which makes the result the same as Compile(program)
+    cur_chunk_ = Chunk();
+    size_t next_body = 0;
+    for (auto* declaration : program->declarations) {
+        if (dynamic_cast<FunDecl*>(declaration)) EmitChunk(bodies[next_body++]);
+        else declaration->accept(*this);
+    }
+    return TakeChunk();
+}
+
+Chunk Compiler::CompileLazily(Program* program, SemanticAnalyser& analyser) {
+    cur_chunk_ = Chunk();
+    lazy_ = true;
+    lazy_functions_.clear();
+    called_functions_.clear();
+    functions_.clear();
+    for (auto* declaration : program->declarations) {
+        if (auto* function = dynamic_cast<FunDecl*>(declaration)) {
+            // Like the analyser, calls resolve to the first declaration of a name
+            lazy_functions_.try_emplace(function->name->symbol, LazyFunction{function, false});
+        } else {
+            declaration->accept(*this);
+        }
+    }
+    Chunk chunk = TakeChunk();
+
+    // Compiling a body can call further functions, which are appended to called_functions_
+    for (size_t i = 0; i < called_functions_.size(); i++) {
+        FunDecl* function = called_functions_[i];
+        analyser.AnalyseFunction(*function);
+        function->body->accept(*this);
+        functions_.push_back(TakeChunk());
+    }
+    lazy_ = false;
+    return chunk;
+}
+
+const std::vector<Chunk>& Compiler::GetFunctions() const {
+    return functions_;
+}
+
+Chunk Compiler::Compile(const FlatAST& ast) {
+    cur_chunk_ = Chunk();
+    CompileNode(ast, ast.GetRoot());
+    return cur_chunk_;
+}
+
 void Compiler::visit(Program &node) {
     for (auto& declaration : node.declarations) {
         declaration->accept(*this);
@@ -19,31 +85,38 @@ void Compiler::visit(FunDecl &node) {
 }
 
 void Compiler::visit(VarDecl &node) {
-    node.expression->accept(*this);
+    VisitExpression(node.expression, *this);
 }
 
 void Compiler::visit(ExprStmt &node) {
-    node.expression->accept(*this);
+    VisitExpression(node.expression, *this);
     Emit(OP::POP);
 }
 
 void Compiler::visit(IfStmt &node) {
-    node.condition->accept(*this);
-    EmitJump(OP::JUMP_IF_FALSE);
+    VisitExpression(node.condition, *this);
+    uint32_t else_jump = EmitJump(OP::JUMP_IF_FALSE);
     node.if_body->accept(*this);
-    if (node.else_body != nullptr) node.else_body->accept(*this);
+    if (node.else_body == nullptr) {
+        PatchJump(else_jump);
+        return;
+    }
+    uint32_t end_jump = EmitJump(OP::JUMP);
+    PatchJump(else_jump);
+    node.else_body->accept(*this);
+    PatchJump(end_jump);
 }
 
 void Compiler::visit(PrintStmt &node) {
-    node.expression->accept(*this);
+    VisitExpression(node.expression, *this);
 }
 
 void Compiler::visit(ReturnStmt &node) {
-    node.expression->accept(*this);
+    VisitExpression(node.expression, *this);
 }
 
 void Compiler::visit(WhileStmt &node) {
-    node.condition->accept(*this);
+    VisitExpression(node.condition, *this);
     node.body->accept(*this);
 }
 
@@ -55,41 +128,26 @@ void Compiler::visit(Block &node) {
     // PopScope
 }
 
+// Expressions are reached through VisitExpression, which has already compiled their operands
+
 void Compiler::visit(Assignment &node) {
-    node.expression->accept(*this);
 }
 
 void Compiler::visit(Binary &node) {
-    node.left_expression->accept(*this);
-    node.right_expression->accept(*this);
-    switch (node.op) {
-        case TT::PLUS: Emit(OP::ADD); break;
-        case TT::MINUS: Emit(OP::SUBTRACT); break;
-        case TT::STAR: Emit(OP::MULTIPLY); break;
-        case TT::SLASH: Emit(OP::DIVIDE); break;
-        case TT::EQUAL_EQUAL: Emit(OP::EQUAL); break;
-        case TT::BANG_EQUAL: Emit(OP::EQUAL); Emit(OP::NOT); break;
-        case TT::GREATER: Emit(OP::GREATER); break;
-        case TT::GREATER_EQUAL: Emit(OP::LESS); Emit(OP::NOT); break;
-        case TT::LESS: Emit(OP::LESS); break;
-        case TT::LESS_EQUAL: Emit(OP::GREATER); Emit(OP::NOT); break;
-        default:
-            throw std::invalid_argument("Invalid binary operator");
-    }
+    EmitBinary(node.op);
 }
 
 void Compiler::visit(Unary &node) {
-    node.expression->accept(*this);
-    switch (node.op) {
-        case TT::MINUS: Emit(OP::NEGATE); break;
-        case TT::BANG: Emit(OP::NOT); break;
-        default:
-            throw std::invalid_argument("Invalid unary operator");
-    }
+    EmitUnary(node.op);
 }
 
 void Compiler::visit(Call &node) {
-    node.arguments->accept(*this);
+    if (!lazy_) return;
+    auto function = lazy_functions_.find(node.callee->symbol);
+    if (function != lazy_functions_.end() && !function->second.called) {
+        function->second.called = true;
+        called_functions_.push_back(function->second.declaration);
+    }
 }
 
 void Compiler::visit(Identifier &node) {
@@ -98,8 +156,7 @@ void Compiler::visit(Identifier &node) {
 
 void Compiler::visit(Literal &node) {
     // TODO intern string
-    uint8_t index = cur_chunk_.AddConstant(node.value);
-    EmitWithOperand(OP::CONSTANT, index);
+    EmitConstant(node.value);
 }
 
 void Compiler::visit(Parameters &node) {
@@ -107,15 +164,112 @@ void Compiler::visit(Parameters &node) {
 
 void Compiler::visit(Arguments &node) {
     for (auto& expression : node.expressions) {
-        expression->accept(*this);
+        VisitExpression(expression, *this);
     }
 }
 
+// Mirrors the visit functions above, node by node. Like them, expressions only emit their own code, their
+// operands are compiled first by CompileExpression
+void Compiler::CompileNode(const FlatAST& ast, NodeIndex index) {
+    const FlatNode& node = ast.GetNode(index);
+    switch (node.kind) {
+        case NodeKind::PROGRAM:
+        case NodeKind::BLOCK:
+            for (NodeIndex child : ast.GetChildren(node)) CompileNode(ast, child);
+            break;
+        case NodeKind::ARGUMENTS:
+            for (NodeIndex child : ast.GetChildren(node)) CompileExpression(ast, child);
+            break;
+        case NodeKind::FUN_DECL:
+            // The body is compiled inline, like Compiler::visit(FunDecl) does
+            CompileNode(ast, node.third);
+            break;
+        case NodeKind::VAR_DECL:
+            CompileExpression(ast, node.second);
+            break;
+        case NodeKind::EXPR_STMT:
+            CompileExpression(ast, node.first);
+            Emit(OP::POP);
+            break;
+        case NodeKind::IF_STMT: {
+            CompileExpression(ast, node.first);
+            uint32_t else_jump = EmitJump(OP::JUMP_IF_FALSE);
+            CompileNode(ast, node.second);
+            if (node.third == NO_NODE) {
+                PatchJump(else_jump);
+                break;
+            }
+            uint32_t end_jump = EmitJump(OP::JUMP);
+            PatchJump(else_jump);
+            CompileNode(ast, node.third);
+            PatchJump(end_jump);
+            break;
+        }
+        case NodeKind::PRINT_STMT:
+        case NodeKind::RETURN_STMT:
+            CompileExpression(ast, node.first);
+            break;
+        case NodeKind::WHILE_STMT:
+            CompileExpression(ast, node.first);
+            CompileNode(ast, node.second);
+            break;
+        case NodeKind::BINARY:
+            EmitBinary(node.op);
+            break;
+        case NodeKind::UNARY:
+            EmitUnary(node.op);
+            break;
+        case NodeKind::LITERAL:
+            EmitConstant(ast.GetValue(node));
+            break;
+        case NodeKind::ASSIGNMENT:
+        case NodeKind::CALL:
+        case NodeKind::IDENTIFIER:
+        case NodeKind::PARAMETERS:
+            break;
+    }
+}
+
+void Compiler::CompileExpression(const FlatAST& ast, NodeIndex index) {
+    if (index == NO_NODE) return;
+    ast.WalkExpression(index, [&](NodeIndex expression) { CompileNode(ast, expression); });
+}
+
+Chunk Compiler::TakeChunk() {
+    return std::exchange(cur_chunk_, Chunk());
+}
+
 void Compiler::Emit(OpCode op_code) {
     auto byte = static_cast<uint8_t>(op_code);
     cur_chunk_.Write(byte);
 }
 
+void Compiler::EmitBinary(TokenType op) {
+    switch (op) {
+        case TT::PLUS: Emit(OP::ADD); break;
+        case TT::MINUS: Emit(OP::SUBTRACT); break;
+        case TT::STAR: Emit(OP::MULTIPLY); break;
+        case TT::SLASH: Emit(OP::DIVIDE); break;
+        case TT::EQUAL_EQUAL: Emit(OP::EQUAL); break;
+        case TT::BANG_EQUAL: Emit(OP::EQUAL); Emit(OP::NOT); break;
+        case TT::GREATER: Emit(OP::GREATER); break;
+        case TT::GREATER_EQUAL: Emit(OP::LESS); Emit(OP::NOT); break;
+        case TT::LESS: Emit(OP::LESS); break;
+        case TT::LESS_EQUAL: Emit(OP::GREATER); Emit(OP::NOT); break;
+        default:
+            throw std::invalid_argument("Invalid binary operator");
+    }
+}
+
+void Compiler::EmitUnary(TokenType op) {
+    switch (op) {
+        case TT::MINUS: Emit(OP::NEGATE); break;
+        case TT::BANG: Emit(OP::NOT); break;
+        default:
+            throw std::invalid_argument("Invalid unary operator");
+    }
+}
+
 uint32_t Compiler::EmitJump(OpCode jump_type) {
     assert(jump_type == OP::JUMP || jump_type == OP::JUMP_IF_FALSE);
     Emit(jump_type);
@@ -124,8 +278,99 @@ uint32_t Compiler::EmitJump(OpCode jump_type) {
     return cur_chunk_.Size();
 }
 
+void Compiler::PatchJump(uint32_t jump_end) {
+    size_t jump = cur_chunk_.Size() - jump_end;
+    if (jump > UINT16_MAX) throw std::length_error("Too much code to jump over");
+    cur_chunk_.Patch(jump_end - 2, jump & 0xff);
+    cur_chunk_.Patch(jump_end - 1, (jump >> 8) & 0xff);
+}
+
 void Compiler::EmitWithOperand(OpCode op_code, uint8_t operand) {
     auto byte = static_cast<uint8_t>(op_code);
     cur_chunk_.Write(byte);
     cur_chunk_.Write(operand);
 }
+
+void Compiler::EmitConstant(Value value) {
+    EmitConstantIndex(cur_chunk_.AddConstant(value));
+}
+
+void Compiler::EmitConstantIndex(uint32_t index) {
+    if (index <= UINT8_MAX) {
+        EmitWithOperand(OP::CONSTANT, index);
+        return;
+    }
+    Emit(OP::CONSTANT_LONG);
+    cur_chunk_.Write(index & 0xff);
+    cur_chunk_.Write((index >> 8) & 0xff);
+    cur_chunk_.Write((index >> 16) & 0xff);
+}
+
+void Compiler::EmitChunk(const Chunk& chunk) {
+    const auto& code = chunk.GetCode();
+    const auto& constants = chunk.GetConstants();
+    auto read_operand = [&](size_t offset, uint8_t width) {
+        uint32_t operand = 0;
+        for (uint8_t i = 0; i < width; i++) operand |= code[offset + 1 + i] << (8 * i);
+        return operand;
+    };
+
+    // The pool of chunk is in the order its code first uses the constants, so adding them in that order gives
+    // the same indices as EmitConstant would have. A constant whose index changes width moves the code after it
+    std::vector<uint32_t> new_indices(constants.size());
+    bool widths_change = false;
+    for (uint32_t index = 0; index < constants.size(); index++) {
+        new_indices[index] = cur_chunk_.AddConstant(constants[index]);
+        widths_change |= (index <= UINT8_MAX) != (new_indices[index] <= UINT8_MAX);
+    }
+
+    if (!widths_change) {
+        // Nothing moves, so the code is copied as is and only constant operands are rewritten
+        size_t base = cur_chunk_.Size();
+        cur_chunk_.Append(code);
+        for (size_t offset = 0; offset < code.size();) {
+            auto op = static_cast<OP>(code[offset]);
+            uint8_t width = GetOpDefinition(op).operand_width;
+            if (op == OP::CONSTANT || op == OP::CONSTANT_LONG) {
+                uint32_t index = new_indices[read_operand(offset, width)];
+                for (uint8_t i = 0; i < width; i++) cur_chunk_.Patch(base + offset + 1 + i, (index >> (8 * i)) & 0xff);
+            }
+            offset += 1 + width;
+        }
+        return;
+    }
+
+    // Otherwise new_offsets maps each old offset to its new one, so that jumps can be adjusted
+    std::vector<uint32_t> new_offsets(code.size() + 1);
+    auto new_offset = static_cast<uint32_t>(cur_chunk_.Size());
+    for (size_t offset = 0; offset < code.size();) {
+        auto op = static_cast<OP>(code[offset]);
+        uint8_t width = GetOpDefinition(op).operand_width;
+        new_offsets[offset] = new_offset;
+        if (op == OP::CONSTANT || op == OP::CONSTANT_LONG) {
+            new_offset += new_indices[read_operand(offset, width)] <= UINT8_MAX ? 2 : 4;
+        } else {
+            new_offset += 1 + width;
+        }
+        offset += 1 + width;
+    }
+    new_offsets[code.size()] = new_offset;
+
+    for (size_t offset = 0; offset < code.size();) {
+        auto op = static_cast<OP>(code[offset]);
+        uint8_t width = GetOpDefinition(op).operand_width;
+        if (op == OP::CONSTANT || op == OP::CONSTANT_LONG) {
+            EmitConstantIndex(new_indices[read_operand(offset, width)]);
+        } else if (op == OP::JUMP || op == OP::JUMP_IF_FALSE) {
+            size_t end = offset + 1 + width;
+            size_t jump = new_offsets[end + read_operand(offset, width)] - new_offsets[end];
+            if (jump > UINT16_MAX) throw std::length_error("Too much code to jump over");
+            Emit(op);
+            cur_chunk_.Write(jump & 0xff);
+            cur_chunk_.Write((jump >> 8) & 0xff);
+        } else {
+            for (size_t i = 0; i < 1u + width; i++) cur_chunk_.Write(code[offset + i]);
+        }
+        offset += 1 + width;
+    }
+}
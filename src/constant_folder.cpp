@@ -0,0 +1,124 @@
+#include "constant_folder.h"
+#include "ast_walk.h"
+
+std::string_view ConstantFolder::Name() const {
+    return "constant-folding";
+}
+
+void ConstantFolder::Run(Program &program) {
+    program.accept(*this);
+}
+
+void ConstantFolder::visit(Program &node) {
+    for (auto& declaration : node.declarations) {
+        declaration->accept(*this);
+    }
+}
+
+void ConstantFolder::visit(FunDecl &node) {
+    node.body->accept(*this);
+}
+
+void ConstantFolder::visit(VarDecl &node) {
+    Fold(node.expression);
+}
+
+void ConstantFolder::visit(ExprStmt &node) {
+    Fold(node.expression);
+}
+
+void ConstantFolder::visit(IfStmt &node) {
+    Fold(node.condition);
+    node.if_body->accept(*this);
+    if (node.else_body != nullptr) node.else_body->accept(*this);
+}
+
+void ConstantFolder::visit(PrintStmt &node) {
+    Fold(node.expression);
+}
+
+void ConstantFolder::visit(ReturnStmt &node) {
+    Fold(node.expression);
+}
+
+void ConstantFolder::visit(WhileStmt &node) {
+    Fold(node.condition);
+    node.body->accept(*this);
+}
+
+void ConstantFolder::visit(Block &node) {
+    for (auto& declaration : node.declarations) {
+        declaration->accept(*this);
+    }
+}
+
+// Expressions are handled by Fold, since they might have to be replaced by their parent
+void ConstantFolder::visit(Assignment &node) {}
+void ConstantFolder::visit(Binary &node) {}
+void ConstantFolder::visit(Unary &node) {}
+void ConstantFolder::visit(Call &node) {}
+void ConstantFolder::visit(Identifier &node) {}
+void ConstantFolder::visit(Literal &node) {}
+void ConstantFolder::visit(Parameters &node) {}
+void ConstantFolder::visit(Arguments &node) {}
+
+void ConstantFolder::Fold(ExpressionPtr &expression) {
+    WalkExpression(expression, [](ExpressionPtr& operation) { FoldOperation(operation); });
+}
+
+void ConstantFolder::FoldOperation(ExpressionPtr &expression) {
+    if (auto* unary = dynamic_cast<Unary*>(expression)) {
+        auto* operand = dynamic_cast<Literal*>(unary->expression);
+        if (operand == nullptr) return;
+        if (auto result = FoldUnary(unary->op, operand->value)) {
+            // Reuse the operand for the result, the unary node stays behind in the Arena
+            operand->value = *result;
+            expression = operand;
+        }
+        return;
+    }
+
+    if (auto* binary = dynamic_cast<Binary*>(expression)) {
+        auto* left = dynamic_cast<Literal*>(binary->left_expression);
+        if (left == nullptr) return;
+        auto* right = dynamic_cast<Literal*>(binary->right_expression);
+        if (right == nullptr) return;
+        if (auto result = FoldBinary(binary->op, left->value, right->value)) {
+            left->value = *result;
+            expression = left;
+        }
+    }
+}
+
+std::optional<Value> ConstantFolder::FoldBinary(TokenType op, const Value &left, const Value &right) {
+    switch (op) {
+        case TT::EQUAL_EQUAL: return Value(left == right);
+        case TT::BANG_EQUAL: return Value(left != right);
+        default: break;
+    }
+
+    if (!left.IsDouble() || !right.IsDouble()) return std::nullopt;
+    double lhs = left.AsDouble();
+    double rhs = right.AsDouble();
+    switch (op) {
+        case TT::PLUS: return Value(lhs + rhs);
+        case TT::MINUS: return Value(lhs - rhs);
+        case TT::STAR: return Value(lhs * rhs);
+        case TT::SLASH: return rhs == 0.0 ? std::nullopt : std::optional<Value>(lhs / rhs);
+        case TT::GREATER: return Value(lhs > rhs);
+        case TT::GREATER_EQUAL: return Value(lhs >= rhs);
+        case TT::LESS: return Value(lhs < rhs);
+        case TT::LESS_EQUAL: return Value(lhs <= rhs);
+        default: return std::nullopt;
+    }
+}
+
+std::optional<Value> ConstantFolder::FoldUnary(TokenType op, const Value &value) {
+    switch (op) {
+        case TT::BANG: return Value(value.IsFalsey());
+        case TT::MINUS:
+            if (!value.IsDouble()) return std::nullopt;
+            return Value(-value.AsDouble());
+        default: return std::nullopt;
+    }
+}
@@ -1,6 +1,6 @@
 #include "debug.h"
+#include "ast_walk.h"
 #include <iomanip>
-#include <format>
 
 constexpr size_t AST_INDENT_SPACING = 4;
 
@@ -48,21 +48,7 @@ static std::string GetTokenString(TokenType type) {
 }
 
 std::string Debug::VariantToString(Value var) {
-    //if (std::holds_alternative<std::string_view>(var)) {
-    //    return std::string(std::get<std::string_view>(var));
-    //}
-    //if (std::holds_alternative<double>(var)) {
-    //    const auto val = std::get<double>(var);
-    //    std::ostringstream oss;
-    //    oss.precision(2);
-    //    oss << std::fixed << val;
-    //    return oss.str();
-    //}
-    //if (std::holds_alternative<bool>(var)) {
-    //    const auto val = std::get<bool>(var);
-    //    return val ? "true" : "false";
-    //}
-    return "nil";
+    return var.GetValueDebugString();
 }
 
 std::ostream& operator<<(std::ostream& os, const TokenType& type) {
@@ -300,12 +286,15 @@ std::string Debug::GetChunkStr(const Chunk &chunk) {
     for (int i = 0; i < code.size(); i++) {
         int col_width = 12;
         auto op_code = static_cast<OP>(code[i]);
-        auto& op_definition = OP_DEFINITIONS.at(op_code);
-        std::string temp = "[" + op_definition.name + "]";
+        auto& op_definition = GetOpDefinition(op_code);
+        std::string temp = "[" + std::string(op_definition.name) + "]";
         oss << std::left << std::setw(col_width) << temp;
 
-        if (op_definition.operand_count > 0) {
-            auto operand = static_cast<int>(code[++i]);
+        if (op_definition.operand_width > 0) {
+            uint64_t operand = 0;
+            for (int byte = 0; byte < op_definition.operand_width; byte++) {
+                operand |= static_cast<uint64_t>(code[++i]) << (8 * byte);
+            }
             oss << operand;
         }
         oss << "\n";
@@ -378,29 +367,60 @@ static std::string WrapWithParen(std::string str) {
     return "(" + str + ")";
 }
 
-static std::string CreateExprString(const Expression* const expression) {
-    if (const auto* literal = dynamic_cast<const Literal*>(expression)) {
-        return Debug::VariantToString(literal->value);
-    }
-    if (const auto* identifier = dynamic_cast<const Identifier*>(expression)) {
-        return std::string(identifier->name);
-    }
-    if (const auto* binary = dynamic_cast<const Binary*>(expression)) {
-        return WrapWithParen(CreateExprString(binary->left_expression.get()) +
-            " " + GetOperator(binary->op) + " " +
-                CreateExprString(binary->right_expression.get()));
-    }
-    if (const auto* unary = dynamic_cast<const Unary*>(expression)) {
-        return WrapWithParen(GetOperator(unary->op) + CreateExprString(unary->expression.get()));
-    }
-    return "(Unknown Expression)";
-}
-
-std::string Debug::GetExpressionStr(const Expression* const expression) {
-    std::string expr = CreateExprString(expression);
+static std::string StripParen(std::string expr) {
     if (expr.size() > 2 && expr[0] == '(') {
         expr = expr.substr(1, expr.size() - 2);
     }
     return expr;
 }
 
+// The strings of the operands are built first and wait on a stack for the operator using them
+static std::string CreateExprString(const Expression* const expression) {
+    const std::string unknown = "(Unknown Expression)";
+    std::vector<std::string> strings;
+    auto pop = [&](const Expression* operand) {
+        if (operand == nullptr) return unknown; // Skipped by the walk
+        std::string str = std::move(strings.back());
+        strings.pop_back();
+        return str;
+    };
+    WalkExpression(expression, [&](const Expression* operation) {
+        if (const auto* literal = dynamic_cast<const Literal*>(operation)) {
+            strings.push_back(Debug::VariantToString(literal->value));
+        } else if (const auto* identifier = dynamic_cast<const Identifier*>(operation)) {
+            strings.push_back(std::string(identifier->name));
+        } else if (const auto* binary = dynamic_cast<const Binary*>(operation)) {
+            auto right_str = pop(binary->right_expression);
+            auto left_str = pop(binary->left_expression);
+            strings.push_back(WrapWithParen(left_str + " " + GetOperator(binary->op) + " " + right_str));
+        } else if (const auto* unary = dynamic_cast<const Unary*>(operation)) {
+            auto unary_str = GetOperator(unary->op) + pop(unary->expression);
+            strings.push_back(unary->op == TT::BANG ? unary_str : WrapWithParen(unary_str));
+        } else if (const auto* assignment = dynamic_cast<const Assignment*>(operation)) {
+            auto value_str = StripParen(pop(assignment->expression));
+            strings.push_back(WrapWithParen(std::string(assignment->variable->name) + " = " + value_str));
+        } else if (const auto* call = dynamic_cast<const Call*>(operation)) {
+            if (call->arguments != nullptr) {
+                for (auto* argument : call->arguments->expressions) pop(argument);
+            }
+            strings.push_back(unknown);
+        }
+    });
+    return strings.empty() ? unknown : strings.back();
+}
+
+std::string Debug::GetExpressionStr(const Expression* const expression) {
+    return StripParen(CreateExprString(expression));
+}
+
+
+std::string Debug::GetPassStatsStr(const std::vector<PassStats>& stats) {
+    std::ostringstream oss;
+    oss << std::left << std::setw(20) << "[PASS]" << std::setw(14) << "[TIME (ms)]"
+        << std::setw(10) << "[BEFORE]" << "[AFTER]\n";
+    for (auto& pass : stats) {
+        oss << std::left << std::setw(20) << pass.name << std::setw(14) << std::fixed << std::setprecision(3)
+            << pass.wall_time_ms << std::setw(10) << pass.before << pass.after << "\n";
+    }
+    return oss.str();
+}
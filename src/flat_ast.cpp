@@ -0,0 +1,124 @@
+#include "flat_ast.h"
+#include "ast_walk.h"
+#include "pass_manager.h"
+
+// Lowers the pointer tree in post order, each visit pushes the index of the node it appended onto results_.
+// Expressions are walked by VisitExpression, so the indices of their operands are already on results_
+class FlatASTBuilder : public ASTVisitor {
+public:
+    explicit FlatASTBuilder(FlatAST& ast) : ast_(ast) {}
+    void visit(Program &node) override { AddList(NodeKind::PROGRAM, node.declarations); }
+    void visit(FunDecl &node) override {
+        NodeIndex name = Lower(node.name);
+        NodeIndex parameters = Lower(node.parameters);
+        NodeIndex body = Lower(node.body);
+        Add({NodeKind::FUN_DECL, TT::END, name, parameters, body});
+    }
+    void visit(VarDecl &node) override {
+        NodeIndex variable = Lower(node.variable);
+        Add({NodeKind::VAR_DECL, TT::END, variable, Lower(node.expression)});
+    }
+    void visit(ExprStmt &node) override { Add({NodeKind::EXPR_STMT, TT::END, Lower(node.expression)}); }
+    void visit(IfStmt &node) override {
+        NodeIndex condition = Lower(node.condition);
+        NodeIndex if_body = Lower(node.if_body);
+        NodeIndex else_body = Lower(node.else_body);
+        Add({NodeKind::IF_STMT, TT::END, condition, if_body, else_body});
+    }
+    void visit(PrintStmt &node) override { Add({NodeKind::PRINT_STMT, TT::END, Lower(node.expression)}); }
+    void visit(ReturnStmt &node) override { Add({NodeKind::RETURN_STMT, TT::END, Lower(node.expression)}); }
+    void visit(WhileStmt &node) override {
+        NodeIndex condition = Lower(node.condition);
+        Add({NodeKind::WHILE_STMT, TT::END, condition, Lower(node.body)});
+    }
+    void visit(Block &node) override { AddList(NodeKind::BLOCK, node.declarations); }
+    void visit(Assignment &node) override {
+        NodeIndex value = PopOperand(node.expression);
+        Add({NodeKind::ASSIGNMENT, TT::END, Lower(node.variable), value});
+    }
+    void visit(Binary &node) override {
+        NodeIndex right = PopOperand(node.right_expression);
+        NodeIndex left = PopOperand(node.left_expression);
+        Add({NodeKind::BINARY, node.op, left, right});
+    }
+    void visit(Unary &node) override { Add({NodeKind::UNARY, node.op, PopOperand(node.expression)}); }
+    void visit(Call &node) override {
+        NodeIndex arguments = NO_NODE;
+        if (node.arguments != nullptr) {
+            auto& expressions = node.arguments->expressions;
+            std::vector<NodeIndex> children(expressions.size());
+            for (size_t i = expressions.size(); i-- > 0;) children[i] = PopOperand(expressions[i]);
+            AddChildren(NodeKind::ARGUMENTS, children);
+            arguments = Pop();
+        }
+        Add({NodeKind::CALL, TT::END, Lower(node.callee), arguments});
+    }
+    void visit(Identifier &node) override {
+        ast_.names_.push_back(node.name);
+        Add({NodeKind::IDENTIFIER, TT::END, node.symbol, static_cast<uint32_t>(ast_.names_.size() - 1)});
+    }
+    void visit(Literal &node) override {
+        ast_.values_.push_back(node.value);
+        Add({NodeKind::LITERAL, TT::END, static_cast<uint32_t>(ast_.values_.size() - 1)});
+    }
+    void visit(Parameters &node) override { AddList(NodeKind::PARAMETERS, node.identifiers); }
+    void visit(Arguments &node) override { AddList(NodeKind::ARGUMENTS, node.expressions); }
+private:
+    template <typename T>
+    NodeIndex Lower(T* node) {
+        if (node == nullptr) return NO_NODE;
+        if constexpr (std::is_base_of_v<Expression, T>) VisitExpression(node, *this);
+        else node->accept(*this);
+        return Pop();
+    }
+
+    // The walk skips null operands, so they have nothing on results_
+    NodeIndex PopOperand(ExpressionPtr operand) {
+        return operand == nullptr ? NO_NODE : Pop();
+    }
+
+    NodeIndex Pop() {
+        NodeIndex index = results_.back();
+        results_.pop_back();
+        return index;
+    }
+
+    void Add(FlatNode node) {
+        ast_.nodes_.push_back(node);
+        results_.push_back(static_cast<NodeIndex>(ast_.nodes_.size() - 1));
+    }
+
+    // The children are lowered first, since lowering them may append lists of their own
+    template <typename T>
+    void AddList(NodeKind kind, const std::pmr::vector<T*>& nodes) {
+        std::vector<NodeIndex> children;
+        children.reserve(nodes.size());
+        for (auto* node : nodes) children.push_back(Lower(node));
+        AddChildren(kind, children);
+    }
+
+    void AddChildren(NodeKind kind, const std::vector<NodeIndex>& children) {
+        auto start = static_cast<uint32_t>(ast_.children_.size());
+        ast_.children_.insert(ast_.children_.end(), children.begin(), children.end());
+        Add({kind, TT::END, start, static_cast<uint32_t>(children.size())});
+    }
+private:
+    FlatAST& ast_;
+    std::vector<NodeIndex> results_;
+};
+
+FlatAST FlatAST::Build(Program &program) {
+    FlatAST ast;
+    ast.nodes_.reserve(CountASTNodes(program)); // Exact, and much cheaper than growing the largest table
+    FlatASTBuilder builder(ast);
+    program.accept(builder);
+    ast.children_.shrink_to_fit();
+    ast.values_.shrink_to_fit();
+    ast.names_.shrink_to_fit();
+    return ast;
+}
+
+size_t FlatAST::MemoryUsage() const {
+    return nodes_.capacity() * sizeof(FlatNode) + children_.capacity() * sizeof(NodeIndex) +
+           values_.capacity() * sizeof(Value) + names_.capacity() * sizeof(std::string_view);
+}
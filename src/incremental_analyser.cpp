@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "incremental_analyser.h"
+#include "ast_walk.h"
+#include "parser.h"
+#include "semantic_analyser.h"
+
+namespace {
+    // Re-interns every name of a declaration into the shared Interner, and collects them
+    class NameResolver : public ASTVisitor {
+    public:
+        NameResolver(Interner& interner, std::deque<std::string>& names, std::vector<SymbolId>& uses)
+            : interner_(interner), names_(names), uses_(uses) {}
+        void visit(Program &node) override {
+            for (auto& declaration : node.declarations) declaration->accept(*this);
+        }
+        void visit(FunDecl &node) override {
+            Resolve(node.name);
+            if (node.parameters != nullptr) node.parameters->accept(*this);
+            if (node.body != nullptr) node.body->accept(*this);
+        }
+        void visit(VarDecl &node) override {
+            Resolve(node.variable);
+            VisitExpression(node.expression, *this);
+        }
+        void visit(ExprStmt &node) override { VisitExpression(node.expression, *this); }
+        void visit(IfStmt &node) override {
+            VisitExpression(node.condition, *this);
+            if (node.if_body != nullptr) node.if_body->accept(*this);
+            if (node.else_body != nullptr) node.else_body->accept(*this);
+        }
+        void visit(PrintStmt &node) override { VisitExpression(node.expression, *this); }
+        void visit(ReturnStmt &node) override { VisitExpression(node.expression, *this); }
+        void visit(WhileStmt &node) override {
+            VisitExpression(node.condition, *this);
+            if (node.body != nullptr) node.body->accept(*this);
+        }
+        void visit(Block &node) override {
+            for (auto& declaration : node.declarations) declaration->accept(*this);
+        }
+        void visit(Assignment &node) override { Resolve(node.variable); }
+        void visit(Binary &node) override {}
+        void visit(Unary &node) override {}
+        void visit(Call &node) override { Resolve(node.callee); }
+        void visit(Identifier &node) override { Resolve(&node); }
+        void visit(Literal &node) override {}
+        void visit(Parameters &node) override {
+            for (auto& identifier : node.identifiers) Resolve(identifier);
+        }
+        void visit(Arguments &node) override {}
+    private:
+        // Identifiers made from the wrong token after a parse error have no symbol, and keep it that way
+        void Resolve(IdentifierPtr identifier) {
+            if (identifier == nullptr || identifier->symbol == NO_SYMBOL) return;
+            SymbolId symbol = interner_.Find(identifier->name);
+            if (symbol == NO_SYMBOL) symbol = interner_.Intern(names_.emplace_back(identifier->name));
+            identifier->symbol = symbol;
+            uses_.push_back(symbol);
+        }
+    private:
+        Interner& interner_;
+        std::deque<std::string>& names_;
+        std::vector<SymbolId>& uses_;
+    };
+}
+
+IncrementalAnalyser::IncrementalAnalyser(std::string_view source_code) {
+    ParseUnits(std::make_shared<const std::string>(source_code), 0, {}, units_);
+    Renumber(0);
+    for (auto& unit : units_) {
+        Resolve(*unit);
+        AddDeclaration(*unit);
+    }
+    for (auto& unit : units_) Analyse(*unit);
+    last_edit_.reparsed_count = units_.size();
+}
+
+void IncrementalAnalyser::Edit(size_t offset, size_t removed_length, std::string_view inserted_text) {
+    size_t source_size = units_.empty() ? 0 : units_.back()->begin + units_.back()->text.size();
+    if (offset > source_size || removed_length > source_size - offset) {
+        throw std::out_of_range("Edit outside of the source");
+    }
+    last_edit_ = {};
+
+    // The units the edit touches, and the one before them, since the edit can change where that one ends
+    size_t first = units_.empty() ? 0 : FindUnit(offset);
+    if (first > 0) first--;
+    size_t last = units_.empty() ? 0 : FindUnit(offset + removed_length) + 1;
+    std::string region;
+    for (size_t i = first; i < last; i++) region += units_[i]->text;
+    size_t region_begin = first < units_.size() ? units_[first]->begin : 0;
+    region.replace(offset - region_begin, removed_length, inserted_text);
+    size_t line = first < units_.size() ? units_[first]->line : 0;
+
+    // The edited text is parsed together with a growing number of the units after it, until a unit ends
+    // where an old one starts. The Parser looks one token ahead, so that start has to be followed by the
+    // rest of the old unit for the parse to be the one the whole file would get
+    std::vector<UnitPtr> parsed;
+    size_t end = last; // Old units [first, end) get replaced
+    for (size_t lookahead_count = 1; ; lookahead_count *= 2) {
+        size_t lookahead_end = std::min(units_.size(), last + lookahead_count);
+        auto buffer = std::make_shared<std::string>(region);
+        std::vector<size_t> boundaries;
+        for (size_t i = last; i < lookahead_end; i++) {
+            boundaries.push_back(buffer->size());
+            *buffer += units_[i]->text;
+        }
+        parsed.clear();
+        size_t resync = ParseUnits(buffer, line, boundaries, parsed);
+        last_edit_.reparsed_count += parsed.size();
+        if (resync < boundaries.size() || lookahead_end == units_.size()) {
+            end = last + resync;
+            break;
+        }
+    }
+
+    // Units declaring something else than the units they replace can change the errors of any unit that
+    // uses those names
+    std::vector<SymbolId> changed_names;
+    bool signatures_changed = end - first != parsed.size();
+    for (size_t i = 0; i < parsed.size(); i++) {
+        Resolve(*parsed[i]);
+        if (!signatures_changed) signatures_changed = parsed[i]->signature != units_[first + i]->signature;
+    }
+    for (size_t i = first; i < end; i++) {
+        error_count_ -= units_[i]->errors.size();
+        RemoveDeclaration(*units_[i]);
+        if (signatures_changed) changed_names.push_back(units_[i]->signature.symbol);
+    }
+    for (auto& unit : parsed) {
+        AddDeclaration(*unit);
+        if (signatures_changed) changed_names.push_back(unit->signature.symbol);
+    }
+    std::erase(changed_names, NO_SYMBOL);
+
+    size_t parsed_count = parsed.size();
+    units_.erase(units_.begin() + first, units_.begin() + end);
+    units_.insert(units_.begin() + first, std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+    Renumber(first);
+
+    for (size_t i = first; i < first + parsed_count; i++) Analyse(*units_[i]);
+    if (changed_names.empty()) return;
+    for (size_t i = 0; i < units_.size(); i++) {
+        if (i == first) i += parsed_count;
+        if (i == units_.size()) break;
+        const auto& uses = units_[i]->uses;
+        bool affected = std::any_of(changed_names.begin(), changed_names.end(), [&](SymbolId symbol) {
+            return std::binary_search(uses.begin(), uses.end(), symbol);
+        });
+        if (affected) Analyse(*units_[i]);
+    }
+}
+
+std::string IncrementalAnalyser::GetSource() const {
+    std::string source_code;
+    for (const auto& unit : units_) source_code += unit->text;
+    return source_code;
+}
+
+std::vector<std::string> IncrementalAnalyser::GetErrors() const {
+    std::vector<std::string> errors;
+    errors.reserve(error_count_);
+    for (const auto& unit : units_) errors.insert(errors.end(), unit->errors.begin(), unit->errors.end());
+    return errors;
+}
+
+size_t IncrementalAnalyser::GetErrorCount() const {
+    return error_count_;
+}
+
+size_t IncrementalAnalyser::GetParseErrorCount() const {
+    return std::count_if(units_.begin(), units_.end(), [](const auto& unit) { return unit->had_parse_error; });
+}
+
+size_t IncrementalAnalyser::GetUnitCount() const {
+    return units_.size();
+}
+
+const IncrementalAnalyser::EditStats& IncrementalAnalyser::GetLastEditStats() const {
+    return last_edit_;
+}
+
+size_t IncrementalAnalyser::ParseUnits(const std::shared_ptr<const std::string>& buffer, size_t line,
+                                       const std::vector<size_t>& boundaries, std::vector<UnitPtr>& units) {
+    std::string_view source_code = *buffer;
+    size_t start = 0; // Of the next unit's text
+    size_t next_boundary = 0;
+    auto parser = std::make_unique<Parser>(source_code, 0, line);
+    while (auto program = parser->GenerateNextDeclaration()) {
+        size_t end = parser->GetOffset();
+        auto unit = std::make_unique<Unit>();
+        unit->buffer = buffer;
+        unit->text = source_code.substr(start, end - start);
+        unit->newline_count = std::count(unit->text.begin(), unit->text.end(), '\n');
+        unit->program = std::move(program);
+        unit->had_parse_error = parser->HadError();
+        line += unit->newline_count;
+        start = end;
+        units.push_back(std::move(unit));
+
+        while (next_boundary < boundaries.size() && boundaries[next_boundary] < end) next_boundary++;
+        if (next_boundary < boundaries.size() && boundaries[next_boundary] == end) return next_boundary;
+        // The Parser doesn't recover from errors, a new one carries on with the next declaration
+        if (units.back()->had_parse_error) parser = std::make_unique<Parser>(source_code, end, line);
+    }
+
+    // Only whitespace is left, which goes to the last unit
+    if (start < source_code.size()) {
+        if (units.empty()) {
+            units.push_back(std::make_unique<Unit>());
+            units.back()->buffer = buffer;
+        }
+        Unit& unit = *units.back();
+        size_t unit_start = unit.text.empty() ? 0 : unit.text.data() - source_code.data();
+        unit.text = source_code.substr(unit_start);
+        unit.newline_count = std::count(unit.text.begin(), unit.text.end(), '\n');
+    }
+    return boundaries.size();
+}
+
+void IncrementalAnalyser::Resolve(Unit& unit) {
+    if (unit.program == nullptr) return;
+    NameResolver resolver(interner_, names_, unit.uses);
+    unit.program->accept(resolver);
+    std::sort(unit.uses.begin(), unit.uses.end());
+    unit.uses.erase(std::unique(unit.uses.begin(), unit.uses.end()), unit.uses.end());
+
+    Declaration* declaration = unit.program->declarations.front();
+    if (auto* function = dynamic_cast<FunDecl*>(declaration)) {
+        size_t parameter_count = function->parameters == nullptr ? 0 : function->parameters->identifiers.size();
+        unit.signature = {function->name->symbol, SymbolType::FUNCTION, parameter_count};
+    } else if (auto* variable = dynamic_cast<VarDecl*>(declaration)) {
+        unit.signature = {variable->variable->symbol, SymbolType::VARIABLE, 0};
+    }
+}
+
+void IncrementalAnalyser::Analyse(Unit& unit) {
+    last_edit_.reanalysed_count++;
+    error_count_ -= unit.errors.size();
+    unit.errors.clear();
+    if (unit.program == nullptr || unit.had_parse_error) return;
+
+    // The globals the declaration sees are the first declarations of its names in the units before it
+    SemanticAnalyser analyser;
+    analyser.SetDiagnostics(&unit.errors);
+    for (SymbolId symbol : unit.uses) {
+        const Unit* declaration = FindDeclaration(symbol, unit.position);
+        if (declaration == nullptr) continue;
+        std::string_view name = interner_.GetName(symbol);
+        if (declaration->signature.type == SymbolType::FUNCTION) {
+            analyser.DeclareFunction(name, symbol, declaration->signature.parameter_count);
+        } else {
+            analyser.DeclareVariable(name, symbol);
+        }
+    }
+    unit.program->accept(analyser);
+    error_count_ += unit.errors.size();
+}
+
+void IncrementalAnalyser::Renumber(size_t first) {
+    for (size_t i = first; i < units_.size(); i++) {
+        Unit& unit = *units_[i];
+        const Unit* previous = i == 0 ? nullptr : units_[i - 1].get();
+        unit.begin = previous == nullptr ? 0 : previous->begin + previous->text.size();
+        unit.line = previous == nullptr ? 0 : previous->line + previous->newline_count;
+        unit.position = i;
+    }
+}
+
+void IncrementalAnalyser::AddDeclaration(const Unit& unit) {
+    if (unit.signature.symbol != NO_SYMBOL) declarations_[unit.signature.symbol].push_back(&unit);
+}
+
+void IncrementalAnalyser::RemoveDeclaration(const Unit& unit) {
+    if (unit.signature.symbol == NO_SYMBOL) return;
+    auto& declarations = declarations_[unit.signature.symbol];
+    std::erase(declarations, &unit);
+}
+
+const IncrementalAnalyser::Unit* IncrementalAnalyser::FindDeclaration(SymbolId symbol, size_t position) const {
+    auto declarations = declarations_.find(symbol);
+    if (declarations == declarations_.end()) return nullptr;
+    const Unit* first = nullptr;
+    for (const Unit* unit : declarations->second) {
+        if (first == nullptr || unit->position < first->position) first = unit;
+    }
+    return first != nullptr && first->position < position ? first : nullptr;
+}
+
+size_t IncrementalAnalyser::FindUnit(size_t offset) const {
+    auto unit = std::upper_bound(units_.begin(), units_.end(), offset,
+                                 [](size_t offset, const UnitPtr& unit) { return offset < unit->begin; });
+    return unit == units_.begin() ? 0 : unit - units_.begin() - 1;
+}
@@ -0,0 +1,293 @@
+#include <cassert>
+
+#include "inliner.h"
+#include "ast_walk.h"
+
+// The helpers that recurse are only used on function bodies, which are at most threshold nodes big by then.
+// Arguments can be nested arbitrarily deep, so everything applied to them walks iteratively.
+
+// Only these nodes may appear in an inlined body, anything else is rejected
+static bool IsInlinableExpression(const Expression* expression, const Parameters* parameters) {
+    if (dynamic_cast<const Literal*>(expression)) return true;
+    if (const auto* identifier = dynamic_cast<const Identifier*>(expression)) {
+        if (parameters == nullptr) return false;
+        for (auto& parameter : parameters->identifiers) {
+            if (parameter->symbol == identifier->symbol) return true;
+        }
+        return false;
+    }
+    if (const auto* unary = dynamic_cast<const Unary*>(expression)) {
+        return IsInlinableExpression(unary->expression, parameters);
+    }
+    if (const auto* binary = dynamic_cast<const Binary*>(expression)) {
+        return IsInlinableExpression(binary->left_expression, parameters) &&
+               IsInlinableExpression(binary->right_expression, parameters);
+    }
+    return false;
+}
+
+// True if evaluating expression can change state
+static bool HasSideEffects(const Expression* expression) {
+    bool has_side_effects = false;
+    WalkExpression(expression, [&](const Expression* operation) {
+        has_side_effects |= dynamic_cast<const Assignment*>(operation) || dynamic_cast<const Call*>(operation);
+    });
+    return has_side_effects;
+}
+
+static bool ContainsShortCircuit(const Expression* expression) {
+    if (const auto* unary = dynamic_cast<const Unary*>(expression)) return ContainsShortCircuit(unary->expression);
+    if (const auto* binary = dynamic_cast<const Binary*>(expression)) {
+        return binary->op == TT::AND || binary->op == TT::OR ||
+               ContainsShortCircuit(binary->left_expression) || ContainsShortCircuit(binary->right_expression);
+    }
+    return false;
+}
+
+// Collects parameter uses in evaluation order (left to right)
+static void CollectUses(const Expression* expression, const Parameters& parameters, std::vector<size_t>& uses) {
+    if (const auto* identifier = dynamic_cast<const Identifier*>(expression)) {
+        for (size_t i = 0; i < parameters.identifiers.size(); i++) {
+            if (parameters.identifiers[i]->symbol == identifier->symbol) uses.push_back(i);
+        }
+    } else if (const auto* unary = dynamic_cast<const Unary*>(expression)) {
+        CollectUses(unary->expression, parameters, uses);
+    } else if (const auto* binary = dynamic_cast<const Binary*>(expression)) {
+        CollectUses(binary->left_expression, parameters, uses);
+        CollectUses(binary->right_expression, parameters, uses);
+    }
+}
+
+// Clones of the operands are built first and wait on the stack for the operator using them
+static ExpressionPtr Clone(Arena& arena, const Expression* expression) {
+    std::vector<ExpressionPtr> clones;
+    auto pop = [&clones] {
+        ExpressionPtr clone = clones.back();
+        clones.pop_back();
+        return clone;
+    };
+    WalkExpression(expression, [&](const Expression* original) {
+        if (const auto* literal = dynamic_cast<const Literal*>(original)) {
+            auto clone = arena.Make<Literal>();
+            clone->value = literal->value;
+            clones.push_back(clone);
+        } else if (const auto* identifier = dynamic_cast<const Identifier*>(original)) {
+            auto clone = arena.Make<Identifier>();
+            clone->name = identifier->name;
+            clone->symbol = identifier->symbol;
+            clones.push_back(clone);
+        } else if (const auto* unary = dynamic_cast<const Unary*>(original)) {
+            auto clone = arena.Make<Unary>();
+            clone->op = unary->op;
+            clone->expression = pop();
+            clones.push_back(clone);
+        } else {
+            const auto* binary = dynamic_cast<const Binary*>(original);
+            assert(binary != nullptr && "Only pure expressions can be cloned");
+            auto clone = arena.Make<Binary>();
+            clone->op = binary->op;
+            clone->right_expression = pop();
+            clone->left_expression = pop();
+            clones.push_back(clone);
+        }
+    });
+    return clones.back();
+}
+
+// Copies body, replacing parameter i with arguments[i]. Arguments used once are moved, the rest are cloned
+static ExpressionPtr Substitute(Arena& arena, const Expression* body, const Parameters& parameters,
+                                const std::pmr::vector<ExpressionPtr>& arguments, const std::vector<size_t>& use_counts) {
+    if (const auto* identifier = dynamic_cast<const Identifier*>(body)) {
+        for (size_t i = 0; i < parameters.identifiers.size(); i++) {
+            if (parameters.identifiers[i]->symbol != identifier->symbol) continue;
+            return use_counts[i] == 1 ? arguments[i] : Clone(arena, arguments[i]);
+        }
+    }
+    if (const auto* unary = dynamic_cast<const Unary*>(body)) {
+        auto copy = arena.Make<Unary>();
+        copy->op = unary->op;
+        copy->expression = Substitute(arena, unary->expression, parameters, arguments, use_counts);
+        return copy;
+    }
+    if (const auto* binary = dynamic_cast<const Binary*>(body)) {
+        auto copy = arena.Make<Binary>();
+        copy->op = binary->op;
+        copy->left_expression = Substitute(arena, binary->left_expression, parameters, arguments, use_counts);
+        copy->right_expression = Substitute(arena, binary->right_expression, parameters, arguments, use_counts);
+        return copy;
+    }
+    return Clone(arena, body);
+}
+
+static Expression* GetReturnExpression(const FunDecl& function) {
+    if (function.body->declarations.size() != 1) return nullptr;
+    const auto* return_stmt = dynamic_cast<const ReturnStmt*>(function.body->declarations[0]);
+    if (return_stmt == nullptr) return nullptr;
+    return return_stmt->expression;
+}
+
+Inliner::Inliner(size_t threshold)
+    : threshold_(threshold)
+    , inlined_count_(0)
+    , arena_(nullptr) {}
+
+std::string_view Inliner::Name() const {
+    return "inlining";
+}
+
+void Inliner::Run(Program &program) {
+    arena_ = program.arena.get();
+    for (auto& declaration : program.declarations) {
+        CountDeclarations(*declaration);
+    }
+    program.accept(*this);
+}
+
+size_t Inliner::GetInlinedCount() const {
+    return inlined_count_;
+}
+
+void Inliner::visit(Program &node) {
+    for (auto& declaration : node.declarations) {
+        declaration->accept(*this);
+        // Only top-level functions are candidates, nested ones could be shadowed at the call site
+        if (auto* function = dynamic_cast<FunDecl*>(declaration)) {
+            AddCandidate(*function);
+        }
+    }
+}
+
+void Inliner::visit(FunDecl &node) {
+    node.body->accept(*this);
+}
+
+void Inliner::visit(VarDecl &node) {
+    Inline(node.expression);
+}
+
+void Inliner::visit(ExprStmt &node) {
+    Inline(node.expression);
+}
+
+void Inliner::visit(IfStmt &node) {
+    Inline(node.condition);
+    node.if_body->accept(*this);
+    if (node.else_body != nullptr) node.else_body->accept(*this);
+}
+
+void Inliner::visit(PrintStmt &node) {
+    Inline(node.expression);
+}
+
+void Inliner::visit(ReturnStmt &node) {
+    Inline(node.expression);
+}
+
+void Inliner::visit(WhileStmt &node) {
+    Inline(node.condition);
+    node.body->accept(*this);
+}
+
+void Inliner::visit(Block &node) {
+    for (auto& declaration : node.declarations) {
+        declaration->accept(*this);
+    }
+}
+
+// Expressions are handled by Inline, since calls have to be replaced by their parent
+void Inliner::visit(Assignment &node) {}
+void Inliner::visit(Binary &node) {}
+void Inliner::visit(Unary &node) {}
+void Inliner::visit(Call &node) {}
+void Inliner::visit(Identifier &node) {}
+void Inliner::visit(Literal &node) {}
+void Inliner::visit(Parameters &node) {}
+void Inliner::visit(Arguments &node) {}
+
+// The arguments of a call are handled before the call itself
+void Inliner::Inline(ExpressionPtr &expression) {
+    WalkExpression(expression, [this](ExpressionPtr& operation) {
+        if (dynamic_cast<Call*>(operation) && TryInlineCall(operation)) inlined_count_++;
+    });
+}
+
+bool Inliner::TryInlineCall(ExpressionPtr &expression) {
+    auto* call = static_cast<Call*>(expression);
+    const Symbol* symbol = functions_.GetSymbol(call->callee->symbol);
+    if (symbol == nullptr) return false;
+    const auto& function_info = std::get<FunctionInfo>(symbol->object);
+    const FunDecl& function = *function_info.declaration;
+
+    size_t argument_count = call->arguments == nullptr ? 0 : call->arguments->expressions.size();
+    if (argument_count != function_info.parameter_count) return false;
+
+    const Expression* body = GetReturnExpression(function);
+    if (function_info.parameter_count == 0) {
+        expression = Clone(*arena_, body);
+        return true;
+    }
+
+    auto& arguments = call->arguments->expressions;
+    const Parameters& parameters = *function.parameters;
+    std::vector<size_t> uses;
+    CollectUses(body, parameters, uses);
+    std::vector<size_t> use_counts(parameters.identifiers.size(), 0);
+    for (auto use : uses) use_counts[use]++;
+
+    // If any argument has side effects, even reading a variable depends on when it happens.
+    // Every argument that isn't a literal then has to be evaluated exactly once and in the original order.
+    bool has_side_effects = false;
+    for (auto& argument : arguments) has_side_effects |= HasSideEffects(argument);
+    if (has_side_effects) {
+        if (ContainsShortCircuit(body)) return false;
+        std::vector<size_t> expected_order;
+        std::vector<size_t> actual_order;
+        for (size_t i = 0; i < arguments.size(); i++) {
+            if (dynamic_cast<Literal*>(arguments[i])) continue;
+            if (use_counts[i] != 1) return false;
+            expected_order.push_back(i);
+        }
+        for (auto use : uses) {
+            if (!dynamic_cast<Literal*>(arguments[use])) actual_order.push_back(use);
+        }
+        if (expected_order != actual_order) return false;
+    }
+
+    expression = Substitute(*arena_, body, parameters, arguments, use_counts);
+    return true;
+}
+
+void Inliner::AddCandidate(FunDecl &function) {
+    const Identifier& name = *function.name;
+    if (declaration_counts_[name.symbol] != 1) return;
+
+    Expression* body = GetReturnExpression(function);
+    if (body == nullptr) return;
+    size_t body_size = CountASTNodes(*body);
+    if (body_size > threshold_ || !IsInlinableExpression(body, function.parameters)) return;
+
+    size_t parameter_count = function.parameters == nullptr ? 0 : function.parameters->identifiers.size();
+    FunctionInfo function_info = {name.name, parameter_count, &function, body_size};
+    functions_.AddSymbol(name.symbol, {SymbolType::FUNCTION, function_info});
+}
+
+// Counts how often every name is declared anywhere in the program, so that functions which are shadowed
+// by a local variable, parameter or nested function are never inlined.
+void Inliner::CountDeclarations(Declaration &declaration) {
+    if (auto* function = dynamic_cast<FunDecl*>(&declaration)) {
+        declaration_counts_[function->name->symbol]++;
+        if (function->parameters != nullptr) {
+            for (auto& parameter : function->parameters->identifiers) declaration_counts_[parameter->symbol]++;
+        }
+        CountDeclarations(*function->body);
+    } else if (auto* var_decl = dynamic_cast<VarDecl*>(&declaration)) {
+        declaration_counts_[var_decl->variable->symbol]++;
+    } else if (auto* block = dynamic_cast<Block*>(&declaration)) {
+        for (auto& inner : block->declarations) CountDeclarations(*inner);
+    } else if (auto* if_stmt = dynamic_cast<IfStmt*>(&declaration)) {
+        CountDeclarations(*if_stmt->if_body);
+        if (if_stmt->else_body != nullptr) CountDeclarations(*if_stmt->else_body);
+    } else if (auto* while_stmt = dynamic_cast<WhileStmt*>(&declaration)) {
+        CountDeclarations(*while_stmt->body);
+    }
+}
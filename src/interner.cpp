@@ -0,0 +1,64 @@
+#include <cassert>
+
+#include "interner.h"
+
+namespace {
+    constexpr size_t INITIAL_SLOTS = 256;
+}
+
+SymbolId Interner::Intern(std::string_view name) {
+    // Keep the load factor at or below 1/2
+    if ((names_.size() + 1) * 2 > slots_.size()) Grow();
+    size_t hash = Hash(name);
+    size_t slot = FindSlot(name, hash);
+    if (slots_[slot] != NO_SYMBOL) return slots_[slot];
+
+    assert(names_.size() < NO_SYMBOL);
+    auto symbol = static_cast<SymbolId>(names_.size());
+    slots_[slot] = symbol;
+    names_.push_back(name);
+    hashes_.push_back(hash);
+    return symbol;
+}
+
+SymbolId Interner::Find(std::string_view name) const {
+    if (slots_.empty()) return NO_SYMBOL;
+    return slots_[FindSlot(name, Hash(name))];
+}
+
+std::string_view Interner::GetName(SymbolId symbol) const {
+    assert(symbol < names_.size());
+    return names_[symbol];
+}
+
+size_t Interner::Size() const {
+    return names_.size();
+}
+
+// FNV-1a, identifiers are short so this beats std::hash on string_view
+size_t Interner::Hash(std::string_view name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t Interner::FindSlot(std::string_view name, size_t hash) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        SymbolId symbol = slots_[slot];
+        if (symbol == NO_SYMBOL || (hashes_[symbol] == hash && names_[symbol] == name)) return slot;
+    }
+}
+
+void Interner::Grow() {
+    slots_.assign(slots_.empty() ? INITIAL_SLOTS : slots_.size() * 2, NO_SYMBOL);
+    size_t mask = slots_.size() - 1;
+    for (SymbolId symbol = 0; symbol < names_.size(); symbol++) {
+        size_t slot = hashes_[symbol] & mask;
+        while (slots_[slot] != NO_SYMBOL) slot = (slot + 1) & mask;
+        slots_[slot] = symbol;
+    }
+}
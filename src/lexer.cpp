@@ -1,12 +1,152 @@
 #include "lexer.h"
+#include "scan.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 #include <cassert>
 #include <boost/test/unit_test_log.hpp>
 
+namespace {
+    enum class CharClass : uint8_t {
+        INVALID,     // Can't appear outside of strings and comments
+        END,         // '\0'
+        WHITESPACE,  // ' ', '\r', '\t'
+        NEWLINE,
+        DIGIT,
+        ALPHA,       // a-z, A-Z, _
+        QUOTE,
+        SLASH,       // Division, or the start of a comment
+        PUNCTUATION, // Always a single character token
+        OPERATOR,    // A single character token, or a two character token if followed by '='
+    };
+
+    struct CharInfo {
+        CharClass char_class = CharClass::INVALID;
+        TokenType token = TT::ERROR;       // Token for SLASH, PUNCTUATION and OPERATOR
+        TokenType equal_token = TT::ERROR; // Token for OPERATOR followed by '='
+    };
+
+    // Indexed by the unsigned value of a character, replaces std::isdigit/std::isalpha (which are locale
+    // dependent and can't be inlined) and the switch over single characters
+    constexpr std::array<CharInfo, 256> CHAR_TABLE = [] {
+        std::array<CharInfo, 256> table{};
+        auto set = [&](char c, CharClass char_class, TokenType token = TT::ERROR, TokenType equal_token = TT::ERROR) {
+            table[static_cast<uint8_t>(c)] = {char_class, token, equal_token};
+        };
+        set('\0', CharClass::END);
+        set(' ', CharClass::WHITESPACE);
+        set('\r', CharClass::WHITESPACE);
+        set('\t', CharClass::WHITESPACE);
+        set('\n', CharClass::NEWLINE);
+        for (char c = '0'; c <= '9'; c++) set(c, CharClass::DIGIT);
+        for (char c = 'a'; c <= 'z'; c++) set(c, CharClass::ALPHA);
+        for (char c = 'A'; c <= 'Z'; c++) set(c, CharClass::ALPHA);
+        set('_', CharClass::ALPHA);
+        set('"', CharClass::QUOTE);
+        set('/', CharClass::SLASH, TT::SLASH);
+        set('(', CharClass::PUNCTUATION, TT::LEFT_PAREN);
+        set(')', CharClass::PUNCTUATION, TT::RIGHT_PAREN);
+        set('{', CharClass::PUNCTUATION, TT::LEFT_BRACE);
+        set('}', CharClass::PUNCTUATION, TT::RIGHT_BRACE);
+        set(',', CharClass::PUNCTUATION, TT::COMMA);
+        set('.', CharClass::PUNCTUATION, TT::DOT);
+        set('-', CharClass::PUNCTUATION, TT::MINUS);
+        set('+', CharClass::PUNCTUATION, TT::PLUS);
+        set(';', CharClass::PUNCTUATION, TT::SEMICOLON);
+        set('*', CharClass::PUNCTUATION, TT::STAR);
+        set('!', CharClass::OPERATOR, TT::BANG, TT::BANG_EQUAL);
+        set('=', CharClass::OPERATOR, TT::EQUAL, TT::EQUAL_EQUAL);
+        set('>', CharClass::OPERATOR, TT::GREATER, TT::GREATER_EQUAL);
+        set('<', CharClass::OPERATOR, TT::LESS, TT::LESS_EQUAL);
+        return table;
+    }();
+
+    constexpr const CharInfo& GetCharInfo(char c) {
+        return CHAR_TABLE[static_cast<uint8_t>(c)];
+    }
+
+    constexpr bool IsDigit(char c) {
+        return GetCharInfo(c).char_class == CharClass::DIGIT;
+    }
+
+    constexpr bool IsIdentifierChar(char c) {
+        auto char_class = GetCharInfo(c).char_class;
+        return char_class == CharClass::ALPHA || char_class == CharClass::DIGIT;
+    }
+
+    // Perfect hash over the keywords, keyed on the first two characters and the length (which are unique
+    // for every keyword). The multiplier is searched for at compile time, so adding a keyword either still
+    // produces a collision free table or fails the static_assert below.
+    constexpr size_t KEYWORD_TABLE_BITS = 5;
+    constexpr size_t KEYWORD_TABLE_SIZE = 1 << KEYWORD_TABLE_BITS;
+    constexpr size_t MIN_KEYWORD_LENGTH = 2;
+    constexpr size_t MAX_KEYWORD_LENGTH = 6;
+    static_assert(MIN_KEYWORD_LENGTH >= 2, "KeywordHash reads the first two characters");
+
+    constexpr size_t KeywordHash(std::string_view lexeme, uint32_t multiplier) {
+        uint32_t key = static_cast<uint32_t>(static_cast<uint8_t>(lexeme[0])) << 16
+                     | static_cast<uint32_t>(static_cast<uint8_t>(lexeme[1])) << 8
+                     | static_cast<uint32_t>(lexeme.size());
+        return (key * multiplier) >> (32 - KEYWORD_TABLE_BITS);
+    }
+
+    constexpr bool IsCollisionFree(uint32_t multiplier) {
+        std::array<bool, KEYWORD_TABLE_SIZE> used{};
+        for (const auto& [keyword, type] : KEYWORDS) {
+            size_t slot = KeywordHash(keyword, multiplier);
+            if (used[slot]) return false;
+            used[slot] = true;
+        }
+        return true;
+    }
+
+    constexpr uint32_t KEYWORD_MULTIPLIER = [] {
+        for (uint32_t multiplier = 0x9E3779B1; multiplier != 0x9E3779B1 + 100000; multiplier += 2) {
+            if (IsCollisionFree(multiplier)) return multiplier;
+        }
+        return 0u;
+    }();
+    static_assert(KEYWORD_MULTIPLIER != 0, "No collision free multiplier for KEYWORDS");
+
+    struct KeywordEntry {
+        std::string_view keyword; // Empty for unused slots
+        TokenType type = TT::IDENTIFIER;
+    };
+
+    constexpr std::array<KeywordEntry, KEYWORD_TABLE_SIZE> KEYWORD_TABLE = [] {
+        std::array<KeywordEntry, KEYWORD_TABLE_SIZE> table{};
+        for (const auto& [keyword, type] : KEYWORDS) {
+            table[KeywordHash(keyword, KEYWORD_MULTIPLIER)] = {keyword, type};
+        }
+        return table;
+    }();
+
+    constexpr bool KeywordLengthsInRange() {
+        for (const auto& [keyword, type] : KEYWORDS) {
+            if (keyword.size() < MIN_KEYWORD_LENGTH || keyword.size() > MAX_KEYWORD_LENGTH) return false;
+        }
+        return true;
+    }
+    static_assert(KeywordLengthsInRange(), "MIN_KEYWORD_LENGTH/MAX_KEYWORD_LENGTH don't cover KEYWORDS");
+}
+
+TokenType LookupKeyword(std::string_view lexeme) {
+    if (lexeme.size() < MIN_KEYWORD_LENGTH || lexeme.size() > MAX_KEYWORD_LENGTH) return TT::IDENTIFIER;
+    const KeywordEntry& entry = KEYWORD_TABLE[KeywordHash(lexeme, KEYWORD_MULTIPLIER)];
+    return entry.keyword == lexeme ? entry.type : TT::IDENTIFIER;
+}
+
 Lexer::Lexer(std::string_view source_code)
+    : Lexer(source_code, 0, 0)
+{}
+
+Lexer::Lexer(std::string_view source_code, size_t start_index, size_t start_line)
     : source_code_(source_code)
-    , cur_index_(0)
-    , start_index_(0)
-    , cur_line_(0)
+    , cur_index_(start_index)
+    , start_index_(start_index)
+    , cur_line_(start_line)
 {}
 
 std::vector<Token> Lexer::TokenizeAll() {
@@ -23,56 +163,45 @@ std::vector<Token> Lexer::TokenizeAll() {
     return tokens;
 }
 
+TokenBuffer Lexer::TokenizeToBuffer() {
+    TokenBuffer tokens(source_code_);
+    tokens.Reserve(TokenBuffer::EstimateTokenCount(source_code_.size()));
+    while (true) {
+        SkipWhitespace();
+        if (IsAtEnd()) {
+            start_index_ = cur_index_;
+            tokens.Push(CreateToken(TT::END), start_index_);
+            break;
+        }
+        auto token = ReadNextToken();
+        tokens.Push(token, start_index_);
+    }
+    tokens.ShrinkToFit();
+    return tokens;
+}
+
+size_t Lexer::GetTokenStart() const {
+    return start_index_;
+}
+
+const Interner& Lexer::GetInterner() const {
+    return interner_;
+}
+
 Token Lexer::ReadNextToken() {
     SkipWhitespace();
     start_index_ = cur_index_;
     char c = Advance();
+    const CharInfo& info = GetCharInfo(c);
 
-    if (std::isdigit(c)) return ReadNumber();
-    if (std::isalpha(c) || c == '_') return ReadIdentifier();
-
-    switch (c) {
-        case '(': return CreateToken(TT::LEFT_PAREN);
-        case ')': return CreateToken(TT::RIGHT_PAREN);
-        case '{': return CreateToken(TT::LEFT_BRACE);
-        case '}': return CreateToken(TT::RIGHT_BRACE);
-        case ',': return CreateToken(TT::COMMA);
-        case '.': return CreateToken(TT::DOT);
-        case '-': return CreateToken(TT::MINUS);
-        case '+': return CreateToken(TT::PLUS);
-        case ';': return CreateToken(TT::SEMICOLON);
-        case '/': return CreateToken(TT::SLASH);
-        case '*': return CreateToken(TT::STAR);
-        case '!': {
-            if (Peek() == '=') {
-                Advance();
-                return CreateToken(TT::BANG_EQUAL);
-            }
-            return CreateToken(TT::BANG);
-        }
-        case '=': {
-            if (Peek() == '=') {
-                Advance();
-                return CreateToken(TT::EQUAL_EQUAL);
-            }
-            return CreateToken(TT::EQUAL);
-        }
-        case '>': {
-            if (Peek() == '=') {
-                Advance();
-                return CreateToken(TT::GREATER_EQUAL);
-            }
-            return CreateToken(TT::GREATER);
-        }
-        case '<': {
-            if (Peek() == '=') {
-                Advance();
-                return CreateToken(TT::LESS_EQUAL);
-            }
-            return CreateToken(TT::LESS);
-        }
-        case '"': return ReadString();
-        case '\0': return CreateToken(TT::END);
+    switch (info.char_class) {
+        case CharClass::DIGIT: return ReadNumber();
+        case CharClass::ALPHA: return ReadIdentifier();
+        case CharClass::QUOTE: return ReadString();
+        case CharClass::SLASH:
+        case CharClass::PUNCTUATION: return CreateToken(info.token);
+        case CharClass::OPERATOR: return CreateToken(Match('=') ? info.equal_token : info.token);
+        case CharClass::END: return CreateToken(TT::END);
         default: return CreateErrorToken("Invalid Character");
     }
 }
@@ -93,19 +222,20 @@ bool Lexer::Match(char expected) {
     return true;
 }
 
-// Returns the value of the current character without incrementing the pointer
+// Returns the value of the current character without incrementing the pointer, '\0' past the end of the source
 char Lexer::Peek() const {
-    return source_code_[cur_index_];
+    return cur_index_ < source_code_.size() ? source_code_[cur_index_] : '\0';
 }
 
-// Returns the value of the next character without incrementing the pointer
+// Returns the value of the next character without incrementing the pointer, '\0' past the end of the source
 char Lexer::PeekNext() const {
-    return source_code_[cur_index_ + 1];
+    return cur_index_ + 1 < source_code_.size() ? source_code_[cur_index_ + 1] : '\0';
 }
 
-// Checks if the current character is the null terminator
+// Checks if the lexer reached the end of the source or a null character. The source doesn't need to be
+// null terminated, so memory mapped files can be lexed in place.
 bool Lexer::IsAtEnd() const {
-    return source_code_[cur_index_] == '\0';
+    return Peek() == '\0';
 }
 
 Token Lexer::CreateToken(TT type) {
@@ -125,11 +255,11 @@ template Token Lexer::CreateErrorToken<19>(const char(&msg)[19]); // "Unterminat
 
 Token Lexer::ReadNumber() {
     // read digits until it finds non-digit
-    while (std::isdigit(Peek())) Advance();
+    while (IsDigit(Peek())) Advance();
 
-    if (Peek() == '.' && std::isdigit(PeekNext())) {
+    if (Peek() == '.' && IsDigit(PeekNext())) {
         Advance(); // consume '.'
-        while (std::isdigit(Peek())) Advance();
+        while (IsDigit(Peek())) Advance();
     }
 
     return CreateToken(TT::NUMBER);
@@ -137,10 +267,7 @@ Token Lexer::ReadNumber() {
 
 Token Lexer::ReadString() {
     size_t ending_line = cur_line_; // only used for multiline strings
-    while (!IsAtEnd() && Peek() != '"') {
-        if (Peek() == '\n') ending_line++;
-        Advance();
-    }
+    cur_index_ = Scan::FindStringEnd(source_code_, cur_index_, ending_line);
 
     if (IsAtEnd()) { // If the string never terminated
         auto token = CreateErrorToken("Unterminated String");
@@ -155,37 +282,125 @@ Token Lexer::ReadString() {
 }
 
 Token Lexer::ReadIdentifier() {
-    while (std::isalpha(Peek()) || std::isdigit(Peek()) || Peek() == '_') Advance();
+    while (IsIdentifierChar(Peek())) Advance();
     auto token = CreateToken(TT::IDENTIFIER);
-    auto lexeme_str = std::string(token.lexeme);
-    if (KEYWORDS.contains(lexeme_str)) {
-        token.type = KEYWORDS.at(lexeme_str);
-    }
+    token.type = LookupKeyword(token.lexeme);
+    if (token.type == TT::IDENTIFIER) token.symbol = interner_.Intern(token.lexeme);
     return token;
 }
 
 void Lexer::SkipWhitespace() {
     while (true) {
-        char c = Peek();
-        switch (c) {
-            case ' ':
-            case '\r':
-            case '\t':
-                Advance();
-            break;
-            case '\n':
-                Advance();
-                cur_line_++;
-            break;
-            case '/':
-                if (PeekNext() == '/') {
-                    while (Peek() != '\n' && !IsAtEnd()) Advance();
-                } else {
-                    return;
-                }
-            break;
-            default:
-                return;
+        cur_index_ = Scan::SkipWhitespace(source_code_, cur_index_, cur_line_);
+        if (Peek() != '/' || PeekNext() != '/') return;
+        cur_index_ = Scan::FindLineEnd(source_code_, cur_index_);
+    }
+}
+
+TokenBuffer::TokenBuffer(std::string_view source_code)
+    : source_code_(source_code) {
+    if (source_code.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("TokenBuffer only supports sources up to 4GB");
+    }
+}
+
+// Dense code averages 6-7 bytes per token, so this rarely has to grow. Pages that are reserved but never
+// written aren't resident, and ShrinkToFit returns the rest once the source is tokenized.
+size_t TokenBuffer::EstimateTokenCount(size_t source_size) {
+    return source_size / 4 + 16;
+}
+
+void TokenBuffer::Reserve(size_t token_count) {
+    types_.reserve(token_count);
+    symbols_.reserve(token_count);
+    offsets_.reserve(token_count);
+    lengths_.reserve(token_count);
+}
+
+void TokenBuffer::Push(const Token& token, size_t offset) {
+    types_.push_back(token.type);
+    symbols_.push_back(token.symbol);
+    offsets_.push_back(static_cast<uint32_t>(offset));
+    if (token.type == TT::ERROR) {
+        // The lexeme of an error token is its message rather than part of the source, so it is kept aside
+        lengths_.push_back(static_cast<uint32_t>(errors_.size()));
+        errors_.push_back({token.lexeme, token.line});
+        return;
+    }
+    assert(token.lexeme.data() == source_code_.data() + offset);
+    lengths_.push_back(static_cast<uint32_t>(token.lexeme.size()));
+}
+
+void TokenBuffer::Append(const TokenBuffer& other, size_t begin, size_t end, size_t error_line_offset,
+                         const std::vector<SymbolId>& symbol_map) {
+    assert(other.source_code_.data() == source_code_.data());
+    for (size_t i = begin; i < end; i++) {
+        types_.push_back(other.types_[i]);
+        SymbolId symbol = other.symbols_[i];
+        symbols_.push_back(symbol == NO_SYMBOL ? NO_SYMBOL : symbol_map[symbol]);
+        offsets_.push_back(other.offsets_[i]);
+        if (other.types_[i] == TT::ERROR) {
+            const ErrorToken& error = other.errors_[other.lengths_[i]];
+            lengths_.push_back(static_cast<uint32_t>(errors_.size()));
+            errors_.push_back({error.message, error.line + error_line_offset});
+        } else {
+            lengths_.push_back(other.lengths_[i]);
         }
     }
 }
+
+void TokenBuffer::ShrinkToFit() {
+    types_.shrink_to_fit();
+    symbols_.shrink_to_fit();
+    offsets_.shrink_to_fit();
+    lengths_.shrink_to_fit();
+    errors_.shrink_to_fit();
+}
+
+size_t TokenBuffer::Size() const {
+    return types_.size();
+}
+
+uint32_t TokenBuffer::GetOffset(size_t index) const {
+    return offsets_[index];
+}
+
+TokenType TokenBuffer::GetType(size_t index) const {
+    return types_[index];
+}
+
+SymbolId TokenBuffer::GetSymbol(size_t index) const {
+    return symbols_[index];
+}
+
+std::string_view TokenBuffer::GetLexeme(size_t index) const {
+    if (types_[index] == TT::ERROR) return errors_[lengths_[index]].message;
+    return source_code_.substr(offsets_[index], lengths_[index]);
+}
+
+size_t TokenBuffer::GetLine(size_t index) const {
+    if (types_[index] == TT::ERROR) return errors_[lengths_[index]].line;
+    if (!has_line_index_) BuildLineIndex();
+    // The line of a token is the number of newlines before its first character
+    auto it = std::lower_bound(newline_offsets_.begin(), newline_offsets_.end(), offsets_[index]);
+    return it - newline_offsets_.begin();
+}
+
+Token TokenBuffer::Get(size_t index) const {
+    return {GetType(index), GetLexeme(index), GetLine(index), GetSymbol(index)};
+}
+
+size_t TokenBuffer::MemoryUsage() const {
+    return types_.capacity() * sizeof(TokenType) + symbols_.capacity() * sizeof(SymbolId) +
+           offsets_.capacity() * sizeof(uint32_t) + lengths_.capacity() * sizeof(uint32_t) +
+           errors_.capacity() * sizeof(ErrorToken) + newline_offsets_.capacity() * sizeof(uint32_t);
+}
+
+void TokenBuffer::BuildLineIndex() const {
+    const char* begin = source_code_.data();
+    const char* end = begin + source_code_.size();
+    for (const char* it = begin; (it = static_cast<const char*>(std::memchr(it, '\n', end - it))) != nullptr; it++) {
+        newline_offsets_.push_back(static_cast<uint32_t>(it - begin));
+    }
+    has_line_index_ = true;
+}
@@ -1,29 +1,167 @@
+#include <charconv>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <vector>
 
 #include "lexer.h"
 #include "ast.h"
+#include "ast_cache.h"
 #include "compiler.h"
 #include "parser.h"
 #include "debug.h"
+#include "pass_manager.h"
 #include "semantic_analyser.h"
+#include "source_file.h"
+#include "verifier.h"
 #include "vm.h"
 
-int main() {
-    std::string source_code = R"(
-        1 + 2 + 3 == 3 - 2 - 1;
-    )";
-    Parser parser(source_code);
-    auto ast = parser.GenerateAST();
-    SemanticAnalyser analyser;
-    ast->accept(analyser);
+static void PrintUsage() {
+    std::cerr << "Usage: clox [-O0 | -O1 | -O2] [--disable-pass=<name>]... [--time-passes] [--single-pass | --stream | --lazy] [--lexer-thread] [--threads=<n>] [--ast-cache=<dir>] [script | -]\n";
+}
 
-    Compiler compiler;
-    Chunk chunk = compiler.Compile(ast.get());
-    std::cout << Debug::GetChunkStr(chunk) << std::endl << std::endl << std::endl;
-    VM vm(chunk);
+// Parses a positive number, returns false if value isn't one
+static bool ParseCount(std::string_view value, size_t& count) {
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), count);
+    return error == std::errc() && end == value.data() + value.size() && count > 0;
+}
+
+int main(int argc, char* argv[]) {
+    OptLevel opt_level = OptLevel::O1;
+    std::vector<std::string_view> disabled_passes;
+    bool time_passes = false;
+    bool single_pass = false; // Skips the AST, and with it the AST passes
+    bool streaming = false;   // Compiles and runs one top-level declaration at a time
+    bool lazy = false;         // Analyses and compiles function bodies only once they are called
+    bool lexer_thread = false; // Lexes on a separate thread while parsing
+    size_t thread_count = 1;   // Threads for analysing and compiling function bodies
+    std::optional<ASTCache> ast_cache; // Reuses the AST of scripts that were checked before
+    std::string path = "-"; // Reads the script from stdin if no path is given
+    bool has_path = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "-O0") opt_level = OptLevel::O0;
+        else if (arg == "-O1") opt_level = OptLevel::O1;
+        else if (arg == "-O2") opt_level = OptLevel::O2;
+        else if (arg == "--time-passes") time_passes = true;
+        else if (arg == "--single-pass") single_pass = true;
+        else if (arg == "--stream") streaming = true;
+        else if (arg == "--lazy") lazy = true;
+        else if (arg == "--lexer-thread") lexer_thread = true;
+        else if (arg.starts_with("--threads=") && ParseCount(arg.substr(arg.find('=') + 1), thread_count)) continue;
+        else if (arg.starts_with("--ast-cache=") && arg.size() > 12) ast_cache.emplace(std::string(arg.substr(12)));
+        else if (arg.starts_with("--disable-pass=")) disabled_passes.push_back(arg.substr(arg.find('=') + 1));
+        else if (!has_path && (arg == "-" || !arg.starts_with("-"))) {
+            path = arg;
+            has_path = true;
+        } else {
+            PrintUsage();
+            return 64;
+        }
+    }
+
+    // Neither mode builds a whole AST to cache
+    if (single_pass + streaming + lazy > 1 || (ast_cache && (single_pass || streaming))) {
+        PrintUsage();
+        return 64;
+    }
+
+    // Declared first so that it outlives the tokens, AST and chunk, which all point into it
+    std::optional<SourceFile> source_file;
+    try {
+        source_file = SourceFile::Open(path);
+    } catch (const std::runtime_error& error) {
+        std::cerr << "[IO ERROR]: " << error.what() << std::endl;
+        return 74;
+    }
+
+    PassManager pass_manager = PassManager::CreateDefault(opt_level);
+    for (auto pass_name : disabled_passes) {
+        pass_manager.DisablePass(pass_name);
+    }
+
+    // Only made when the script is parsed, a cached AST needs no Parser
+    std::optional<Parser> parser;
+    SemanticAnalyser analyser;
+    Verifier verifier;
+    Chunk chunk;
+    std::vector<Chunk> functions; // Only compiled separately in lazy mode
+    VM vm;
     Logger logger(LogLevel::DEBUG);
     vm.SetDebug(std::move(logger));
-    vm.Interpret();
+
+    // Parse errors have already been reported by the Parser, and a tree with errors is never compiled.
+    // The Compiler throws std::logic_error subclasses for what it can't compile yet
+    try {
+        if (streaming) {
+            // Each top-level declaration is compiled and run before the next one is parsed, and its AST is freed
+            // before it runs. The analyser and the VM stack carry what earlier declarations declared
+            parser.emplace(source_file->GetText(), lexer_thread);
+            while (auto declaration = parser->GenerateNextDeclaration()) {
+                if (parser->HadError()) return 65;
+                declaration->accept(analyser);
+                pass_manager.RunASTPasses(*declaration);
+                Compiler compiler;
+                Chunk chunk = compiler.Compile(declaration.get());
+                declaration.reset();
+                pass_manager.RunBytecodePasses(chunk);
+                if (!verifier.Verify(chunk, vm.GetStackDepth())) return 70;
+
+                std::cout << Debug::GetChunkStr(chunk) << std::endl;
+                if (!vm.Interpret(chunk)) break;
+            }
+            if (parser->HadError()) return 65;
+            if (time_passes) std::cerr << Debug::GetPassStatsStr(pass_manager.GetStats()) << std::endl;
+            return 0;
+        }
+
+        if (single_pass) {
+            parser.emplace(source_file->GetText(), lexer_thread);
+            chunk = parser->GenerateChunk(analyser);
+            if (parser->HadError()) return 65;
+        } else if (lazy) {
+            // Function bodies are only analysed once called, so a miss can't be stored, but a hit is safe to use
+            ProgramPtr ast = ast_cache ? ast_cache->Load(source_file->GetText()) : nullptr;
+            if (ast == nullptr) {
+                ast = parser.emplace(source_file->GetText(), lexer_thread).GenerateAST();
+                if (parser->HadError()) return 65;
+            }
+            analyser.DeclareGlobals(*ast);
+            pass_manager.RunASTPasses(*ast);
+            Compiler compiler;
+            chunk = compiler.CompileLazily(ast.get(), analyser);
+            functions = compiler.GetFunctions();
+        } else {
+            // A cached AST was checked without errors when it was stored, so it skips parsing and analysis.
+            // It is stored before the AST passes, which rewrite it
+            ProgramPtr ast = ast_cache ? ast_cache->Load(source_file->GetText()) : nullptr;
+            if (ast == nullptr) {
+                ast = parser.emplace(source_file->GetText(), lexer_thread).GenerateAST();
+                if (parser->HadError()) return 65;
+                analyser.Analyse(*ast, thread_count);
+                if (ast_cache && analyser.GetErrorCount() == 0) ast_cache->Store(*ast, source_file->GetText());
+            }
+            pass_manager.RunASTPasses(*ast);
+            Compiler compiler;
+            chunk = compiler.Compile(ast.get(), thread_count);
+        }
+        pass_manager.RunBytecodePasses(chunk);
+        for (auto& function : functions) pass_manager.RunBytecodePasses(function);
+    } catch (const std::logic_error& error) {
+        std::cerr << "[COMPILE ERROR]: " << error.what() << std::endl;
+        return 65;
+    }
+    if (time_passes) std::cerr << Debug::GetPassStatsStr(pass_manager.GetStats()) << std::endl;
+
+    if (!verifier.Verify(chunk)) return 70;
+    for (auto& function : functions) {
+        if (!verifier.Verify(function)) return 70;
+    }
+
+    for (const auto& function : functions) std::cout << Debug::GetChunkStr(function) << std::endl;
+    std::cout << Debug::GetChunkStr(chunk) << std::endl << std::endl << std::endl;
+    vm.Interpret(chunk);
 
     //Debug::ASTStringVisitor debug;
     //ast->accept(debug);
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "parallel_lexer.h"
+
+namespace {
+    // Index of the token that starts at offset, or tokens.Size() if no token starts there
+    size_t FindTokenAt(const TokenBuffer& tokens, size_t offset) {
+        size_t low = 0, high = tokens.Size();
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (tokens.GetOffset(mid) < offset) low = mid + 1;
+            else high = mid;
+        }
+        return low < tokens.Size() && tokens.GetOffset(low) == offset ? low : tokens.Size();
+    }
+}
+
+ParallelLexer::ParallelLexer(std::string_view source_code, size_t thread_count, size_t min_segment_size)
+    : source_code_(source_code)
+    , thread_count_(std::max<size_t>(thread_count, 1))
+    , min_segment_size_(std::max<size_t>(min_segment_size, 1))
+{}
+
+const Interner& ParallelLexer::GetInterner() const {
+    return interner_;
+}
+
+TokenBuffer ParallelLexer::TokenizeAll() {
+    std::vector<Segment> segments = Split();
+    LexSegments(segments);
+
+    // Line of the first character of every segment, error tokens store lines relative to their segment
+    std::vector<size_t> segment_lines(segments.size(), 0);
+    for (size_t i = 1; i < segments.size(); i++) {
+        segment_lines[i] = segment_lines[i - 1] + segments[i - 1].newline_count;
+    }
+
+    size_t token_count = 0;
+    for (auto& segment : segments) token_count += segment.tokens.Size();
+    TokenBuffer result(source_code_);
+    result.Reserve(token_count);
+
+    auto has_ended = [&] { return result.Size() > 0 && result.GetType(result.Size() - 1) == TT::END; };
+
+    // Start of the next token of the real token stream, every segment before it has been merged.
+    // The first segment starts at the beginning of the source, so its speculation is always right.
+    size_t resume = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        Segment& segment = segments[i];
+        if (i > 0 && resume >= segment.end) continue; // A string swallowed the whole segment
+
+        // Speculation was right if the segment has a token exactly where the real stream continues
+        size_t first = i == 0 ? 0 : FindTokenAt(segment.tokens, resume);
+        if (first == segment.tokens.Size()) {
+            // Otherwise re-lex from the real position until a token lines up with the segment again
+            size_t line = segment_lines[i] + std::count(source_code_.data() + segment.begin, source_code_.data() + resume, '\n');
+            Lexer lexer(source_code_, resume, line);
+            TokenBuffer repaired(source_code_);
+            bool synchronized = false;
+            while (true) {
+                Token token = lexer.ReadNextToken();
+                size_t start = lexer.GetTokenStart();
+                if (token.type != TT::END && start >= segment.end) {
+                    resume = start;
+                    break;
+                }
+                first = FindTokenAt(segment.tokens, start);
+                if (first != segment.tokens.Size()) {
+                    synchronized = true;
+                    break;
+                }
+                repaired.Push(token, start);
+                if (token.type == TT::END) break;
+            }
+            Append(result, repaired, lexer.GetInterner(), 0, repaired.Size(), 0);
+            if (!synchronized) {
+                if (has_ended()) break;
+                continue;
+            }
+        }
+
+        Append(result, segment.tokens, segment.interner, first, segment.tokens.Size(), segment_lines[i]);
+        if (has_ended()) break;
+        resume = segment.lookahead;
+    }
+    result.ShrinkToFit();
+    return result;
+}
+
+// Splits right after a newline, so that no segment starts inside a comment
+std::vector<ParallelLexer::Segment> ParallelLexer::Split() const {
+    size_t size = source_code_.size();
+    size_t segment_count = std::clamp<size_t>(size / min_segment_size_, 1, thread_count_);
+    std::vector<Segment> segments;
+    size_t begin = 0;
+    for (size_t i = 1; i < segment_count; i++) {
+        size_t target = std::max(begin, i * size / segment_count);
+        const void* newline = std::memchr(source_code_.data() + target, '\n', size - target);
+        if (newline == nullptr) break;
+        size_t end = static_cast<const char*>(newline) - source_code_.data() + 1;
+        if (end >= size) break;
+        segments.emplace_back(source_code_, begin, end);
+        begin = end;
+    }
+    segments.emplace_back(source_code_, begin, size);
+    return segments;
+}
+
+void ParallelLexer::LexSegment(Segment& segment) const {
+    Lexer lexer(source_code_, segment.begin, 0);
+    segment.tokens.Reserve(TokenBuffer::EstimateTokenCount(segment.end - segment.begin));
+    while (true) {
+        Token token = lexer.ReadNextToken();
+        size_t start = lexer.GetTokenStart();
+        if (token.type != TT::END && start >= segment.end) {
+            segment.lookahead = start;
+            break;
+        }
+        segment.tokens.Push(token, start);
+        if (token.type == TT::END) break;
+    }
+    segment.interner = lexer.GetInterner();
+    segment.newline_count = std::count(source_code_.data() + segment.begin, source_code_.data() + segment.end, '\n');
+}
+
+void ParallelLexer::LexSegments(std::vector<Segment>& segments) const {
+    if (segments.size() == 1) {
+        LexSegment(segments[0]);
+        return;
+    }
+    std::atomic<size_t> next_segment = 0;
+    auto worker = [&] {
+        for (size_t i = next_segment++; i < segments.size(); i = next_segment++) {
+            LexSegment(segments[i]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min(thread_count_, segments.size()); i++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) thread.join();
+}
+
+// Symbols are interned in the order they appear in the merged stream, so the ids match the sequential Lexer.
+// Speculative tokens that were thrown away never reach the Interner.
+void ParallelLexer::Append(TokenBuffer& result, const TokenBuffer& tokens, const Interner& interner, size_t begin,
+                           size_t end, size_t error_line_offset) {
+    std::vector<SymbolId> symbol_map(interner.Size(), NO_SYMBOL);
+    for (size_t i = begin; i < end; i++) {
+        SymbolId symbol = tokens.GetSymbol(i);
+        if (symbol != NO_SYMBOL && symbol_map[symbol] == NO_SYMBOL) {
+            symbol_map[symbol] = interner_.Intern(interner.GetName(symbol));
+        }
+    }
+    result.Append(tokens, begin, end, error_line_offset, symbol_map);
+}
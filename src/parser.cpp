@@ -1,70 +1,119 @@
 #include "parser.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
-#include <unordered_map>
-#include <functional>
-
-Parser::Parser(std::string_view source_code)
-    : lexer_(source_code)
+#include <utility>
+
+Parser::Parser(std::string_view source_code, bool pipelined_lexing)
+    : Parser(Lexer(source_code), source_code.size(), pipelined_lexing)
+{}
+
+Parser::Parser(std::string_view source_code, size_t start_index, size_t start_line)
+    : Parser(Lexer(source_code, start_index, start_line), source_code.size(), false)
+{}
+
+Parser::Parser(Lexer lexer, size_t source_size, bool pipelined_lexing)
+    : lexer_(std::move(lexer))
+    , pipelined_lexing_(pipelined_lexing)
+    , pipeline_(nullptr)
+    , source_size_(source_size)
+    , arena_(nullptr)
+    , compiler_(nullptr)
+    , analyser_(nullptr)
+    , precedence_(Precedence::NONE)
     , prev_token_(TT::NONE, "", -1)
     , cur_token_(TT::NONE, "", -1)
     , panic_mode_(false)
-    , had_error_(false) {
-
-    auto parseLiteral = std::bind(&Parser::ParseLiteral, this);
-    auto parseIdentifier = std::bind(&Parser::ParseIdentifier, this);
-    auto parseAssignment = std::bind(&Parser::ParseAssignment, this, std::placeholders::_1);
-    auto parseBinary = std::bind(&Parser::ParseBinary, this, std::placeholders::_1);
-    auto parseUnary = std::bind(&Parser::ParseUnary, this);
-    auto parseGrouping = std::bind(&Parser::ParseGrouping, this);
-    auto parseCall = std::bind(&Parser::ParseCall, this, std::placeholders::_1);
-
-    pratt_table_[TT::TRUE]          = {parseLiteral, nullptr, Precedence::NONE};
-    pratt_table_[TT::FALSE]         = {parseLiteral, nullptr, Precedence::NONE};
-    pratt_table_[TT::NIL]           = {parseLiteral, nullptr, Precedence::NONE};
-    pratt_table_[TT::STRING]        = {parseLiteral, nullptr, Precedence::NONE};
-    pratt_table_[TT::NUMBER]        = {parseLiteral, nullptr, Precedence::NONE};
-    pratt_table_[TT::BANG]          = {parseUnary, nullptr, Precedence::NONE};
-    pratt_table_[TT::IDENTIFIER]    = {parseIdentifier, nullptr, Precedence::NONE};
-    pratt_table_[TT::EQUAL]         = {nullptr, parseAssignment, Precedence::ASSIGNMENT};
-    pratt_table_[TT::OR]            = {nullptr, parseBinary, Precedence::OR};
-    pratt_table_[TT::AND]           = {nullptr, parseBinary, Precedence::AND};
-    pratt_table_[TT::EQUAL_EQUAL]   = {nullptr, parseBinary, Precedence::EQUALITY};
-    pratt_table_[TT::BANG_EQUAL]    = {nullptr, parseBinary, Precedence::EQUALITY};
-    pratt_table_[TT::GREATER]       = {nullptr, parseBinary, Precedence::COMPARISON};
-    pratt_table_[TT::GREATER_EQUAL] = {nullptr, parseBinary, Precedence::COMPARISON};
-    pratt_table_[TT::LESS]          = {nullptr, parseBinary, Precedence::COMPARISON};
-    pratt_table_[TT::LESS_EQUAL]    = {nullptr, parseBinary, Precedence::COMPARISON};
-    pratt_table_[TT::PLUS]          = {nullptr, parseBinary, Precedence::TERM};
-    pratt_table_[TT::MINUS]         = {parseUnary, parseBinary, Precedence::TERM};
-    pratt_table_[TT::STAR]          = {nullptr, parseBinary, Precedence::FACTOR};
-    pratt_table_[TT::SLASH]         = {nullptr, parseBinary, Precedence::FACTOR};
-    pratt_table_[TT::LEFT_PAREN]    = {parseGrouping, parseCall, Precedence::CALL};
+    , had_error_(false)
+{}
+
+template <auto ParseFn>
+ExpressionPtr Parser::Prefix() {
+    return (this->*ParseFn)();
 }
 
+template <auto ParseFn>
+ExpressionPtr Parser::Infix(ExpressionPtr left) {
+    return (this->*ParseFn)(left);
+}
+
+constexpr std::array<Parser::ParseRule, TOKEN_TYPE_COUNT> Parser::PRATT_TABLE = [] {
+    std::array<ParseRule, TOKEN_TYPE_COUNT> table{};
+    auto set = [&](TokenType type, PrefixFn prefix, InfixFn infix, Precedence precedence) {
+        table[static_cast<size_t>(type)] = {prefix, infix, precedence};
+    };
+    constexpr PrefixFn parseLiteral = &Parser::Prefix<&Parser::ParseLiteral>;
+    constexpr PrefixFn parseIdentifier = &Parser::Prefix<&Parser::ParseIdentifier>;
+    constexpr PrefixFn parseUnary = &Parser::Prefix<&Parser::ParseUnary>;
+    constexpr PrefixFn parseGrouping = &Parser::Prefix<&Parser::ParseGrouping>;
+    constexpr InfixFn parseAssignment = &Parser::Infix<&Parser::ParseAssignment>;
+    constexpr InfixFn parseBinary = &Parser::Infix<&Parser::ParseBinary>;
+    constexpr InfixFn parseCall = &Parser::Infix<&Parser::ParseCall>;
+
+    set(TT::TRUE,          parseLiteral, nullptr, Precedence::NONE);
+    set(TT::FALSE,         parseLiteral, nullptr, Precedence::NONE);
+    set(TT::NIL,           parseLiteral, nullptr, Precedence::NONE);
+    set(TT::STRING,        parseLiteral, nullptr, Precedence::NONE);
+    set(TT::NUMBER,        parseLiteral, nullptr, Precedence::NONE);
+    set(TT::BANG,          parseUnary, nullptr, Precedence::NONE);
+    set(TT::IDENTIFIER,    parseIdentifier, nullptr, Precedence::NONE);
+    set(TT::EQUAL,         nullptr, parseAssignment, Precedence::ASSIGNMENT);
+    set(TT::OR,            nullptr, parseBinary, Precedence::OR);
+    set(TT::AND,           nullptr, parseBinary, Precedence::AND);
+    set(TT::EQUAL_EQUAL,   nullptr, parseBinary, Precedence::EQUALITY);
+    set(TT::BANG_EQUAL,    nullptr, parseBinary, Precedence::EQUALITY);
+    set(TT::GREATER,       nullptr, parseBinary, Precedence::COMPARISON);
+    set(TT::GREATER_EQUAL, nullptr, parseBinary, Precedence::COMPARISON);
+    set(TT::LESS,          nullptr, parseBinary, Precedence::COMPARISON);
+    set(TT::LESS_EQUAL,    nullptr, parseBinary, Precedence::COMPARISON);
+    set(TT::PLUS,          nullptr, parseBinary, Precedence::TERM);
+    set(TT::MINUS,         parseUnary, parseBinary, Precedence::TERM);
+    set(TT::STAR,          nullptr, parseBinary, Precedence::FACTOR);
+    set(TT::SLASH,         nullptr, parseBinary, Precedence::FACTOR);
+    set(TT::LEFT_PAREN,    parseGrouping, parseCall, Precedence::CALL);
+    return table;
+}();
+
 ProgramPtr Parser::GenerateAST() {
-    auto ast = std::make_unique<Program>();
+    // Roughly one node per token, the Arena grows geometrically from there if needed
+    auto ast = std::make_unique<Program>(std::make_unique<Arena>(std::max<size_t>(source_size_, 4096)));
+    arena_ = ast->arena.get();
 
     Advance();
     while (cur_token_.type != TokenType::END) {
-        ast->declarations.push_back(std::move(ParseDeclaration()));
+        ast->declarations.push_back(ParseDeclaration());
     }
 
-    return std::move(ast);
+    return ast;
+}
+
+ProgramPtr Parser::GenerateNextDeclaration() {
+    if (cur_token_.type == TT::NONE) Advance(); // First call
+    if (cur_token_.type == TT::END) return nullptr;
+
+    // A single declaration is usually small, the Arena grows from the default size if it isn't
+    auto declaration = std::make_unique<Program>(std::make_unique<Arena>());
+    arena_ = declaration->arena.get();
+    declaration->declarations.push_back(ParseDeclaration());
+    return declaration;
 }
 
 ExpressionPtr Parser::ParseExpression() {
+    expression_arena_ = std::make_unique<Arena>();
+    arena_ = expression_arena_.get();
     Advance();
-    return std::move(ParsePrecedence(Precedence::ASSIGNMENT));
+    return ParsePrecedence(Precedence::ASSIGNMENT);
 }
 
 void Parser::Advance() {
     prev_token_ = cur_token_;
 
+    if (pipelined_lexing_ && pipeline_ == nullptr) pipeline_ = std::make_unique<PipelinedLexer>(lexer_);
+
     // Get next token and until TokenType != ERROR
     while (true) {
-        cur_token_ = lexer_.ReadNextToken();
+        cur_token_ = pipeline_ ? pipeline_->ReadNextToken() : lexer_.ReadNextToken();
         if (cur_token_.type != TT::ERROR) break;
         ErrorAtCur(std::string(cur_token_.lexeme));
     }
@@ -90,40 +139,39 @@ bool Parser::Match(TT type) {
     return false;
 }
 
-Parser::ParseRule Parser::GetRule(TokenType type) {
-    assert(pratt_table_.contains(type));
-    return pratt_table_.at(type);
+const Parser::ParseRule& Parser::GetRule(TokenType type) {
+    return PRATT_TABLE[static_cast<size_t>(type)];
 }
 
 DeclarationPtr Parser::ParseDeclaration() {
     if (Match(TT::FUN)) {
-        return std::move(ParseFunDecl());
+        return ParseFunDecl();
     } else if (Match(TT::VAR)) {
-        return std::move(ParseVarDecl());
+        return ParseVarDecl();
     } else {
-        return std::move(ParseStatement());
+        return ParseStatement();
     }
 }
 
 FunDeclPtr Parser::ParseFunDecl() {
-    auto function = std::make_unique<FunDecl>();
+    auto function = arena_->Make<FunDecl>();
 
     Consume(TT::IDENTIFIER, "Expected function name");
-    function->name = std::move(ParseIdentifier());
+    function->name = ParseIdentifier();
 
     Consume(TT::LEFT_PAREN, "Expected ( after function identifier");
     if (!Check(TT::RIGHT_PAREN)) {
-        function->parameters = std::move(ParseParameters());
+        function->parameters = ParseParameters();
     }
     Consume(TT::RIGHT_PAREN, "Expected closing ) after function parameters");
 
     Consume(TT::LEFT_BRACE, "Expect opening {");
-    function->body = std::move(ParseBlock());
-    return std::move(function);
+    function->body = ParseBlock();
+    return function;
 }
 
 VarDeclPtr Parser::ParseVarDecl() {
-    auto varDecl = std::make_unique<VarDecl>();
+    auto varDecl = arena_->Make<VarDecl>();
     Consume(TT::IDENTIFIER, "Expected identifier after 'var'");
     varDecl->variable = ParseIdentifier();
     if (Match(TT::EQUAL)) {
@@ -132,213 +180,283 @@ VarDeclPtr Parser::ParseVarDecl() {
         varDecl->expression = nullptr;
     }
     Consume(TT::SEMICOLON, "Expected ; after variable declaration.");
-    return std::move(varDecl);
+    return varDecl;
 }
 
 IfStmtPtr Parser::ParseIfStmt() {
-    auto if_stmt = std::make_unique<IfStmt>();
+    auto if_stmt = arena_->Make<IfStmt>();
 
     // Parse condition
     Consume(TT::LEFT_PAREN, "Expected ( after if");
-    if_stmt->condition = std::move(ParsePrecedence(Precedence::ASSIGNMENT));
+    if_stmt->condition = ParsePrecedence(Precedence::ASSIGNMENT);
     Consume(TT::RIGHT_PAREN, "Expected ) after if condition");
 
     // Parse body
-    if_stmt->if_body = std::move(ParseStatement());
+    if_stmt->if_body = ParseStatement();
 
     // Parse else body
     if (Match(TT::ELSE)) {
-        if_stmt->else_body = std::move(ParseStatement());
+        if_stmt->else_body = ParseStatement();
     }
 
-    return std::move(if_stmt);
+    return if_stmt;
 }
 
 PrintStmtPtr Parser::ParsePrintStmt() {
-    auto print_stmt = std::make_unique<PrintStmt>();
-    print_stmt->expression = std::move(ParsePrecedence(Precedence::ASSIGNMENT));
+    auto print_stmt = arena_->Make<PrintStmt>();
+    print_stmt->expression = ParsePrecedence(Precedence::ASSIGNMENT);
     Consume(TT::SEMICOLON, "Expected ; after print expression");
-    return std::move(print_stmt);
+    return print_stmt;
 }
 
 ReturnStmtPtr Parser::ParseReturnStmt() {
-    auto return_stmt = std::make_unique<ReturnStmt>();
+    auto return_stmt = arena_->Make<ReturnStmt>();
     if (!Check(TT::SEMICOLON)) {
-        return_stmt->expression = std::move(ParsePrecedence(Precedence::ASSIGNMENT));
+        return_stmt->expression = ParsePrecedence(Precedence::ASSIGNMENT);
     }
     Consume(TT::SEMICOLON, "Expected ; after return expression");
-    return std::move(return_stmt);
+    return return_stmt;
 }
 
 WhileStmtPtr Parser::ParseWhileStmt() {
-    auto while_stmt = std::make_unique<WhileStmt>();
+    auto while_stmt = arena_->Make<WhileStmt>();
 
     // Parse condition
     Consume(TT::LEFT_PAREN, "Expected ( after while");
-    while_stmt->condition = std::move(ParsePrecedence(Precedence::ASSIGNMENT));
+    while_stmt->condition = ParsePrecedence(Precedence::ASSIGNMENT);
     Consume(TT::RIGHT_PAREN, "Expected ) after while condition");
 
     // Parse body
-    while_stmt->body = std::move(ParseStatement());
+    while_stmt->body = ParseStatement();
 
-    return std::move(while_stmt);
+    return while_stmt;
 }
 
 BlockPtr Parser::ParseBlock() {
-    auto block = std::make_unique<Block>();
+    auto block = arena_->Make<Block>(*arena_);
     while (!Check(TT::RIGHT_BRACE) && !Check(TT::END)) {
-        block->declarations.push_back(std::move(ParseDeclaration()));
+        block->declarations.push_back(ParseDeclaration());
     }
     Consume(TT::RIGHT_BRACE, "Expected ending }");
-    return std::move(block);
+    return block;
 }
 
 StatementPtr Parser::ParseStatement() {
     if (Match(TT::IF)) {
-        return std::move(ParseIfStmt());
+        return ParseIfStmt();
     } else if (Match(TT::PRINT)) {
-        return std::move(ParsePrintStmt());
+        return ParsePrintStmt();
     } else if (Match(TT::RETURN)) {
-        return std::move(ParseReturnStmt());
+        return ParseReturnStmt();
     } else if (Match(TT::WHILE)) {
-        return std::move(ParseWhileStmt());
+        return ParseWhileStmt();
     } else if (Match(TT::LEFT_BRACE)) {
-        return std::move(ParseBlock());
+        return ParseBlock();
     } else {
-        return std::move(ParseExprStmt());
+        return ParseExprStmt();
     }
 }
 
 ExprStmtPtr Parser::ParseExprStmt() {
-    auto expr_stmt = std::make_unique<ExprStmt>();
-    expr_stmt->expression = std::move(ParsePrecedence(Precedence::ASSIGNMENT));
+    auto expr_stmt = arena_->Make<ExprStmt>();
+    expr_stmt->expression = ParsePrecedence(Precedence::ASSIGNMENT);
     Consume(TT::SEMICOLON, "Expected ; after expression.");
-    return std::move(expr_stmt);
+    return expr_stmt;
 }
 
 ExpressionPtr Parser::ParsePrecedence(Precedence precedence) {
-    Advance();
-    if (!pratt_table_.contains(prev_token_.type)) {
-        ErrorAt(prev_token_, "Expect expression");
-        return nullptr;
+    assert(precedence > Precedence::NONE);
+    const Precedence enclosing = precedence_;
+    const size_t base = pending_.size();
+    precedence_ = precedence;
+
+    // PREFIX parses the start of an operand, INFIX extends it with operators of at least precedence_ and COMPLETE
+    // hands it to the innermost pending operator. Parse functions that push an operator start a new operand
+    enum class Step { PREFIX, INFIX, COMPLETE };
+    Step step = Step::PREFIX;
+    ExpressionPtr left = nullptr;
+    while (true) {
+        if (step == Step::PREFIX) {
+            Advance();
+            const ParseRule& prefix_rule = GetRule(prev_token_.type);
+            if (prefix_rule.prefix == nullptr) {
+                // Tokens that are only infix operators get a more specific error than tokens that never appear in expressions
+                if (prefix_rule.infix == nullptr) ErrorAt(prev_token_, "Expect expression");
+                else ErrorAt(prev_token_, "Cannot start expression with: " + std::string(prev_token_.lexeme));
+                left = nullptr;
+                step = Step::COMPLETE;
+                continue;
+            }
+            const size_t open = pending_.size();
+            left = (this->*prefix_rule.prefix)();
+            step = pending_.size() > open ? Step::PREFIX : Step::INFIX;
+        } else if (step == Step::INFIX) {
+            // Tokens without an infix rule have Precedence::NONE, which is below every precedence parsed here
+            step = Step::COMPLETE;
+            while (precedence_ <= GetRule(cur_token_.type).precedence) {
+                Advance();
+                const size_t open = pending_.size();
+                left = (this->*GetRule(prev_token_.type).infix)(left);
+                if (pending_.size() > open) {
+                    step = Step::PREFIX;
+                    break;
+                }
+            }
+        } else {
+            if (pending_.size() == base) break;
+            const size_t open = pending_.size() - 1;
+            left = Resume(left);
+            step = pending_.size() > open ? Step::PREFIX : Step::INFIX;
+        }
     }
 
-    auto prefixFn = GetRule(prev_token_.type).prefix;
-
-    if (prefixFn == nullptr) {
-        ErrorAt(prev_token_, "Cannot start expression with: " + std::string(prev_token_.lexeme));
-        return nullptr;
-    }
+    precedence_ = enclosing;
+    return left;
+}
 
-    auto left = prefixFn();
+Parser::PendingOperator& Parser::Suspend(PendingOperator::Kind kind, Precedence operand_precedence) {
+    pending_.push_back({kind, precedence_});
+    precedence_ = operand_precedence;
+    return pending_.back();
+}
 
-    while (pratt_table_.contains(cur_token_.type) && precedence <= GetRule(cur_token_.type).precedence) {
-        Advance();
-        auto infixFn = GetRule(prev_token_.type).infix;
-        left = infixFn(std::move(left));
+// Attaches operand to the innermost pending operator and returns the finished expression
+ExpressionPtr Parser::Resume(ExpressionPtr operand) {
+    using Kind = PendingOperator::Kind;
+    const PendingOperator pending = pending_.back();
+    pending_.pop_back();
+    precedence_ = pending.precedence;
+    switch (pending.kind) {
+        case Kind::UNARY:
+            static_cast<UnaryPtr>(pending.node)->expression = operand;
+            return pending.node;
+        case Kind::BINARY:
+            static_cast<BinaryPtr>(pending.node)->right_expression = operand;
+            return pending.node;
+        case Kind::ASSIGNMENT:
+            static_cast<AssignmentPtr>(pending.node)->expression = operand;
+            return pending.node;
+        case Kind::GROUPING:
+            Consume(TT::RIGHT_PAREN, "Expected ending ')' after expression");
+            return operand;
+        case Kind::ARGUMENT: {
+            auto& arguments = static_cast<CallPtr>(pending.node)->arguments->expressions;
+            arguments.push_back(operand);
+            if (arguments.size() > 256) ErrorAtCur("Cannot have more than 256 arguments");
+            if (Match(TT::COMMA)) {
+                Suspend(Kind::ARGUMENT, Precedence::ASSIGNMENT).node = pending.node;
+            } else {
+                Consume(TT::RIGHT_PAREN, "Expected ) after arguments");
+            }
+            return pending.node;
+        }
     }
-
-    return std::move(left);
+    return operand;
 }
 
-AssignmentPtr Parser::ParseAssignment(ExpressionPtr left) {
-    auto assign = std::make_unique<Assignment>();
-    if (const auto* _identifier = dynamic_cast<const Identifier*>(left.get())) {
-        assign->variable = std::unique_ptr<Identifier>(static_cast<Identifier*>(left.release()));
-        assign->expression = std::move(ParsePrecedence(Precedence::ASSIGNMENT));
-    } else {
+// On an invalid target no Assignment is made, so later stages never see one without a variable
+ExpressionPtr Parser::ParseAssignment(ExpressionPtr left) {
+    if (dynamic_cast<const Identifier*>(left) == nullptr) {
         ErrorAtCur("Can only assign values to identifiers");
+        return left;
     }
-    return std::move(assign);
+    auto assign = arena_->Make<Assignment>();
+    assign->variable = static_cast<IdentifierPtr>(left);
+    Suspend(PendingOperator::Kind::ASSIGNMENT, Precedence::ASSIGNMENT).node = assign;
+    return assign;
 }
 
 BinaryPtr Parser::ParseBinary(ExpressionPtr left) {
-    auto binary = std::make_unique<Binary>();
+    auto binary = arena_->Make<Binary>();
     binary->op = prev_token_.type;
     auto operand_precedence = static_cast<int>(GetRule(binary->op).precedence);
-    binary->left_expression = std::move(left);
-    binary->right_expression = std::move(ParsePrecedence(static_cast<Precedence>(operand_precedence + 1)));
-    return std::move(binary);
+    binary->left_expression = left;
+    Suspend(PendingOperator::Kind::BINARY, static_cast<Precedence>(operand_precedence + 1)).node = binary;
+    return binary;
 }
 
 UnaryPtr Parser::ParseUnary() {
-    auto unary = std::make_unique<Unary>();
+    auto unary = arena_->Make<Unary>();
     unary->op = prev_token_.type;
-    unary->expression = std::move(ParsePrecedence(Precedence::UNARY));
-    return std::move(unary);
+    Suspend(PendingOperator::Kind::UNARY, Precedence::UNARY).node = unary;
+    return unary;
 }
 
 LiteralPtr Parser::ParseLiteral() {
-    auto literal = std::make_unique<Literal>();
+    auto literal = arena_->Make<Literal>();
+    literal->value = ParseLiteralValue();
+    return literal;
+}
+
+Value Parser::ParseLiteralValue() {
     switch (prev_token_.type) {
         case TT::TRUE:
-            literal->value = true;
-            break;
+            return true;
         case TT::FALSE:
-            literal->value = false;
-            break;
+            return false;
         case TT::NIL:
-            literal->value = std::monostate{};
-            break;
+            return std::monostate{};
         case TT::STRING:
-            literal->value = prev_token_.lexeme;
-            break;
+            return prev_token_.lexeme;
         case TT::NUMBER:
-            literal->value = std::stod(std::string(prev_token_.lexeme));
-            break;
+            return std::stod(std::string(prev_token_.lexeme));
         default:
             ErrorAt(prev_token_, "Invalid literal");
+            return {};
     }
-    return std::move(literal);
 }
 
 ExpressionPtr Parser::ParseGrouping() {
-    auto expression = std::move(ParsePrecedence(Precedence::ASSIGNMENT));
-    Consume(TT::RIGHT_PAREN, "Expected ending ')' after expression");
-    return std::move(expression);
+    Suspend(PendingOperator::Kind::GROUPING, Precedence::ASSIGNMENT);
+    return nullptr;
 }
 
-CallPtr Parser::ParseCall(ExpressionPtr left) {
-    auto call = std::make_unique<Call>();
-    if (const auto* _identifier = dynamic_cast<const Identifier*>(left.get())) {
-        call->callee = std::unique_ptr<Identifier>(static_cast<Identifier*>(left.release()));
-        if (!Check(TT::RIGHT_PAREN)) {
-            call->arguments = std::move(ParseArguments());
-        }
-        Consume(TT::RIGHT_PAREN, "Expected ) after arguments");
-    } else {
+// Like ParseAssignment, an invalid callee makes no Call
+ExpressionPtr Parser::ParseCall(ExpressionPtr left) {
+    if (dynamic_cast<const Identifier*>(left) == nullptr) {
         ErrorAtCur("Can only call functions");
+        return left;
     }
-    return std::move(call);
+    auto call = arena_->Make<Call>();
+    call->callee = static_cast<IdentifierPtr>(left);
+    if (!Check(TT::RIGHT_PAREN)) {
+        // The arguments are parsed as operands of the call, Resume consumes the closing )
+        call->arguments = arena_->Make<Arguments>(*arena_);
+        Suspend(PendingOperator::Kind::ARGUMENT, Precedence::ASSIGNMENT).node = call;
+    } else {
+        Consume(TT::RIGHT_PAREN, "Expected ) after arguments");
+    }
+    return call;
+}
+
+const Interner& Parser::GetInterner() const {
+    return lexer_.GetInterner();
+}
+
+size_t Parser::GetOffset() const {
+    assert(!pipelined_lexing_);
+    return lexer_.GetTokenStart(); // Error tokens are skipped, so the last token read is cur_token_
+}
+
+bool Parser::HadError() const {
+    return had_error_;
 }
 
 IdentifierPtr Parser::ParseIdentifier() {
-    auto identifier = std::make_unique<Identifier>();
+    auto identifier = arena_->Make<Identifier>();
     identifier->name = prev_token_.lexeme;
-    return std::move(identifier);
+    identifier->symbol = prev_token_.symbol;
+    return identifier;
 }
 
 ParametersPtr Parser::ParseParameters() {
-    auto parameters = std::make_unique<Parameters>();
+    auto parameters = arena_->Make<Parameters>(*arena_);
     for (Advance(); prev_token_.type == TT::IDENTIFIER; Advance()) {
-        parameters->identifiers.push_back(std::move(ParseIdentifier()));
+        parameters->identifiers.push_back(ParseIdentifier());
         if (Check(TT::RIGHT_PAREN)) break;
         Consume(TT::COMMA, "Expect , after parameter");
     }
-    return std::move(parameters);
-}
-
-ArgumentsPtr Parser::ParseArguments() {
-    auto arguments = std::make_unique<Arguments>();
-    if (!Check(TT::RIGHT_PAREN)) {
-        int arg_count = 0;
-        do {
-            arguments->expressions.push_back(std::move(ParsePrecedence((Precedence::ASSIGNMENT))));
-            if (arg_count >= 256) ErrorAtCur("Cannot have more than 256 arguments");
-            arg_count++;
-        } while (Match(TT::COMMA));
-    }
-    return std::move(arguments);
+    return parameters;
 }
 
 void Parser::ErrorAt(Token &token, std::string msg) {
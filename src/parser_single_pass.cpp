@@ -0,0 +1,315 @@
+// Single-pass mode of the Parser: the same grammar as parser.cpp, but instead of building nodes every
+// construct is checked by the SemanticAnalyser and compiled by the Compiler as soon as it has been parsed.
+#include <cassert>
+#include <vector>
+
+#include "compiler.h"
+#include "parser.h"
+#include "semantic_analyser.h"
+
+constexpr std::array<Parser::CompileRule, TOKEN_TYPE_COUNT> Parser::COMPILE_TABLE = [] {
+    std::array<CompileRule, TOKEN_TYPE_COUNT> table{};
+    auto set = [&](TokenType type, CompilePrefixFn prefix, CompileInfixFn infix) {
+        table[static_cast<size_t>(type)] = {prefix, infix};
+    };
+    set(TT::TRUE,          &Parser::CompileLiteral, nullptr);
+    set(TT::FALSE,         &Parser::CompileLiteral, nullptr);
+    set(TT::NIL,           &Parser::CompileLiteral, nullptr);
+    set(TT::STRING,        &Parser::CompileLiteral, nullptr);
+    set(TT::NUMBER,        &Parser::CompileLiteral, nullptr);
+    set(TT::BANG,          &Parser::CompileUnary, nullptr);
+    set(TT::IDENTIFIER,    &Parser::CompileIdentifier, nullptr);
+    set(TT::EQUAL,         nullptr, &Parser::CompileAssignment);
+    set(TT::OR,            nullptr, &Parser::CompileBinary);
+    set(TT::AND,           nullptr, &Parser::CompileBinary);
+    set(TT::EQUAL_EQUAL,   nullptr, &Parser::CompileBinary);
+    set(TT::BANG_EQUAL,    nullptr, &Parser::CompileBinary);
+    set(TT::GREATER,       nullptr, &Parser::CompileBinary);
+    set(TT::GREATER_EQUAL, nullptr, &Parser::CompileBinary);
+    set(TT::LESS,          nullptr, &Parser::CompileBinary);
+    set(TT::LESS_EQUAL,    nullptr, &Parser::CompileBinary);
+    set(TT::PLUS,          nullptr, &Parser::CompileBinary);
+    set(TT::MINUS,         &Parser::CompileUnary, &Parser::CompileBinary);
+    set(TT::STAR,          nullptr, &Parser::CompileBinary);
+    set(TT::SLASH,         nullptr, &Parser::CompileBinary);
+    set(TT::LEFT_PAREN,    &Parser::CompileGrouping, &Parser::CompileCall);
+    return table;
+}();
+
+Chunk Parser::GenerateChunk(SemanticAnalyser& analyser) {
+    Compiler compiler;
+    compiler_ = &compiler;
+    analyser_ = &analyser;
+
+    Advance();
+    while (cur_token_.type != TokenType::END) {
+        CompileDeclaration();
+    }
+
+    compiler_ = nullptr;
+    analyser_ = nullptr;
+    return compiler.TakeChunk();
+}
+
+void Parser::CompileDeclaration() {
+    if (Match(TT::FUN)) {
+        CompileFunDecl();
+    } else if (Match(TT::VAR)) {
+        CompileVarDecl();
+    } else {
+        CompileStatement();
+    }
+}
+
+void Parser::CompileFunDecl() {
+    Consume(TT::IDENTIFIER, "Expected function name");
+    std::string_view name = prev_token_.lexeme;
+    SymbolId symbol = prev_token_.symbol;
+
+    // The function can only be declared once its parameter count is known
+    std::vector<Operand> parameters;
+    Consume(TT::LEFT_PAREN, "Expected ( after function identifier");
+    if (!Check(TT::RIGHT_PAREN)) {
+        for (Advance(); prev_token_.type == TT::IDENTIFIER; Advance()) {
+            parameters.push_back({prev_token_.lexeme, prev_token_.symbol});
+            if (Check(TT::RIGHT_PAREN)) break;
+            Consume(TT::COMMA, "Expect , after parameter");
+        }
+    }
+    Consume(TT::RIGHT_PAREN, "Expected closing ) after function parameters");
+
+    analyser_->DeclareFunction(name, symbol, parameters.size());
+    analyser_->PushScope();
+    for (const auto& parameter : parameters) {
+        analyser_->DeclareParameter(parameter.name, parameter.symbol);
+    }
+    Consume(TT::LEFT_BRACE, "Expect opening {");
+    // The body is compiled inline, like Compiler::visit(FunDecl) does
+    CompileBlock();
+    analyser_->PopScope();
+}
+
+void Parser::CompileVarDecl() {
+    Consume(TT::IDENTIFIER, "Expected identifier after 'var'");
+    analyser_->DeclareVariable(prev_token_.lexeme, prev_token_.symbol);
+    if (Match(TT::EQUAL)) {
+        CompileValue(Precedence::ASSIGNMENT);
+    }
+    Consume(TT::SEMICOLON, "Expected ; after variable declaration.");
+}
+
+void Parser::CompileIfStmt() {
+    // Compile condition
+    Consume(TT::LEFT_PAREN, "Expected ( after if");
+    CompileValue(Precedence::ASSIGNMENT);
+    Consume(TT::RIGHT_PAREN, "Expected ) after if condition");
+
+    // Compile body
+    uint32_t else_jump = compiler_->EmitJump(OP::JUMP_IF_FALSE);
+    CompileStatement();
+
+    // Compile else body
+    if (!Match(TT::ELSE)) {
+        compiler_->PatchJump(else_jump);
+        return;
+    }
+    uint32_t end_jump = compiler_->EmitJump(OP::JUMP);
+    compiler_->PatchJump(else_jump);
+    CompileStatement();
+    compiler_->PatchJump(end_jump);
+}
+
+void Parser::CompilePrintStmt() {
+    CompileValue(Precedence::ASSIGNMENT);
+    Consume(TT::SEMICOLON, "Expected ; after print expression");
+}
+
+void Parser::CompileReturnStmt() {
+    if (!Check(TT::SEMICOLON)) {
+        CompileValue(Precedence::ASSIGNMENT);
+    }
+    Consume(TT::SEMICOLON, "Expected ; after return expression");
+}
+
+void Parser::CompileWhileStmt() {
+    // Compile condition
+    Consume(TT::LEFT_PAREN, "Expected ( after while");
+    CompileValue(Precedence::ASSIGNMENT);
+    Consume(TT::RIGHT_PAREN, "Expected ) after while condition");
+
+    // Compile body
+    CompileStatement();
+}
+
+void Parser::CompileBlock() {
+    analyser_->PushScope();
+    while (!Check(TT::RIGHT_BRACE) && !Check(TT::END)) {
+        CompileDeclaration();
+    }
+    Consume(TT::RIGHT_BRACE, "Expected ending }");
+    analyser_->PopScope();
+}
+
+void Parser::CompileStatement() {
+    if (Match(TT::IF)) {
+        CompileIfStmt();
+    } else if (Match(TT::PRINT)) {
+        CompilePrintStmt();
+    } else if (Match(TT::RETURN)) {
+        CompileReturnStmt();
+    } else if (Match(TT::WHILE)) {
+        CompileWhileStmt();
+    } else if (Match(TT::LEFT_BRACE)) {
+        CompileBlock();
+    } else {
+        CompileExprStmt();
+    }
+}
+
+void Parser::CompileExprStmt() {
+    CompileValue(Precedence::ASSIGNMENT);
+    Consume(TT::SEMICOLON, "Expected ; after expression.");
+    compiler_->Emit(OP::POP);
+}
+
+void Parser::CompileValue(Precedence precedence) {
+    Operand operand = CompilePrecedence(precedence);
+    if (operand.symbol != NO_SYMBOL) analyser_->CheckIdentifier(operand.name, operand.symbol);
+}
+
+// The same steps as ParsePrecedence
+Parser::Operand Parser::CompilePrecedence(Precedence precedence) {
+    assert(precedence > Precedence::NONE);
+    const Precedence enclosing = precedence_;
+    const size_t base = pending_.size();
+    precedence_ = precedence;
+
+    enum class Step { PREFIX, INFIX, COMPLETE };
+    Step step = Step::PREFIX;
+    Operand left;
+    while (true) {
+        if (step == Step::PREFIX) {
+            Advance();
+            const CompileRule& prefix_rule = COMPILE_TABLE[static_cast<size_t>(prev_token_.type)];
+            if (prefix_rule.prefix == nullptr) {
+                if (prefix_rule.infix == nullptr) ErrorAt(prev_token_, "Expect expression");
+                else ErrorAt(prev_token_, "Cannot start expression with: " + std::string(prev_token_.lexeme));
+                left = {};
+                step = Step::COMPLETE;
+                continue;
+            }
+            const size_t open = pending_.size();
+            left = (this->*prefix_rule.prefix)();
+            step = pending_.size() > open ? Step::PREFIX : Step::INFIX;
+        } else if (step == Step::INFIX) {
+            step = Step::COMPLETE;
+            while (precedence_ <= GetRule(cur_token_.type).precedence) {
+                Advance();
+                const size_t open = pending_.size();
+                left = (this->*COMPILE_TABLE[static_cast<size_t>(prev_token_.type)].infix)(left);
+                if (pending_.size() > open) {
+                    step = Step::PREFIX;
+                    break;
+                }
+            }
+        } else {
+            if (pending_.size() == base) break;
+            const size_t open = pending_.size() - 1;
+            left = CompileResume(left);
+            step = pending_.size() > open ? Step::PREFIX : Step::INFIX;
+        }
+    }
+
+    precedence_ = enclosing;
+    return left;
+}
+
+// Runs the checks and emits the code that follow operand, which has just been compiled
+Parser::Operand Parser::CompileResume(Operand operand) {
+    using Kind = PendingOperator::Kind;
+    const PendingOperator pending = pending_.back();
+    pending_.pop_back();
+    precedence_ = pending.precedence;
+    // A parenthesised identifier is still just an identifier, e.g. "(f)()" is a valid call
+    if (pending.kind == Kind::GROUPING) {
+        Consume(TT::RIGHT_PAREN, "Expected ending ')' after expression");
+        return operand;
+    }
+
+    // Every other operand is used as a value
+    if (operand.symbol != NO_SYMBOL) analyser_->CheckIdentifier(operand.name, operand.symbol);
+    switch (pending.kind) {
+        case Kind::UNARY:
+            compiler_->EmitUnary(pending.op);
+            break;
+        case Kind::BINARY:
+            compiler_->EmitBinary(pending.op);
+            break;
+        case Kind::ASSIGNMENT:
+            analyser_->CheckAssignment(pending.target.name, pending.target.symbol);
+            break;
+        case Kind::ARGUMENT:
+            if (pending.argument_count >= 256) ErrorAtCur("Cannot have more than 256 arguments");
+            if (Match(TT::COMMA)) {
+                PendingOperator& next = Suspend(Kind::ARGUMENT, Precedence::ASSIGNMENT);
+                next.target = pending.target;
+                next.argument_count = pending.argument_count + 1;
+                break;
+            }
+            Consume(TT::RIGHT_PAREN, "Expected ) after arguments");
+            analyser_->CheckCall(pending.target.name, pending.target.symbol, pending.argument_count + 1);
+            break;
+        case Kind::GROUPING:
+            break;
+    }
+    return {};
+}
+
+Parser::Operand Parser::CompileAssignment(Operand left) {
+    if (left.symbol != NO_SYMBOL) {
+        Suspend(PendingOperator::Kind::ASSIGNMENT, Precedence::ASSIGNMENT).target = left;
+    } else {
+        ErrorAtCur("Can only assign values to identifiers");
+    }
+    return {};
+}
+
+Parser::Operand Parser::CompileBinary(Operand left) {
+    if (left.symbol != NO_SYMBOL) analyser_->CheckIdentifier(left.name, left.symbol);
+    TokenType op = prev_token_.type;
+    auto operand_precedence = static_cast<int>(GetRule(op).precedence);
+    Suspend(PendingOperator::Kind::BINARY, static_cast<Precedence>(operand_precedence + 1)).op = op;
+    return {};
+}
+
+Parser::Operand Parser::CompileUnary() {
+    Suspend(PendingOperator::Kind::UNARY, Precedence::UNARY).op = prev_token_.type;
+    return {};
+}
+
+Parser::Operand Parser::CompileLiteral() {
+    compiler_->EmitConstant(ParseLiteralValue());
+    return {};
+}
+
+Parser::Operand Parser::CompileGrouping() {
+    Suspend(PendingOperator::Kind::GROUPING, Precedence::ASSIGNMENT);
+    return {};
+}
+
+Parser::Operand Parser::CompileCall(Operand left) {
+    if (left.symbol == NO_SYMBOL) {
+        ErrorAtCur("Can only call functions");
+    } else if (!Check(TT::RIGHT_PAREN)) {
+        // The arguments are compiled as operands of the call, CompileResume checks the call after the last one
+        Suspend(PendingOperator::Kind::ARGUMENT, Precedence::ASSIGNMENT).target = left;
+    } else {
+        Consume(TT::RIGHT_PAREN, "Expected ) after arguments");
+        analyser_->CheckCall(left.name, left.symbol, 0);
+    }
+    return {};
+}
+
+Parser::Operand Parser::CompileIdentifier() {
+    return {prev_token_.lexeme, prev_token_.symbol};
+}
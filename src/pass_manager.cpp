@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+
+#include "pass_manager.h"
+#include "ast_walk.h"
+#include "constant_folder.h"
+#include "inliner.h"
+#include "peephole_optimiser.h"
+
+namespace {
+    class NodeCounter : public ASTVisitor {
+    public:
+        size_t count = 0;
+        void visit(Program &node) override { count++; Visit(node.declarations); }
+        void visit(FunDecl &node) override { count++; Visit(node.name); Visit(node.parameters); Visit(node.body); }
+        void visit(VarDecl &node) override { count++; Visit(node.variable); Visit(node.expression); }
+        void visit(ExprStmt &node) override { count++; Visit(node.expression); }
+        void visit(IfStmt &node) override { count++; Visit(node.condition); Visit(node.if_body); Visit(node.else_body); }
+        void visit(PrintStmt &node) override { count++; Visit(node.expression); }
+        void visit(ReturnStmt &node) override { count++; Visit(node.expression); }
+        void visit(WhileStmt &node) override { count++; Visit(node.condition); Visit(node.body); }
+        void visit(Block &node) override { count++; Visit(node.declarations); }
+        // Operands are counted by the walk in Visit, only the names and the Arguments node are left
+        void visit(Assignment &node) override { count += 2; }
+        void visit(Binary &node) override { count++; }
+        void visit(Unary &node) override { count++; }
+        void visit(Call &node) override { count += node.arguments == nullptr ? 2 : 3; }
+        void visit(Identifier &node) override { count++; }
+        void visit(Literal &node) override { count++; }
+        void visit(Parameters &node) override { count++; Visit(node.identifiers); }
+        void visit(Arguments &node) override { count++; Visit(node.expressions); }
+
+        template <typename T>
+        void Visit(T* node) {
+            if (node == nullptr) return;
+            if constexpr (std::is_base_of_v<Expression, T>) VisitExpression(node, *this);
+            else node->accept(*this);
+        }
+        template <typename T>
+        void Visit(std::pmr::vector<T*>& nodes) { for (auto* node : nodes) Visit(node); }
+    };
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+}
+
+size_t CountASTNodes(ASTNode &node) {
+    NodeCounter counter;
+    if (auto* expression = dynamic_cast<Expression*>(&node)) counter.Visit(expression);
+    else node.accept(counter);
+    return counter.count;
+}
+
+PassManager::PassManager(OptLevel opt_level)
+    : opt_level_(opt_level) {}
+
+PassManager PassManager::CreateDefault(OptLevel opt_level) {
+    PassManager pass_manager(opt_level);
+    pass_manager.AddASTPass(std::make_unique<Inliner>(), OptLevel::O2);
+    pass_manager.AddASTPass(std::make_unique<ConstantFolder>(), OptLevel::O1);
+    pass_manager.AddBytecodePass(std::make_unique<PeepholeOptimiser>(), OptLevel::O1);
+    return pass_manager;
+}
+
+void PassManager::AddASTPass(std::unique_ptr<ASTPass> pass, OptLevel min_level) {
+    ast_passes_.push_back({std::move(pass), min_level});
+}
+
+void PassManager::AddBytecodePass(std::unique_ptr<BytecodePass> pass, OptLevel min_level) {
+    bytecode_passes_.push_back({std::move(pass), min_level});
+}
+
+void PassManager::DisablePass(std::string_view pass_name) {
+    disabled_passes_.emplace(pass_name);
+}
+
+void PassManager::RunASTPasses(Program &program) {
+    for (auto& [pass, min_level] : ast_passes_) {
+        if (!IsEnabled(pass->Name(), min_level)) continue;
+        size_t before = CountASTNodes(program);
+        auto start = std::chrono::steady_clock::now();
+        pass->Run(program);
+        double wall_time_ms = MillisecondsSince(start);
+        Record(pass->Name(), wall_time_ms, before, CountASTNodes(program));
+    }
+}
+
+void PassManager::RunBytecodePasses(Chunk &chunk) {
+    for (auto& [pass, min_level] : bytecode_passes_) {
+        if (!IsEnabled(pass->Name(), min_level)) continue;
+        size_t before = chunk.InstructionCount();
+        auto start = std::chrono::steady_clock::now();
+        pass->Run(chunk);
+        double wall_time_ms = MillisecondsSince(start);
+        Record(pass->Name(), wall_time_ms, before, chunk.InstructionCount());
+    }
+}
+
+const std::vector<PassStats>& PassManager::GetStats() const {
+    return stats_;
+}
+
+OptLevel PassManager::GetOptLevel() const {
+    return opt_level_;
+}
+
+void PassManager::Record(std::string_view pass_name, double wall_time_ms, size_t before, size_t after) {
+    auto it = std::find_if(stats_.begin(), stats_.end(), [&](const PassStats& stats) { return stats.name == pass_name; });
+    if (it == stats_.end()) {
+        stats_.push_back({std::string(pass_name), wall_time_ms, before, after});
+        return;
+    }
+    it->wall_time_ms += wall_time_ms;
+    it->before += before;
+    it->after += after;
+}
+
+bool PassManager::IsEnabled(std::string_view pass_name, OptLevel min_level) const {
+    if (opt_level_ < min_level) return false;
+    return !disabled_passes_.contains(std::string(pass_name));
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+
+#include "peephole_optimiser.h"
+
+static constexpr size_t JUMP_SIZE = 3; // opcode + 16 bit offset
+
+static bool IsJump(OP op) {
+    return op == OP::JUMP || op == OP::JUMP_IF_FALSE;
+}
+
+static bool ProducesBool(OP op) {
+    return op == OP::EQUAL || op == OP::GREATER || op == OP::LESS || op == OP::NOT;
+}
+
+std::string_view PeepholeOptimiser::Name() const {
+    return "peephole";
+}
+
+void PeepholeOptimiser::Run(Chunk &chunk) {
+    std::vector<Instruction> instructions;
+    if (!Decode(chunk, instructions)) return;
+
+    std::vector<Instruction> output;
+    output.reserve(instructions.size());
+    for (auto& instruction : instructions) {
+        output.push_back(instruction);
+        while (TryReduceTail(output)) {}
+    }
+    if (output.size() == instructions.size()) return;
+
+    // Compute the new offset of every kept instruction
+    std::vector<size_t> new_offsets;
+    new_offsets.reserve(output.size() + 1);
+    size_t offset = 0;
+    for (auto& instruction : output) {
+        new_offsets.push_back(offset);
+        offset += 1 + GetOpDefinition(instruction.op).operand_width;
+    }
+    new_offsets.push_back(offset);
+
+    // A jump to a removed instruction lands on the first kept instruction after it
+    auto map_offset = [&](size_t old_offset) {
+        auto it = std::lower_bound(output.begin(), output.end(), old_offset,
+            [](const Instruction& instruction, size_t value) { return instruction.offset < value; });
+        return new_offsets[it - output.begin()];
+    };
+
+    std::vector<uint8_t> optimised;
+    optimised.reserve(offset);
+    for (size_t i = 0; i < output.size(); i++) {
+        auto& instruction = output[i];
+        uint64_t operand = instruction.operand;
+        if (IsJump(instruction.op)) {
+            size_t old_target = instruction.offset + JUMP_SIZE + operand;
+            operand = map_offset(old_target) - (new_offsets[i] + JUMP_SIZE);
+        }
+        optimised.push_back(static_cast<uint8_t>(instruction.op));
+        for (size_t byte = 0; byte < GetOpDefinition(instruction.op).operand_width; byte++) {
+            optimised.push_back(static_cast<uint8_t>(operand >> (8 * byte)));
+        }
+    }
+    chunk.ReplaceCode(std::move(optimised));
+}
+
+// Returns false if the chunk could not be decoded (truncated operands or jumps out of bounds)
+bool PeepholeOptimiser::Decode(const Chunk &chunk, std::vector<Instruction> &instructions) {
+    auto& code = chunk.GetCode();
+    for (size_t i = 0; i < code.size();) {
+        if (!IsValidOpCode(code[i])) return false;
+        auto op = static_cast<OP>(code[i]);
+        auto operand_width = GetOpDefinition(op).operand_width;
+        if (i + operand_width >= code.size()) return false;
+        uint64_t operand = 0;
+        for (size_t byte = 0; byte < operand_width; byte++) {
+            operand |= static_cast<uint64_t>(code[i + 1 + byte]) << (8 * byte);
+        }
+        instructions.push_back({op, operand, i, false});
+        i += 1 + operand_width;
+    }
+
+    for (auto& instruction : instructions) {
+        if (!IsJump(instruction.op)) continue;
+        size_t target = instruction.offset + JUMP_SIZE + instruction.operand;
+        if (target == code.size()) continue;
+        auto it = std::lower_bound(instructions.begin(), instructions.end(), target,
+            [](const Instruction& other, size_t value) { return other.offset < value; });
+        if (it == instructions.end() || it->offset != target) return false;
+        it->is_jump_target = true;
+    }
+    return true;
+}
+
+// Tries to remove a pattern at the end of output. Instructions that something jumps
+// to are only removed if doing so keeps the behaviour for the jumping code the same.
+bool PeepholeOptimiser::TryReduceTail(std::vector<Instruction> &output) {
+    size_t size = output.size();
+    if (size >= 2) {
+        auto& first = output[size - 2];
+        auto& second = output[size - 1];
+        bool is_constant = first.op == OP::CONSTANT || first.op == OP::CONSTANT_LONG;
+        if (is_constant && second.op == OP::POP && !second.is_jump_target) {
+            output.resize(size - 2);
+            return true;
+        }
+    }
+    if (size >= 3) {
+        auto& producer = output[size - 3];
+        auto& first_not = output[size - 2];
+        auto& second_not = output[size - 1];
+        if (ProducesBool(producer.op) && first_not.op == OP::NOT && second_not.op == OP::NOT &&
+            !first_not.is_jump_target && !second_not.is_jump_target) {
+            output.resize(size - 2);
+            return true;
+        }
+    }
+    return false;
+}
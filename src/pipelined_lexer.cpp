@@ -0,0 +1,71 @@
+#include "pipelined_lexer.h"
+
+PipelinedLexer::PipelinedLexer(Lexer& lexer)
+    : lexer_(lexer)
+    , ring_(CAPACITY, Token(TT::NONE, "", 0))
+    , thread_(&PipelinedLexer::Produce, this)
+{}
+
+PipelinedLexer::~PipelinedLexer() {
+    stop_.store(true, std::memory_order_relaxed);
+    // Wakes the lexer thread if it is blocked on a full ring, it then sees stop_ before writing more than one token
+    read_.fetch_add(1, std::memory_order_release);
+    read_.notify_one();
+    thread_.join();
+}
+
+void PipelinedLexer::WaitForChange(const std::atomic<size_t>& position, size_t old) {
+    // The other side usually publishes again soon, so spin for a bit before going to sleep
+    for (size_t spin = 0; spin < SPIN_COUNT; spin++) {
+        if (position.load(std::memory_order_acquire) != old) return;
+        std::this_thread::yield();
+    }
+    position.wait(old, std::memory_order_acquire);
+}
+
+void PipelinedLexer::Publish(std::atomic<size_t>& position, size_t value) {
+    position.store(value, std::memory_order_release);
+    position.notify_one();
+}
+
+void PipelinedLexer::Produce() {
+    size_t write_index = 0;
+    size_t writable_end = CAPACITY; // Last value of read_ the lexer thread saw, plus CAPACITY
+    bool has_ended = false;
+    while (!has_ended) {
+        size_t batch_end = write_index + BATCH_SIZE;
+        while (write_index < batch_end && !has_ended) {
+            if (write_index == writable_end) {
+                // The ring is full, hand over what has been written and wait for the consumer to free slots
+                Publish(written_, write_index);
+                while ((writable_end = read_.load(std::memory_order_acquire) + CAPACITY) == write_index) {
+                    if (stop_.load(std::memory_order_relaxed)) return;
+                    WaitForChange(read_, write_index - CAPACITY);
+                }
+            }
+            Token token = lexer_.ReadNextToken();
+            has_ended = token.type == TT::END;
+            ring_[write_index & MASK] = token;
+            write_index++;
+        }
+        Publish(written_, write_index);
+    }
+}
+
+Token PipelinedLexer::ReadNextToken() {
+    if (end_.has_value()) return *end_;
+
+    if (read_index_ == readable_end_) {
+        Publish(read_, read_index_);
+        while ((readable_end_ = written_.load(std::memory_order_acquire)) == read_index_) {
+            WaitForChange(written_, read_index_);
+        }
+    }
+    Token token = ring_[read_index_ & MASK];
+    read_index_++;
+    // Frees a batch of slots at a time, so the lexer thread can keep going while the rest is being read
+    if (read_index_ % BATCH_SIZE == 0) Publish(read_, read_index_);
+
+    if (token.type == TT::END) end_ = token;
+    return token;
+}
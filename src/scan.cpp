@@ -0,0 +1,155 @@
+#include <bit>
+#include <cstdint>
+
+#include "scan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+    enum class Target {
+        NON_WHITESPACE,
+        LINE_END,
+        STRING_END,
+    };
+
+    template <Target T>
+    constexpr bool IsStop(char c) {
+        if constexpr (T == Target::NON_WHITESPACE) return c != ' ' && c != '\t' && c != '\r' && c != '\n';
+        if constexpr (T == Target::LINE_END) return c == '\n' || c == '\0';
+        if constexpr (T == Target::STRING_END) return c == '"' || c == '\0';
+    }
+
+    template <Target T>
+    size_t FindScalar(const char* data, size_t index, size_t size, size_t& line) {
+        for (; index < size && !IsStop<T>(data[index]); index++) {
+            if (data[index] == '\n') line++;
+        }
+        return index;
+    }
+
+    // Given a bit mask of stop characters and newlines in a block, either returns the offset of the first stop
+    // (counting the newlines before it) or counts all newlines in the block and returns width
+    size_t ConsumeBlock(uint32_t stops, uint32_t newlines, size_t width, size_t& line) {
+        if (stops == 0) {
+            line += std::popcount(newlines);
+            return width;
+        }
+        auto first = std::countr_zero(stops);
+        line += std::popcount(newlines & ((1u << first) - 1));
+        return first;
+    }
+
+#ifdef SCAN_X86
+    template <Target T>
+    size_t FindSse2(const char* data, size_t index, size_t size, size_t& line) {
+        constexpr size_t WIDTH = 16;
+        const __m128i newline = _mm_set1_epi8('\n');
+        while (index + WIDTH <= size) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+            auto newlines = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+            uint32_t stops;
+            if constexpr (T == Target::NON_WHITESPACE) {
+                __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                                _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')),
+                                             _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+                stops = ~(static_cast<uint32_t>(_mm_movemask_epi8(blank)) | newlines) & 0xffff;
+            } else {
+                __m128i stop = _mm_cmpeq_epi8(block, _mm_setzero_si128());
+                if constexpr (T == Target::LINE_END) stop = _mm_or_si128(stop, _mm_cmpeq_epi8(block, newline));
+                if constexpr (T == Target::STRING_END) stop = _mm_or_si128(stop, _mm_cmpeq_epi8(block, _mm_set1_epi8('"')));
+                stops = static_cast<uint32_t>(_mm_movemask_epi8(stop));
+            }
+            size_t consumed = ConsumeBlock(stops, newlines, WIDTH, line);
+            index += consumed;
+            if (consumed != WIDTH) return index;
+        }
+        return FindScalar<T>(data, index, size, line);
+    }
+
+    template <Target T>
+    __attribute__((target("avx2")))
+    size_t FindAvx2(const char* data, size_t index, size_t size, size_t& line) {
+        constexpr size_t WIDTH = 32;
+        const __m256i newline = _mm256_set1_epi8('\n');
+        while (index + WIDTH <= size) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+            auto newlines = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+            uint32_t stops;
+            if constexpr (T == Target::NON_WHITESPACE) {
+                __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')),
+                                                _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r'))));
+                stops = ~(static_cast<uint32_t>(_mm256_movemask_epi8(blank)) | newlines);
+            } else {
+                __m256i stop = _mm256_cmpeq_epi8(block, _mm256_setzero_si256());
+                if constexpr (T == Target::LINE_END) stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(block, newline));
+                if constexpr (T == Target::STRING_END) stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')));
+                stops = static_cast<uint32_t>(_mm256_movemask_epi8(stop));
+            }
+            size_t consumed = ConsumeBlock(stops, newlines, WIDTH, line);
+            index += consumed;
+            if (consumed != WIDTH) return index;
+        }
+        return FindScalar<T>(data, index, size, line);
+    }
+#endif
+
+    Scan::Kernel GetBestKernel() {
+#ifdef SCAN_X86
+        if (__builtin_cpu_supports("avx2")) return Scan::Kernel::AVX2;
+        return Scan::Kernel::SSE2;
+#else
+        return Scan::Kernel::SCALAR;
+#endif
+    }
+
+    Scan::Kernel active_kernel = GetBestKernel();
+
+    template <Target T>
+    size_t Find(std::string_view text, size_t index, size_t& line) {
+        // Most runs are a single character (e.g. one space between tokens), which isn't worth a vector load
+        if (index >= text.size() || IsStop<T>(text[index])) return index;
+        switch (active_kernel) {
+#ifdef SCAN_X86
+            case Scan::Kernel::AVX2: return FindAvx2<T>(text.data(), index, text.size(), line);
+            case Scan::Kernel::SSE2: return FindSse2<T>(text.data(), index, text.size(), line);
+#endif
+            default: return FindScalar<T>(text.data(), index, text.size(), line);
+        }
+    }
+}
+
+bool Scan::IsSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR: return true;
+#ifdef SCAN_X86
+        case Kernel::SSE2: return true;
+        case Kernel::AVX2: return __builtin_cpu_supports("avx2");
+#endif
+        default: return false;
+    }
+}
+
+void Scan::SetKernel(Kernel kernel) {
+    if (IsSupported(kernel)) active_kernel = kernel;
+}
+
+Scan::Kernel Scan::GetKernel() {
+    return active_kernel;
+}
+
+size_t Scan::SkipWhitespace(std::string_view text, size_t index, size_t &line) {
+    return Find<Target::NON_WHITESPACE>(text, index, line);
+}
+
+size_t Scan::FindLineEnd(std::string_view text, size_t index) {
+    size_t line = 0;
+    return Find<Target::LINE_END>(text, index, line);
+}
+
+size_t Scan::FindStringEnd(std::string_view text, size_t index, size_t &line) {
+    return Find<Target::STRING_END>(text, index, line);
+}
@@ -2,11 +2,104 @@
 #include <cassert>
 
 #include "semantic_analyser.h"
+#include "ast_walk.h"
+#include "parallel_for.h"
+
+static void ReportError(const std::string& msg) {
+    std::cerr << "[SEMANTIC ERROR]: " << msg << std::endl;
+}
 
 SemanticAnalyser::SemanticAnalyser() {
     PushScope();
 }
 
+SemanticAnalyser::SemanticAnalyser(const SemanticAnalyser& globals, size_t declaration_index,
+                                   std::vector<std::string>* diagnostics)
+    : diagnostics_(diagnostics), globals_(&globals), declaration_index_(declaration_index) {
+    PushScope();
+}
+
+void SemanticAnalyser::Analyse(const FlatAST& ast) {
+    AnalyseNode(ast, ast.GetRoot());
+}
+
+void SemanticAnalyser::Analyse(Program& program, size_t thread_count) {
+    if (thread_count <= 1) {
+        program.accept(*this);
+        return;
+    }
+
+    // Phase one fills the global scope, which stays read-only from here on. Errors are kept per declaration
+    // so they can be printed in source order
+    std::vector<std::vector<std::string>> diagnostics(program.declarations.size());
+    std::vector<size_t> functions = AnalyseGlobals(program, &diagnostics);
+
+    // Phase two: the bodies, each with its own scope stack on top of the shared global scope
+    std::vector<size_t> error_counts(functions.size());
+    ParallelFor(functions.size(), thread_count, [&](size_t i) {
+        size_t index = functions[i];
+        SemanticAnalyser analyser(*this, index, &diagnostics[index]);
+        analyser.AnalyseFunctionBody(*static_cast<FunDecl*>(program.declarations[index]));
+        error_counts[i] = analyser.GetErrorCount();
+    });
+    for (size_t error_count : error_counts) error_count_ += error_count;
+    for (auto& messages : diagnostics) {
+        for (auto& msg : messages) {
+            if (diagnostics_ != nullptr) diagnostics_->push_back(std::move(msg));
+            else ReportError(msg);
+        }
+    }
+    global_order_.clear();
+    deferred_functions_.clear();
+}
+
+void SemanticAnalyser::DeclareGlobals(Program& program) {
+    global_order_.clear();
+    deferred_functions_.clear();
+    AnalyseGlobals(program, nullptr);
+}
+
+void SemanticAnalyser::AnalyseFunction(FunDecl& function) {
+    auto deferred = deferred_functions_.find(&function);
+    assert(deferred != deferred_functions_.end());
+    SemanticAnalyser analyser(*this, deferred->second, diagnostics_);
+    analyser.AnalyseFunctionBody(function);
+    error_count_ += analyser.GetErrorCount();
+}
+
+std::vector<size_t> SemanticAnalyser::AnalyseGlobals(Program& program,
+                                                     std::vector<std::vector<std::string>>* diagnostics) {
+    assert(scopes_.Depth() == 1);
+    std::vector<std::string>* enclosing_diagnostics = diagnostics_;
+    const auto& declarations = program.declarations;
+    std::vector<size_t> functions;
+    for (size_t i = 0; i < declarations.size(); i++) {
+        if (diagnostics != nullptr) diagnostics_ = &(*diagnostics)[i];
+        if (auto* function = dynamic_cast<FunDecl*>(declarations[i])) {
+            if (scopes_.GetSymbol(function->name->symbol) == nullptr) global_order_[function->name->symbol] = i;
+            size_t parameter_count = function->parameters == nullptr ? 0 : function->parameters->identifiers.size();
+            DeclareFunction(function->name->name, function->name->symbol, parameter_count);
+            deferred_functions_[function] = i;
+            functions.push_back(i);
+            continue;
+        }
+        if (auto* variable = dynamic_cast<VarDecl*>(declarations[i])) {
+            if (scopes_.GetSymbol(variable->variable->symbol) == nullptr) global_order_[variable->variable->symbol] = i;
+        }
+        declarations[i]->accept(*this);
+    }
+    diagnostics_ = enclosing_diagnostics;
+    return functions;
+}
+
+size_t SemanticAnalyser::GetErrorCount() const {
+    return error_count_;
+}
+
+void SemanticAnalyser::SetDiagnostics(std::vector<std::string>* diagnostics) {
+    diagnostics_ = diagnostics;
+}
+
 void SemanticAnalyser::visit(Program &node) {
     for (auto& declaration : node.declarations) {
         declaration->accept(*this);
@@ -15,29 +108,28 @@ void SemanticAnalyser::visit(Program &node) {
 
 void SemanticAnalyser::visit(FunDecl &node) {
     size_t parameter_count = node.parameters == nullptr ? 0 : node.parameters->identifiers.size();
-    FunctionInfo function_info = {std::string(node.name->name), parameter_count};
-    Symbol sym = { SymbolType::FUNCTION, function_info };
-    bool result = scopes_.back().AddSymbol(std::string(node.name->name), sym);
-    if (!result) Error(std::string(node.name->name) + " is already defined");
+    DeclareFunction(node.name->name, node.name->symbol, parameter_count);
+    AnalyseFunctionBody(node);
+}
+
+void SemanticAnalyser::AnalyseFunctionBody(FunDecl& node) {
     PushScope();
-    if (parameter_count > 0) node.parameters->accept(*this);
+    if (node.parameters != nullptr) node.parameters->accept(*this);
     node.body->accept(*this);
     PopScope();
 }
 
 void SemanticAnalyser::visit(VarDecl &node) {
-    VariableInfo variable_info = { std::string(node.variable->name) };
-    Symbol sym = { SymbolType::VARIABLE, variable_info };
-    bool result = scopes_.back().AddSymbol(std::string(node.variable->name), sym);
-    if (!result) Error(std::string(node.variable->name) + " is already defined");
-    node.expression->accept(*this);
+    DeclareVariable(node.variable->name, node.variable->symbol);
+    VisitExpression(node.expression, *this);
 }
 
 void SemanticAnalyser::visit(ExprStmt &node) {
-    node.expression->accept(*this);
+    VisitExpression(node.expression, *this);
 }
 
 void SemanticAnalyser::visit(IfStmt &node) {
+    VisitExpression(node.condition, *this);
     node.if_body->accept(*this);
     if (node.else_body != nullptr) {
         node.else_body->accept(*this);
@@ -45,14 +137,15 @@ void SemanticAnalyser::visit(IfStmt &node) {
 }
 
 void SemanticAnalyser::visit(PrintStmt &node) {
-    node.expression->accept(*this);
+    VisitExpression(node.expression, *this);
 }
 
 void SemanticAnalyser::visit(ReturnStmt &node) {
-    node.expression->accept(*this);
+    VisitExpression(node.expression, *this);
 }
 
 void SemanticAnalyser::visit(WhileStmt &node) {
+    VisitExpression(node.condition, *this);
     node.body->accept(*this);
 }
 
@@ -64,43 +157,25 @@ void SemanticAnalyser::visit(Block &node) {
     PopScope();
 }
 
+// Expressions are reached through VisitExpression, which has already checked their operands
+
 void SemanticAnalyser::visit(Assignment &node) {
-    if (!CheckSymbol(std::string(node.variable->name))) {
-        Error("undefined variable: " + std::string(node.variable->name));
-    }
-    node.expression->accept(*this);
+    CheckAssignment(node.variable->name, node.variable->symbol);
 }
 
 void SemanticAnalyser::visit(Binary &node) {
-    node.left_expression->accept(*this);
-    node.right_expression->accept(*this);
 }
 
 void SemanticAnalyser::visit(Unary &node) {
-    node.expression->accept(*this);
 }
 
 void SemanticAnalyser::visit(Call &node) {
-    auto symbol = GetSymbol(std::string(node.callee->name));
-    if (symbol == nullptr) {
-        Error("Call to undefined function " + std::string(node.callee->name));
-        return;
-    }
-    if (!std::holds_alternative<FunctionInfo>(symbol->object)) {
-        Error(std::string(node.callee->name) + " is not a function");
-    }
-    auto function_info = std::get<FunctionInfo>(symbol->object);
     size_t call_argument_count = node.arguments == nullptr ? 0 : node.arguments->expressions.size();
-    if (call_argument_count != function_info.parameter_count) {
-        Error("Invalid argument count when calling function: " + std::string(node.callee->name) +
-                    ",\n\tExpected: " + std::to_string(function_info.parameter_count) + ", Actual: " + std::to_string(call_argument_count));
-    }
+    CheckCall(node.callee->name, node.callee->symbol, call_argument_count);
 }
 
 void SemanticAnalyser::visit(Identifier &node) {
-    if (!CheckSymbol(std::string(node.name))) {
-        Error("Undefined identifier " + std::string(node.name));
-    }
+    CheckIdentifier(node.name, node.symbol);
 }
 
 void SemanticAnalyser::visit(Literal &node) {
@@ -109,41 +184,171 @@ void SemanticAnalyser::visit(Literal &node) {
 
 void SemanticAnalyser::visit(Parameters &node) {
     for (auto& identifier : node.identifiers) {
-        VariableInfo variable_info = { std::string(identifier->name) };
-        Symbol symbol = { SymbolType::VARIABLE, variable_info };
-        scopes_.back().AddSymbol(std::string(identifier->name), symbol);
+        DeclareParameter(identifier->name, identifier->symbol);
     }
 }
 
 void SemanticAnalyser::visit(Arguments &node) {
-    return;
+    for (auto& expression : node.expressions) {
+        VisitExpression(expression, *this);
+    }
+}
+
+// Mirrors the visit functions above, node by node. Expressions are reached through AnalyseExpression
+void SemanticAnalyser::AnalyseNode(const FlatAST& ast, NodeIndex index) {
+    const FlatNode& node = ast.GetNode(index);
+    switch (node.kind) {
+        case NodeKind::PROGRAM:
+            for (NodeIndex child : ast.GetChildren(node)) AnalyseNode(ast, child);
+            break;
+        case NodeKind::FUN_DECL: {
+            const FlatNode& name = ast.GetNode(node.first);
+            size_t parameter_count = node.second == NO_NODE ? 0 : ast.GetNode(node.second).second;
+            DeclareFunction(ast.GetName(name), ast.GetSymbol(name), parameter_count);
+            PushScope();
+            if (parameter_count > 0) AnalyseNode(ast, node.second);
+            AnalyseNode(ast, node.third);
+            PopScope();
+            break;
+        }
+        case NodeKind::VAR_DECL: {
+            const FlatNode& variable = ast.GetNode(node.first);
+            DeclareVariable(ast.GetName(variable), ast.GetSymbol(variable));
+            AnalyseExpression(ast, node.second);
+            break;
+        }
+        case NodeKind::EXPR_STMT:
+        case NodeKind::PRINT_STMT:
+        case NodeKind::RETURN_STMT:
+            AnalyseExpression(ast, node.first);
+            break;
+        case NodeKind::IF_STMT:
+            AnalyseExpression(ast, node.first);
+            AnalyseNode(ast, node.second);
+            if (node.third != NO_NODE) AnalyseNode(ast, node.third);
+            break;
+        case NodeKind::WHILE_STMT:
+            AnalyseExpression(ast, node.first);
+            AnalyseNode(ast, node.second);
+            break;
+        case NodeKind::BLOCK:
+            PushScope();
+            for (NodeIndex child : ast.GetChildren(node)) AnalyseNode(ast, child);
+            PopScope();
+            break;
+        case NodeKind::ASSIGNMENT: {
+            const FlatNode& variable = ast.GetNode(node.first);
+            CheckAssignment(ast.GetName(variable), ast.GetSymbol(variable));
+            break;
+        }
+        case NodeKind::CALL: {
+            const FlatNode& callee = ast.GetNode(node.first);
+            size_t call_argument_count = node.second == NO_NODE ? 0 : ast.GetNode(node.second).second;
+            CheckCall(ast.GetName(callee), ast.GetSymbol(callee), call_argument_count);
+            break;
+        }
+        case NodeKind::IDENTIFIER:
+            CheckIdentifier(ast.GetName(node), ast.GetSymbol(node));
+            break;
+        case NodeKind::PARAMETERS:
+            for (NodeIndex child : ast.GetChildren(node)) {
+                const FlatNode& identifier = ast.GetNode(child);
+                DeclareParameter(ast.GetName(identifier), ast.GetSymbol(identifier));
+            }
+            break;
+        case NodeKind::ARGUMENTS:
+            for (NodeIndex child : ast.GetChildren(node)) AnalyseExpression(ast, child);
+            break;
+        case NodeKind::BINARY:
+        case NodeKind::UNARY:
+        case NodeKind::LITERAL:
+            break;
+    }
+}
+
+void SemanticAnalyser::AnalyseExpression(const FlatAST& ast, NodeIndex index) {
+    if (index == NO_NODE) return;
+    ast.WalkExpression(index, [&](NodeIndex expression) { AnalyseNode(ast, expression); });
+}
+
+void SemanticAnalyser::DeclareFunction(std::string_view name, SymbolId symbol_id, size_t parameter_count) {
+    FunctionInfo function_info = {name, parameter_count};
+    Symbol sym = { SymbolType::FUNCTION, function_info };
+    bool result = scopes_.AddSymbol(symbol_id, sym);
+    if (!result) Error(std::string(name) + " is already defined");
+}
+
+void SemanticAnalyser::DeclareVariable(std::string_view name, SymbolId symbol_id) {
+    VariableInfo variable_info = { name };
+    Symbol sym = { SymbolType::VARIABLE, variable_info };
+    bool result = scopes_.AddSymbol(symbol_id, sym);
+    if (!result) Error(std::string(name) + " is already defined");
+}
+
+// Duplicate parameter names are not reported, the first one wins
+void SemanticAnalyser::DeclareParameter(std::string_view name, SymbolId symbol_id) {
+    VariableInfo variable_info = { name };
+    Symbol symbol = { SymbolType::VARIABLE, variable_info };
+    scopes_.AddSymbol(symbol_id, symbol);
+}
+
+void SemanticAnalyser::CheckAssignment(std::string_view name, SymbolId symbol_id) {
+    if (!CheckSymbol(symbol_id)) {
+        Error("undefined variable: " + std::string(name));
+    }
+}
+
+void SemanticAnalyser::CheckIdentifier(std::string_view name, SymbolId symbol_id) {
+    if (!CheckSymbol(symbol_id)) {
+        Error("Undefined identifier " + std::string(name));
+    }
+}
+
+void SemanticAnalyser::CheckCall(std::string_view name, SymbolId symbol_id, size_t call_argument_count) {
+    auto symbol = GetSymbol(symbol_id);
+    if (symbol == nullptr) {
+        Error("Call to undefined function " + std::string(name));
+        return;
+    }
+    if (!std::holds_alternative<FunctionInfo>(symbol->object)) {
+        Error(std::string(name) + " is not a function");
+        return;
+    }
+    auto function_info = std::get<FunctionInfo>(symbol->object);
+    if (call_argument_count != function_info.parameter_count) {
+        Error("Invalid argument count when calling function: " + std::string(name) +
+                    ",\n\tExpected: " + std::to_string(function_info.parameter_count) + ", Actual: " + std::to_string(call_argument_count));
+    }
 }
 
 void SemanticAnalyser::PushScope() {
-    scopes_.push_back({});
+    scopes_.PushScope();
 }
 
 void SemanticAnalyser::PopScope() {
-    assert(scopes_.size() >= 2);
-    scopes_.pop_back();
+    assert(scopes_.Depth() >= 2);
+    scopes_.PopScope();
 }
 
 void SemanticAnalyser::Error(std::string msg) {
-    std::cerr << "[SEMANTIC ERROR]: " << msg << std::endl;
+    error_count_++;
+    if (diagnostics_ != nullptr) diagnostics_->push_back(std::move(msg));
+    else ReportError(msg);
 }
 
-bool SemanticAnalyser::CheckSymbol(std::string symbol_name) {
-    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
-        if (it->Contains(symbol_name)) return true;
-    }
-    return false;
+bool SemanticAnalyser::CheckSymbol(SymbolId symbol_id) {
+    return GetSymbol(symbol_id) != nullptr;
 }
 
-const Symbol* SemanticAnalyser::GetSymbol(std::string symbol_name) {
-    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
-        if (it->Contains(symbol_name)) {
-            return it->GetSymbol(symbol_name);
-        }
-    }
-    return nullptr;
+const Symbol* SemanticAnalyser::GetSymbol(SymbolId symbol_id) {
+    if (const Symbol* symbol = scopes_.GetSymbol(symbol_id)) return symbol;
+    return globals_ == nullptr ? nullptr : globals_->GetGlobal(symbol_id, declaration_index_);
+}
+
+// Globals declared by a later top-level declaration don't exist yet when the serial analysis reaches the body
+const Symbol* SemanticAnalyser::GetGlobal(SymbolId symbol_id, size_t declaration_index) const {
+    auto order = global_order_.find(symbol_id);
+    if (order != global_order_.end() && order->second > declaration_index) return nullptr;
+    assert(scopes_.Depth() == 1); // So that only globals are found
+    return scopes_.GetSymbol(symbol_id);
 }
@@ -0,0 +1,98 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "source_file.h"
+
+namespace {
+    std::runtime_error IOError(const std::string& name, const std::string& action) {
+        return std::runtime_error("Could not " + action + " " + name + ": " + std::strerror(errno));
+    }
+}
+
+SourceFile SourceFile::Open(const std::string& path) {
+    if (path == "-") return FromDescriptor(STDIN_FILENO, "<stdin>");
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw IOError(path, "open");
+    try {
+        SourceFile source_file = FromDescriptor(fd, path);
+        ::close(fd);
+        return source_file;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+SourceFile SourceFile::FromDescriptor(int fd, const std::string& name) {
+    SourceFile source_file;
+    struct stat info{};
+    if (::fstat(fd, &info) != 0) throw IOError(name, "stat");
+
+    // Empty files can't be mapped, and reading them is free anyway
+    if (S_ISREG(info.st_mode) && info.st_size > 0) {
+        auto size = static_cast<size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            ::madvise(mapping, size, MADV_SEQUENTIAL); // The lexer reads it front to back once
+            source_file.mapping_ = static_cast<const char*>(mapping);
+            source_file.mapping_size_ = size;
+            return source_file;
+        }
+    }
+
+    // Pipes, terminals and anything else that can't be mapped
+    char block[64 * 1024];
+    while (true) {
+        ssize_t count = ::read(fd, block, sizeof(block));
+        if (count == 0) break;
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            throw IOError(name, "read");
+        }
+        source_file.buffer_.insert(source_file.buffer_.end(), block, block + count);
+    }
+    return source_file;
+}
+
+SourceFile::SourceFile(SourceFile&& other) noexcept
+    : mapping_(std::exchange(other.mapping_, nullptr))
+    , mapping_size_(std::exchange(other.mapping_size_, 0))
+    , buffer_(std::move(other.buffer_))
+{}
+
+SourceFile& SourceFile::operator=(SourceFile&& other) noexcept {
+    if (this != &other) {
+        Unmap();
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        mapping_size_ = std::exchange(other.mapping_size_, 0);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+SourceFile::~SourceFile() {
+    Unmap();
+}
+
+std::string_view SourceFile::GetText() const {
+    if (IsMapped()) return {mapping_, mapping_size_};
+    return {buffer_.data(), buffer_.size()};
+}
+
+bool SourceFile::IsMapped() const {
+    return mapping_ != nullptr;
+}
+
+void SourceFile::Unmap() {
+    if (mapping_ != nullptr) ::munmap(const_cast<char*>(mapping_), mapping_size_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+}
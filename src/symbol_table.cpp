@@ -1,18 +1,49 @@
+#include <cassert>
+
 #include "symbol_table.h"
 
-bool SymbolTable::AddSymbol(std::string symbol_name, Symbol symbol) {
-    if (Contains(symbol_name)) return false;
-    table_.emplace(symbol_name, std::move(symbol));
-    return true;
+bool SymbolTable::AddSymbol(SymbolId symbol_id, Symbol symbol) {
+    return table_.try_emplace(symbol_id, std::move(symbol)).second;
+}
+
+bool SymbolTable::Contains(SymbolId symbol_id) const {
+    return table_.contains(symbol_id);
 }
 
-bool SymbolTable::Contains(std::string symbol_name) const {
-    return table_.contains(symbol_name);
+const Symbol* SymbolTable::GetSymbol(SymbolId symbol_id) const {
+    auto it = table_.find(symbol_id);
+    return it == table_.end() ? nullptr : &it->second;
 }
 
-const Symbol* SymbolTable::GetSymbol(std::string symbol_name) const {
-    if (Contains(symbol_name)) {
-        return &table_.find(symbol_name)->second;
+void ScopeChain::PushScope() {
+    scope_starts_.push_back(static_cast<uint32_t>(bindings_.size()));
+}
+
+void ScopeChain::PopScope() {
+    assert(!scope_starts_.empty());
+    for (size_t i = bindings_.size(); i > scope_starts_.back(); i--) {
+        const Binding& binding = bindings_[i - 1];
+        innermost_[binding.symbol_id] = binding.shadowed;
     }
-    return nullptr;
+    bindings_.erase(bindings_.begin() + scope_starts_.back(), bindings_.end());
+    scope_starts_.pop_back();
+}
+
+bool ScopeChain::AddSymbol(SymbolId symbol_id, Symbol symbol) {
+    assert(!scope_starts_.empty());
+    auto [innermost, inserted] = innermost_.try_emplace(symbol_id, NO_BINDING);
+    if (innermost->second != NO_BINDING && innermost->second >= scope_starts_.back()) return false;
+    bindings_.push_back({symbol_id, innermost->second, std::move(symbol)});
+    innermost->second = static_cast<uint32_t>(bindings_.size() - 1);
+    return true;
+}
+
+const Symbol* ScopeChain::GetSymbol(SymbolId symbol_id) const {
+    auto innermost = innermost_.find(symbol_id);
+    if (innermost == innermost_.end() || innermost->second == NO_BINDING) return nullptr;
+    return &bindings_[innermost->second].symbol;
+}
+
+size_t ScopeChain::Depth() const {
+    return scope_starts_.size();
 }
@@ -0,0 +1,81 @@
+#include <iostream>
+#include <vector>
+
+#include "verifier.h"
+
+bool Verifier::Verify(Chunk &chunk, size_t initial_depth) {
+    error_.clear();
+    const auto& code = chunk.GetCode();
+    constexpr int UNVISITED = -1;
+    std::vector<int> depth_at(code.size() + 1, UNVISITED); // Stack depth on entry, indexed by offset
+    std::vector<bool> is_instruction_start(code.size() + 1, false);
+
+    // Decode linearly first, so jumps into the middle of an instruction can be detected
+    for (size_t offset = 0; offset < code.size();) {
+        if (!IsValidOpCode(code[offset])) return Error(offset, "Invalid opcode " + std::to_string(code[offset]));
+        is_instruction_start[offset] = true;
+        offset += 1 + GetOpDefinition(static_cast<OP>(code[offset])).operand_width;
+        if (offset > code.size()) return Error(offset, "Truncated operand");
+    }
+    is_instruction_start[code.size()] = true;
+
+    // Walk every path, recording the depth the first time an offset is reached
+    size_t max_depth = initial_depth;
+    std::vector<std::pair<size_t, int>> worklist = {{0, static_cast<int>(initial_depth)}};
+    auto reach = [&](size_t from, size_t target, int depth) {
+        if (target > code.size() || !is_instruction_start[target]) {
+            return Error(from, "Jump target " + std::to_string(target) + " is not an instruction");
+        }
+        if (depth_at[target] == UNVISITED) {
+            depth_at[target] = depth;
+            worklist.emplace_back(target, depth);
+        } else if (depth_at[target] != depth) {
+            return Error(target, "Inconsistent stack depth, " + std::to_string(depth_at[target]) +
+                                 " and " + std::to_string(depth));
+        }
+        return true;
+    };
+    if (!code.empty()) depth_at[0] = static_cast<int>(initial_depth);
+
+    while (!worklist.empty()) {
+        auto [offset, depth] = worklist.back();
+        worklist.pop_back();
+        if (offset == code.size()) continue;
+
+        auto op = static_cast<OP>(code[offset]);
+        const auto& definition = GetOpDefinition(op);
+        uint64_t operand = 0;
+        for (size_t i = 0; i < definition.operand_width; i++) {
+            operand |= static_cast<uint64_t>(code[offset + 1 + i]) << (8 * i);
+        }
+
+        if (depth < definition.pops) return Error(offset, "Stack underflow in " + std::string(definition.name));
+        depth += definition.pushes - definition.pops;
+        max_depth = std::max(max_depth, static_cast<size_t>(depth));
+
+        if ((op == OP::CONSTANT || op == OP::CONSTANT_LONG) && operand >= chunk.GetConstants().size()) {
+            return Error(offset, "Constant index " + std::to_string(operand) + " out of range");
+        }
+
+        size_t next = offset + 1 + definition.operand_width;
+        if (op == OP::JUMP || op == OP::JUMP_IF_FALSE) {
+            if (!reach(offset, next + operand, depth)) return false;
+        }
+        if (op != OP::JUMP) {
+            if (!reach(offset, next, depth)) return false;
+        }
+    }
+
+    chunk.SetMaxStackDepth(max_depth - initial_depth);
+    return true;
+}
+
+const std::string& Verifier::GetError() const {
+    return error_;
+}
+
+bool Verifier::Error(size_t offset, std::string msg) {
+    error_ = "at offset " + std::to_string(offset) + ": " + msg;
+    std::cerr << "[VERIFY ERROR] " << error_ << std::endl;
+    return false;
+}
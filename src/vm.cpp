@@ -7,8 +7,8 @@
 #include <cassert>
 #include <boost/test/tools/assertion.hpp>
 
-VM::VM(const Chunk& chunk)
-    : chunk_(chunk)
+VM::VM()
+    : chunk_(nullptr)
     , pc_(0)
     , sp_(0)
     , stack_has_changed_(false) {
@@ -16,14 +16,40 @@ VM::VM(const Chunk& chunk)
     error_logger_ = std::move(error_logger_);
 }
 
-void VM::Interpret() {
+VM::VM(const Chunk& chunk) : VM() {
+    chunk_ = &chunk;
+}
+
+bool VM::Interpret(const Chunk& chunk) {
+    chunk_ = &chunk;
+    pc_ = 0;
+    return Interpret();
+}
+
+size_t VM::GetStackDepth() const {
+    return static_cast<size_t>(sp_);
+}
+
+bool VM::Interpret() {
+    // The Verifier guarantees that pushes and pops stay within max_stack_depth, so space is only checked here
+    auto max_stack_depth = chunk_->GetMaxStackDepth();
+    if (!max_stack_depth.has_value()) {
+        Error("Chunk has not been verified");
+        return false;
+    }
+    if (*max_stack_depth > MAX_STACK_SIZE_ - sp_) {
+        Error("Stack Overflow");
+        return false;
+    }
+
     if (HasDebugLogger()) PrintChunkDebugInfo();
-    while (pc_ < chunk_.Size()) {
+    while (pc_ < chunk_->Size()) {
         if (HasDebugLogger()) PrintStatus();
         bool had_error = InterpretNext();
         if (HasDebugLogger() && stack_has_changed_) PrintStack();
-        if (had_error) break;
+        if (had_error) return false;
     }
+    return true;
 }
 
 void VM::SetDebug(Logger logger) {
@@ -32,136 +58,166 @@ void VM::SetDebug(Logger logger) {
 
 bool VM::InterpretNext() {
     auto op_code = NextInstruction();
-    switch (op_code) {
-        case OP::CONSTANT: {
-            auto index = ConsumeOperand();
-            Value constant = chunk_.GetConstants().at(index);
-            PushStack(constant);
-        } break;
-        case OP::ADD: {
-            // TODO implement string concatenation
-            Value right = PopStack();
-            Value left = PopStack();
-            if (left.IsDouble() && right.IsDouble()) {
-                Value sum = left.AsDouble() + right.AsDouble();
-                PushStack(sum);
-            } else {
-                Error("Cannot perform addition. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
-                return true;
-            }
-        } break;
-        case OP::SUBTRACT: {
-            Value right = PopStack();
-            Value left = PopStack();
-            if (left.IsDouble() && right.IsDouble()) {
-                Value difference = left.AsDouble() - right.AsDouble();
-                PushStack(difference);
-            } else {
-                Error("Cannot perform subtraction. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
-                return true;
-            }
-        } break;
-        case OP::MULTIPLY: {
-            Value right = PopStack();
-            Value left = PopStack();
-            if (left.IsDouble() && right.IsDouble()) {
-                Value product = left.AsDouble() * right.AsDouble();
-                PushStack(product);
-            } else {
-                Error("Cannot perform multiplication. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
-                return true;
-            }
-        } break;
-        case OP::DIVIDE: {
-            Value right = PopStack();
-            Value left = PopStack();
-            if (left.IsDouble() && right.IsDouble()) {
-                if (right.AsDouble() == 0.0) Error("Tried to divide by 0");
-                else {
-                    Value quotient = left.AsDouble() / right.AsDouble();
-                    PushStack(quotient);
-                }
-            } else {
-                Error("Cannot perform division. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
-                return true;
-            }
-        } break;
-        case OP::POP: {
-            PopStack();
-        } break;
-        case OP::NEGATE: {
-            Value val = PopStack();
-            if (val.IsDouble()) {
-                Value negated = -(val.AsDouble());
-                PushStack(negated);
-            } else {
-                Error("Cannot perform negation. Invalid type: " + val.GetTypeDebugString());
-                return true;
-            }
-        } break;
-        case OP::NOT: {
-            Value val = PopStack();
-            if (val.IsFalsey()) PushStack(true);
-            else PushStack(false);
-        } break;
-        case OP::EQUAL: {
-            Value right = PopStack();
-            Value left = PopStack();
-            PushStack(right == left);
-        } break;
-        case OP::GREATER: {
-            Value right = PopStack();
-            Value left = PopStack();
-            if (left.IsDouble() && right.IsDouble()) {
-                PushStack(left.AsDouble() > right.AsDouble());
-            }
-            else {
-                Error("Cannot perform comparison. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
-                return true;
-            }
-        } break;
-        case OP::LESS: {
-            Value right = PopStack();
-            Value left = PopStack();
-            if (left.IsDouble() && right.IsDouble()) {
-                PushStack(left.AsDouble() < right.AsDouble());
-            }
-            else {
-                Error("Cannot perform comparison. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
-                return true;
-            }
-        } break;
-        default:
-            Error("Invalid OPCODE");
+    return (this->*DISPATCH_TABLE[static_cast<size_t>(op_code)])();
+}
+
+// Opcode handlers, return true if a runtime error occurred
+bool VM::OpCONSTANT() {
+    auto index = ConsumeOperand();
+    Value constant = chunk_->GetConstants().at(index);
+    PushStack(constant);
+    return false;
+}
+
+bool VM::OpCONSTANT_LONG() {
+    auto index = ConsumeOperand(3);
+    Value constant = chunk_->GetConstants().at(index);
+    PushStack(constant);
+    return false;
+}
+
+bool VM::OpADD() {
+    // TODO implement string concatenation
+    Value right = PopStack();
+    Value left = PopStack();
+    if (left.IsDouble() && right.IsDouble()) {
+        Value sum = left.AsDouble() + right.AsDouble();
+        PushStack(sum);
+    } else {
+        Error("Cannot perform addition. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
+        return true;
+    }
+    return false;
+}
+
+bool VM::OpSUBTRACT() {
+    Value right = PopStack();
+    Value left = PopStack();
+    if (left.IsDouble() && right.IsDouble()) {
+        Value difference = left.AsDouble() - right.AsDouble();
+        PushStack(difference);
+    } else {
+        Error("Cannot perform subtraction. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
+        return true;
+    }
+    return false;
+}
+
+bool VM::OpMULTIPLY() {
+    Value right = PopStack();
+    Value left = PopStack();
+    if (left.IsDouble() && right.IsDouble()) {
+        Value product = left.AsDouble() * right.AsDouble();
+        PushStack(product);
+    } else {
+        Error("Cannot perform multiplication. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
+        return true;
+    }
+    return false;
+}
+
+bool VM::OpDIVIDE() {
+    Value right = PopStack();
+    Value left = PopStack();
+    if (left.IsDouble() && right.IsDouble()) {
+        if (right.AsDouble() == 0.0) {
+            Error("Tried to divide by 0");
             return true;
+        }
+        Value quotient = left.AsDouble() / right.AsDouble();
+        PushStack(quotient);
+    } else {
+        Error("Cannot perform division. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
+        return true;
     }
     return false;
 }
 
-void VM::PushStack(Value val) {
-    if (sp_ >= MAX_STACK_SIZE_) {
-        Error("Stack Overflow");
-        return;
+bool VM::OpPOP() {
+    PopStack();
+    return false;
+}
+
+bool VM::OpNEGATE() {
+    Value val = PopStack();
+    if (val.IsDouble()) {
+        Value negated = -(val.AsDouble());
+        PushStack(negated);
+    } else {
+        Error("Cannot perform negation. Invalid type: " + val.GetTypeDebugString());
+        return true;
+    }
+    return false;
+}
+
+bool VM::OpNOT() {
+    Value val = PopStack();
+    if (val.IsFalsey()) PushStack(true);
+    else PushStack(false);
+    return false;
+}
+
+bool VM::OpEQUAL() {
+    Value right = PopStack();
+    Value left = PopStack();
+    PushStack(right == left);
+    return false;
+}
+
+bool VM::OpGREATER() {
+    Value right = PopStack();
+    Value left = PopStack();
+    if (left.IsDouble() && right.IsDouble()) {
+        PushStack(left.AsDouble() > right.AsDouble());
     }
+    else {
+        Error("Cannot perform comparison. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
+        return true;
+    }
+    return false;
+}
+
+bool VM::OpLESS() {
+    Value right = PopStack();
+    Value left = PopStack();
+    if (left.IsDouble() && right.IsDouble()) {
+        PushStack(left.AsDouble() < right.AsDouble());
+    }
+    else {
+        Error("Cannot perform comparison. Invalid types: " + left.GetTypeDebugString() + " and " + right.GetTypeDebugString());
+        return true;
+    }
+    return false;
+}
+
+bool VM::OpJUMP() {
+    auto offset = ConsumeOperand(2);
+    pc_ += offset;
+    return false;
+}
+
+bool VM::OpJUMP_IF_FALSE() {
+    auto offset = ConsumeOperand(2);
+    if (PopStack().IsFalsey()) pc_ += offset;
+    return false;
+}
+
+// No bounds checks, the Verifier has already proven that the stack stays within its max depth
+void VM::PushStack(Value val) {
+    assert(sp_ < MAX_STACK_SIZE_);
     stack_[sp_++] = val;
     stack_has_changed_ = true;
 }
 
 Value VM::PopStack() {
-    if (stack_.empty()) {
-        Error("Stack is empty");
-        return {};
-    }
+    assert(sp_ > 0);
     stack_has_changed_ = true;
     return stack_[--sp_];
 }
 
 Value VM::StackTop() const {
-    if (stack_.empty()) {
-        Error("Stack is empty");
-        return {};
-    }
-    return stack_[sp_];
+    assert(sp_ > 0);
+    return stack_[sp_ - 1];
 }
 
 uint64_t VM::ConsumeOperand(int operand_count) {
@@ -179,13 +235,13 @@ void VM::Error(std::string msg) const {
 
 
 OP VM::NextInstruction() {
-    return static_cast<OP>(chunk_.GetCode()[pc_++]);
+    return static_cast<OP>(chunk_->GetCode()[pc_++]);
 }
 
 // Each PrintStatus call corresponds to one row in the printed debug info (exluding stack content)
 void VM::PrintStatus() const {
     assert(debug_logger_.has_value());
-    auto& code = chunk_.GetCode();
+    auto& code = chunk_->GetCode();
     auto cur_instruction = static_cast<OP>(code.at(pc_));
 
     // Print Offset
@@ -194,13 +250,12 @@ void VM::PrintStatus() const {
     *debug_logger_ << padded_offset_str << "     ";
 
     // Print Op Code
-    auto& op_name = OP_DEFINITIONS.at(cur_instruction).name;
-    *debug_logger_ << std::left << std::setw(14) << op_name;
+    auto& op_definition = GetOpDefinition(cur_instruction);
+    *debug_logger_ << std::left << std::setw(14) << op_definition.name;
 
     // Print operands (convert all operands into one uint64_t)
-    auto operand_count = OP_DEFINITIONS.at(cur_instruction).operand_count;
     uint64_t combined = 0;
-    for (int i = 0; i < operand_count; i++) {
+    for (int i = 0; i < op_definition.operand_width; i++) {
         uint8_t operand = code.at(pc_ + i + 1);
         combined |= static_cast<uint64_t>(operand) << (8 * i);
     }
@@ -225,7 +280,7 @@ void VM::PrintStack() const {
 void VM::PrintChunkDebugInfo() const {
     assert(debug_logger_.has_value());
     *debug_logger_ << "VM DEBUG INFO\nConstants: [";
-    auto& constants = chunk_.GetConstants();
+    auto& constants = chunk_->GetConstants();
     for (int i = 0; i < constants.size(); i++) {
         *debug_logger_ << constants[i].GetValueDebugString();
         if (i+1 != constants.size()) *debug_logger_ << ", ";
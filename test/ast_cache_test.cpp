@@ -0,0 +1,114 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <unistd.h>
+#include "ast_cache.h"
+#include "parser.h"
+#include "compiler.h"
+#include "semantic_analyser.h"
+#include "debug.h"
+
+const std::string SCRIPT =
+    "var a = 1 + 2 * 3.25;\n"
+    "var big = 12345678901234;\n"
+    "var nothing = nil;\n"
+    "fun f(x, y) { var z = x; return -z + 4; }\n"
+    "fun g() { return; }\n"
+    "if (a > 2) { print \"big\"; } else { print !true; }\n"
+    "if (a <= 1) print \"\";\n"
+    "while (a != 0) { a = a - 1; }\n"
+    "f(1, false);\n"
+    "g();\n"
+    "{ var a = \"inner\"; print a; }\n"
+    "(1 >= 2) == (3 < 0.1);\n";
+
+std::string CompileToString(Program* program) {
+    Compiler compiler;
+    return Debug::GetChunkStr(compiler.Compile(program));
+}
+
+bool PointsInto(std::string_view text, const std::string& source_code) {
+    return text.data() >= source_code.data() && text.data() + text.size() <= source_code.data() + source_code.size();
+}
+
+BOOST_AUTO_TEST_CASE(ASTCacheRoundTrip) {
+    Parser parser(SCRIPT);
+    auto ast = parser.GenerateAST();
+    SemanticAnalyser analyser;
+    ast->accept(analyser);
+    BOOST_REQUIRE(!parser.HadError());
+    BOOST_REQUIRE_EQUAL(analyser.GetErrorCount(), 0);
+
+    std::vector<uint8_t> data = ASTCache::Serialize(*ast, SCRIPT);
+    auto loaded = ASTCache::Deserialize(data, SCRIPT);
+    BOOST_REQUIRE(loaded != nullptr);
+    BOOST_CHECK_EQUAL(Debug::GetASTString(loaded.get()), Debug::GetASTString(ast.get()));
+    BOOST_CHECK_EQUAL(CompileToString(loaded.get()), CompileToString(ast.get()));
+
+    // Names and strings are views into the source with the Lexer's symbols, like in a parsed tree
+    auto* declaration = static_cast<VarDecl*>(loaded->declarations[0]);
+    BOOST_CHECK_EQUAL(declaration->variable->name, "a");
+    BOOST_CHECK(PointsInto(declaration->variable->name, SCRIPT));
+    BOOST_CHECK_EQUAL(declaration->variable->symbol, parser.GetInterner().Find("a"));
+    auto* print = static_cast<PrintStmt*>(static_cast<Block*>(static_cast<IfStmt*>(loaded->declarations[5])->if_body)->declarations[0]);
+    BOOST_CHECK(PointsInto(static_cast<Literal*>(print->expression)->value.AsString(), SCRIPT));
+    auto* big = static_cast<VarDecl*>(loaded->declarations[1]);
+    BOOST_CHECK_EQUAL(static_cast<Literal*>(big->expression)->value.AsDouble(), 12345678901234.0);
+
+    // Analysing the loaded tree finds nothing new either
+    SemanticAnalyser loaded_analyser;
+    loaded->accept(loaded_analyser);
+    BOOST_CHECK_EQUAL(loaded_analyser.GetErrorCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ASTCacheRejectsOtherData) {
+    Parser parser(SCRIPT);
+    auto ast = parser.GenerateAST();
+    std::vector<uint8_t> data = ASTCache::Serialize(*ast, SCRIPT);
+
+    // A single changed character changes the hash
+    std::string edited = SCRIPT;
+    edited[8] = '2';
+    BOOST_CHECK(ASTCache::Deserialize(data, edited) == nullptr);
+    BOOST_CHECK(ASTCache::Deserialize(data, "") == nullptr);
+    BOOST_CHECK_NE(ASTCache::HashSource(SCRIPT), ASTCache::HashSource(edited));
+
+    // Every truncation is caught, none of them crash
+    for (size_t size = 0; size < data.size(); size++) {
+        BOOST_REQUIRE(ASTCache::Deserialize(std::span(data).first(size), SCRIPT) == nullptr);
+    }
+    data.push_back(0);
+    BOOST_CHECK(ASTCache::Deserialize(data, SCRIPT) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(ASTCacheDeepNesting) {
+    // Loading doesn't recurse, so it handles nesting far deeper than the stack would
+    std::string source_code = "print " + std::string(200'000, '-') + "1;";
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    auto loaded = ASTCache::Deserialize(ASTCache::Serialize(*ast, source_code), source_code);
+    BOOST_REQUIRE(loaded != nullptr);
+    Compiler compiler;
+    Compiler loaded_compiler;
+    BOOST_CHECK(loaded_compiler.Compile(loaded.get()).GetCode() == compiler.Compile(ast.get()).GetCode());
+}
+
+BOOST_AUTO_TEST_CASE(ASTCacheFiles) {
+    auto directory = std::filesystem::temp_directory_path() / ("ast_cache_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    ASTCache cache(directory.string());
+    BOOST_CHECK(cache.Load(SCRIPT) == nullptr);
+
+    Parser parser(SCRIPT);
+    auto ast = parser.GenerateAST();
+    BOOST_REQUIRE(cache.Store(*ast, SCRIPT));
+    BOOST_REQUIRE(cache.Store(*ast, SCRIPT)); // Replacing an entry is fine
+    BOOST_CHECK(std::filesystem::exists(cache.GetPath(SCRIPT)));
+    auto loaded = cache.Load(SCRIPT);
+    BOOST_REQUIRE(loaded != nullptr);
+    BOOST_CHECK_EQUAL(Debug::GetASTString(loaded.get()), Debug::GetASTString(ast.get()));
+    BOOST_CHECK(cache.Load(SCRIPT + " ") == nullptr);
+
+    BOOST_CHECK(!ASTCache(directory.string() + "/missing").Store(*ast, SCRIPT));
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,60 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "verifier.h"
+
+Chunk CompileSource(std::string source_code) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    Compiler compiler;
+    return compiler.Compile(ast.get());
+}
+
+// Check that equal constants share one entry in the constant pool
+BOOST_AUTO_TEST_CASE(ChunkDeduplicatesConstants) {
+    Chunk chunk;
+    BOOST_CHECK_EQUAL(chunk.AddConstant(1.0), 0);
+    BOOST_CHECK_EQUAL(chunk.AddConstant(true), 1);
+    BOOST_CHECK_EQUAL(chunk.AddConstant(1.0), 0);
+    BOOST_CHECK_EQUAL(chunk.AddConstant(std::string_view("\"a\"")), 2);
+    BOOST_CHECK_EQUAL(chunk.AddConstant(std::string_view("\"a\"")), 2);
+    BOOST_CHECK_EQUAL(chunk.AddConstant(Value()), 3);
+    BOOST_CHECK_EQUAL(chunk.AddConstant(Value()), 3);
+    BOOST_CHECK_EQUAL(chunk.GetConstants().size(), 4);
+
+    Chunk compiled = CompileSource("1 + 2; 2 * 1; 1 == 2;");
+    BOOST_CHECK_EQUAL(compiled.GetConstants().size(), 2);
+}
+
+// 0 and -0 compare equal, but are different constants (1 / -0 is -infinity)
+BOOST_AUTO_TEST_CASE(ChunkKeepsNegativeZero) {
+    Chunk chunk;
+    BOOST_CHECK_EQUAL(chunk.AddConstant(0.0), 0);
+    BOOST_CHECK_EQUAL(chunk.AddConstant(-0.0), 1);
+}
+
+// Check that scripts with more than 256 distinct literals use CONSTANT_LONG instead of wrapping around
+BOOST_AUTO_TEST_CASE(ChunkLongConstants) {
+    constexpr size_t LITERAL_COUNT = 70000;
+    std::string source_code;
+    for (size_t i = 0; i < LITERAL_COUNT; i++) {
+        source_code += std::to_string(i) + ";\n";
+    }
+    Chunk chunk = CompileSource(source_code);
+    BOOST_REQUIRE_EQUAL(chunk.GetConstants().size(), LITERAL_COUNT);
+
+    // 256 short constants, the rest are long. Every literal is followed by POP
+    BOOST_CHECK_EQUAL(chunk.Size(), 256 * (2 + 1) + (LITERAL_COUNT - 256) * (4 + 1));
+    BOOST_CHECK_EQUAL(chunk.InstructionCount(), LITERAL_COUNT * 2);
+
+    auto& code = chunk.GetCode();
+    size_t last_offset = chunk.Size() - 5;
+    BOOST_CHECK(static_cast<OP>(code[last_offset]) == OP::CONSTANT_LONG);
+    uint32_t index = code[last_offset + 1] | code[last_offset + 2] << 8 | code[last_offset + 3] << 16;
+    BOOST_CHECK_EQUAL(index, LITERAL_COUNT - 1);
+    BOOST_CHECK_EQUAL(chunk.GetConstants()[index].AsDouble(), LITERAL_COUNT - 1);
+
+    Verifier verifier;
+    BOOST_CHECK(verifier.Verify(chunk));
+}
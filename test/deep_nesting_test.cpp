@@ -0,0 +1,115 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "flat_ast.h"
+#include "pass_manager.h"
+#include "semantic_analyser.h"
+#include "debug.h"
+
+// Far more levels than recursing once per level would survive on a default 8MB stack
+constexpr size_t DEPTH = 1'000'000;
+
+std::string Repeat(std::string_view part, size_t count) {
+    std::string result;
+    result.reserve(part.size() * count);
+    for (size_t i = 0; i < count; i++) result += part;
+    return result;
+}
+
+// Runs source_code through every stage that walks expressions, all of them have to get through without errors
+void CheckAllStages(const std::string& source_code) {
+    size_t code_size = 0;
+    {
+        Parser parser(source_code);
+        auto ast = parser.GenerateAST();
+        SemanticAnalyser analyser;
+        ast->accept(analyser);
+        BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 0);
+
+        FlatAST flat_ast = FlatAST::Build(*ast);
+        BOOST_CHECK_EQUAL(flat_ast.Size(), CountASTNodes(*ast));
+        SemanticAnalyser flat_analyser;
+        flat_analyser.Analyse(flat_ast);
+        BOOST_CHECK_EQUAL(flat_analyser.GetErrorCount(), 0);
+
+        Compiler compiler;
+        code_size = compiler.Compile(ast.get()).Size();
+        Compiler flat_compiler;
+        BOOST_CHECK_EQUAL(flat_compiler.Compile(flat_ast).Size(), code_size);
+
+        PassManager::CreateDefault(OptLevel::O2).RunASTPasses(*ast);
+        Compiler optimised_compiler;
+        BOOST_CHECK_GT(optimised_compiler.Compile(ast.get()).Size(), 0);
+    }
+
+    Parser parser(source_code);
+    SemanticAnalyser analyser;
+    BOOST_CHECK_EQUAL(parser.GenerateChunk(analyser).Size(), code_size);
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(DeepGrouping) {
+    CheckAllStages(Repeat("(", DEPTH) + "1" + Repeat(")", DEPTH) + ";");
+}
+
+BOOST_AUTO_TEST_CASE(DeepUnary) {
+    CheckAllStages(Repeat("-", DEPTH) + "1;");
+    CheckAllStages(Repeat("!", DEPTH) + "true;");
+}
+
+BOOST_AUTO_TEST_CASE(DeepBinary) {
+    // Right nested through groupings, and one long left nested chain
+    CheckAllStages(Repeat("1 + (", DEPTH) + "1" + Repeat(")", DEPTH) + ";");
+    CheckAllStages("1" + Repeat(" + 1", DEPTH) + ";");
+}
+
+BOOST_AUTO_TEST_CASE(DeepAssignment) {
+    CheckAllStages("var a; " + Repeat("a = ", DEPTH) + "1;");
+}
+
+BOOST_AUTO_TEST_CASE(DeepCall) {
+    CheckAllStages("fun f(x) {} " + Repeat("f(", DEPTH) + "1" + Repeat(")", DEPTH) + ";");
+}
+
+BOOST_AUTO_TEST_CASE(DeepExpressionString) {
+    const std::string source_code = Repeat("-", 1000) + "a";
+    Parser parser(source_code);
+    auto expression = parser.ParseExpression();
+    BOOST_CHECK_EQUAL(Debug::GetExpressionStr(expression), "-" + Repeat("(-", 999) + "a" + Repeat(")", 999));
+}
+
+BOOST_AUTO_TEST_CASE(IncompleteNestedExpression) {
+    // Errors deep inside an expression unwind every pending operator, and the parser can still be used afterwards
+    const std::string source_code = Repeat("(-", 1000) + ";";
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    BOOST_CHECK_EQUAL(ast->declarations.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidAssignmentAndCallTargets) {
+    // These only report parse errors, the tree keeps the target as a plain expression statement, so every
+    // stage that runs on a broken tree gets through it without a null variable or callee
+    for (std::string source_code : {"1 = 2;", "1(2);", "-a = 1;", "a + 1 = 2;", "nil(2);"}) {
+        Parser parser(source_code);
+        auto ast = parser.GenerateAST();
+        BOOST_CHECK(parser.HadError());
+        SemanticAnalyser analyser;
+        ast->accept(analyser);
+        FlatAST flat_ast = FlatAST::Build(*ast);
+        SemanticAnalyser flat_analyser;
+        flat_analyser.Analyse(flat_ast);
+        Compiler flat_compiler;
+        flat_compiler.Compile(flat_ast);
+        PassManager::CreateDefault(OptLevel::O2).RunASTPasses(*ast);
+        Compiler compiler;
+        compiler.Compile(ast.get());
+
+        Parser streaming_parser(source_code);
+        while (auto declaration = streaming_parser.GenerateNextDeclaration()) {
+            SemanticAnalyser declaration_analyser;
+            declaration->accept(declaration_analyser);
+        }
+        BOOST_CHECK(streaming_parser.HadError());
+    }
+}
@@ -0,0 +1,97 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "flat_ast.h"
+#include "pass_manager.h"
+#include "semantic_analyser.h"
+#include "debug.h"
+
+const std::string SCRIPT =
+    "var a = 1 + 2 * 3;\n"
+    "fun f(x, y) { var z = x; return -z + 4; }\n"
+    "if (a > 2) { print \"big\"; } else { print !true; }\n"
+    "if (a <= 1) 5;\n"
+    "while (a != 0) { a = a - 1; }\n"
+    "f(1, 2);\n"
+    "(1 >= 2) == (3 < 4);\n";
+
+size_t AnalyseTree(const std::string& source_code) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    SemanticAnalyser analyser;
+    ast->accept(analyser);
+    return analyser.GetErrorCount();
+}
+
+size_t AnalyseFlat(const std::string& source_code) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    FlatAST flat_ast = FlatAST::Build(*ast);
+    SemanticAnalyser analyser;
+    analyser.Analyse(flat_ast);
+    return analyser.GetErrorCount();
+}
+
+BOOST_AUTO_TEST_CASE(FlatASTLayout) {
+    Parser parser("var a = -1 + b;");
+    auto ast = parser.GenerateAST();
+    FlatAST flat_ast = FlatAST::Build(*ast);
+    BOOST_REQUIRE_EQUAL(flat_ast.Size(), CountASTNodes(*ast));
+
+    // Children come before their parent, so the root is last and every child index is smaller
+    const FlatNode& root = flat_ast.GetNode(flat_ast.GetRoot());
+    BOOST_REQUIRE(root.kind == NodeKind::PROGRAM);
+    BOOST_REQUIRE_EQUAL(flat_ast.GetChildren(root).size(), 1);
+    const FlatNode& var_decl = flat_ast.GetNode(flat_ast.GetChildren(root)[0]);
+    BOOST_REQUIRE(var_decl.kind == NodeKind::VAR_DECL);
+    BOOST_CHECK_EQUAL(flat_ast.GetName(flat_ast.GetNode(var_decl.first)), "a");
+
+    const FlatNode& binary = flat_ast.GetNode(var_decl.second);
+    BOOST_REQUIRE(binary.kind == NodeKind::BINARY);
+    BOOST_CHECK_EQUAL(binary.op, TT::PLUS);
+    const FlatNode& unary = flat_ast.GetNode(binary.first);
+    BOOST_REQUIRE(unary.kind == NodeKind::UNARY);
+    BOOST_CHECK_EQUAL(unary.op, TT::MINUS);
+    BOOST_CHECK_EQUAL(flat_ast.GetValue(flat_ast.GetNode(unary.first)).AsDouble(), 1.0);
+    const FlatNode& identifier = flat_ast.GetNode(binary.second);
+    BOOST_REQUIRE(identifier.kind == NodeKind::IDENTIFIER);
+    BOOST_CHECK_EQUAL(flat_ast.GetSymbol(identifier), parser.GetInterner().Find("b"));
+
+    for (NodeIndex index = 0; index < flat_ast.Size(); index++) {
+        const FlatNode& node = flat_ast.GetNode(index);
+        if (node.kind == NodeKind::BINARY) BOOST_CHECK(node.first < index && node.second < index);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FlatASTCompilesLikeTree) {
+    Parser parser(SCRIPT);
+    auto ast = parser.GenerateAST();
+    FlatAST flat_ast = FlatAST::Build(*ast);
+
+    Compiler tree_compiler;
+    Chunk tree_chunk = tree_compiler.Compile(ast.get());
+    Compiler flat_compiler;
+    Chunk flat_chunk = flat_compiler.Compile(flat_ast);
+    BOOST_REQUIRE_EQUAL(Debug::GetChunkStr(tree_chunk), Debug::GetChunkStr(flat_chunk));
+    BOOST_CHECK(tree_chunk.GetCode() == flat_chunk.GetCode());
+}
+
+BOOST_AUTO_TEST_CASE(FlatASTAnalysesLikeTree) {
+    BOOST_CHECK_EQUAL(AnalyseFlat(SCRIPT), 0);
+    BOOST_CHECK_EQUAL(AnalyseTree(SCRIPT), 0);
+
+    const std::vector<std::string> invalid_scripts = {
+        "var a = 1; var a = 2;",
+        "fun f() {} fun f() {}",
+        "b = 1;",
+        "{ var c = 1; } c;",
+        "fun f(x) {} f(1, 2);",
+        "g();",
+        "var v = 1; v();",
+    };
+    for (const auto& script : invalid_scripts) {
+        BOOST_CHECK_EQUAL(AnalyseFlat(script), 1);
+        BOOST_CHECK_EQUAL(AnalyseFlat(script), AnalyseTree(script));
+    }
+}
@@ -0,0 +1,105 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <sstream>
+#include "incremental_analyser.h"
+#include "parser.h"
+#include "semantic_analyser.h"
+
+// What analysing the whole source at once reports
+std::vector<std::string> AnalyseAll(const std::string& source_code) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    std::vector<std::string> errors;
+    SemanticAnalyser analyser;
+    analyser.SetDiagnostics(&errors);
+    ast->accept(analyser);
+    return errors;
+}
+
+void CheckMatchesFresh(const IncrementalAnalyser& analyser) {
+    const std::string source_code = analyser.GetSource();
+    IncrementalAnalyser fresh(source_code);
+    BOOST_REQUIRE_EQUAL(analyser.GetUnitCount(), fresh.GetUnitCount());
+    BOOST_REQUIRE(analyser.GetErrors() == fresh.GetErrors());
+    BOOST_REQUIRE_EQUAL(analyser.GetErrorCount(), fresh.GetErrors().size());
+    BOOST_REQUIRE_EQUAL(analyser.GetParseErrorCount(), fresh.GetParseErrorCount());
+    if (fresh.GetParseErrorCount() == 0) BOOST_REQUIRE(fresh.GetErrors() == AnalyseAll(source_code));
+}
+
+const std::string SOURCE = "var limit = 10;\n"
+                           "fun clamp(x) { if (x > limit) { return limit; } return x; }\n"
+                           "fun twice(x) { return clamp(x) + clamp(x); }\n"
+                           "// A comment between declarations\n"
+                           "{ var local = twice(1); print local; }\n"
+                           "fun unused(a, b) { var c = a + b; c = missing; return c; }\n"
+                           "print twice(limit, 2);\n";
+
+BOOST_AUTO_TEST_CASE(IncrementalMatchesFullAnalysis) {
+    IncrementalAnalyser analyser(SOURCE);
+    BOOST_CHECK(analyser.GetErrors() == AnalyseAll(SOURCE));
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 2);
+    BOOST_CHECK_EQUAL(analyser.GetSource(), SOURCE);
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalEditsOnlyRecheckWhatChanged) {
+    IncrementalAnalyser analyser(SOURCE);
+
+    // Inside a body, only that unit and the one before it are parsed again, and nothing else is analysed
+    size_t offset = SOURCE.find("c = missing");
+    analyser.Edit(offset, 1, "missing");
+    CheckMatchesFresh(analyser);
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 3);
+    BOOST_CHECK_EQUAL(analyser.GetLastEditStats().reanalysed_count, 2);
+    BOOST_CHECK_LE(analyser.GetLastEditStats().reparsed_count, 3);
+
+    // A new parameter changes clamp's signature, so its callers are checked again
+    analyser.Edit(SOURCE.find("clamp(x)") + 6, 0, "y, ");
+    CheckMatchesFresh(analyser);
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 5);
+    BOOST_CHECK_GE(analyser.GetLastEditStats().reanalysed_count, 3);
+
+    // Declaring missing at the top makes two errors go away
+    analyser.Edit(0, 0, "var missing = 1;");
+    CheckMatchesFresh(analyser);
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalUnbalancedBraces) {
+    std::ostringstream parse_errors;
+    auto* old_buffer = std::cerr.rdbuf(parse_errors.rdbuf());
+    IncrementalAnalyser analyser(SOURCE);
+
+    // An unclosed brace swallows every declaration after it, closing it again splits them up again
+    size_t offset = SOURCE.find("if (x > limit) {") + 15;
+    analyser.Edit(offset, 1, "");
+    CheckMatchesFresh(analyser);
+    analyser.Edit(offset, 0, "{");
+    CheckMatchesFresh(analyser);
+    BOOST_CHECK_EQUAL(analyser.GetSource(), SOURCE);
+    BOOST_CHECK(analyser.GetErrors() == AnalyseAll(SOURCE));
+
+    analyser.Edit(0, SOURCE.size(), "  ");
+    CheckMatchesFresh(analyser);
+    analyser.Edit(1, 0, SOURCE);
+    CheckMatchesFresh(analyser);
+    BOOST_CHECK_THROW(analyser.Edit(analyser.GetSource().size(), 1, ""), std::out_of_range);
+    std::cerr.rdbuf(old_buffer);
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalRandomEdits) {
+    std::ostringstream parse_errors;
+    auto* old_buffer = std::cerr.rdbuf(parse_errors.rdbuf());
+    const std::vector<std::string> snippets = {"{", "}", "(", ")", ";", "var v = 1;", "fun f(a) { v; }", "f(1);",
+                                               "limit", "x", " ", "\n", "\"str\"", "print", "else", "// c\n"};
+    std::mt19937 random(42);
+    IncrementalAnalyser analyser(SOURCE + SOURCE);
+    for (int i = 0; i < 500; i++) {
+        size_t size = analyser.GetSource().size();
+        size_t offset = random() % (size + 1);
+        size_t removed_length = random() % 3 == 0 ? std::min<size_t>(random() % 8, size - offset) : 0;
+        analyser.Edit(offset, removed_length, snippets[random() % snippets.size()]);
+        CheckMatchesFresh(analyser);
+    }
+    std::cerr.rdbuf(old_buffer);
+}
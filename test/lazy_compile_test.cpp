@@ -0,0 +1,55 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "semantic_analyser.h"
+#include "debug.h"
+
+std::string CompileEagerly(const std::string& source_code) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    Compiler compiler;
+    return Debug::GetChunkStr(compiler.Compile(ast.get()));
+}
+
+BOOST_AUTO_TEST_CASE(LazyCompileOnlyCalledFunctions) {
+    const std::string source_code = "fun unused() { print 1 + 2; missing; }\n"
+                                    "fun helper(x) { print 10; }\n"
+                                    "fun main() { helper(1); helper(2); print 20; }\n"
+                                    "main();\n"
+                                    "print 30;\n";
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    SemanticAnalyser analyser;
+    analyser.DeclareGlobals(*ast);
+    Compiler compiler;
+    const Chunk chunk = compiler.CompileLazily(ast.get(), analyser);
+
+    // The error in unused is never found, since its body is never looked at
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 0);
+    BOOST_CHECK_EQUAL(Debug::GetChunkStr(chunk), CompileEagerly("main(); print 30;"));
+    const auto& functions = compiler.GetFunctions();
+    BOOST_REQUIRE_EQUAL(functions.size(), 2);
+    BOOST_CHECK_EQUAL(Debug::GetChunkStr(functions[0]), CompileEagerly("helper(1); helper(2); print 20;"));
+    BOOST_CHECK_EQUAL(Debug::GetChunkStr(functions[1]), CompileEagerly("print 10;"));
+}
+
+BOOST_AUTO_TEST_CASE(LazyAnalysisMatchesEager) {
+    // Once every function is called, the same errors are found as by analysing everything up front
+    const std::string source_code = "fun f(a) { g(a); print x; undefined; }\n"
+                                    "var x = 1;\n"
+                                    "fun g(a) { f(a, a); g(a); print x; }\n"
+                                    "fun f() {}\n"
+                                    "f(1); g(2);\n";
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    SemanticAnalyser eager_analyser;
+    ast->accept(eager_analyser);
+
+    SemanticAnalyser analyser;
+    analyser.DeclareGlobals(*ast);
+    Compiler compiler;
+    compiler.CompileLazily(ast.get(), analyser);
+    BOOST_CHECK_EQUAL(compiler.GetFunctions().size(), 2);
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), eager_analyser.GetErrorCount());
+}
@@ -271,3 +271,94 @@ BOOST_AUTO_TEST_CASE(LexerIfElseStatement) {
         BOOST_CHECK_EQUAL(tokens[i].type, expected[i]);
     }
 }
+
+// Check that characters outside the grammar (including non-ASCII bytes) become error tokens
+BOOST_AUTO_TEST_CASE(LexerInvalidCharacters) {
+    std::string source_code = "a @ 1 \xc3\xa9 # b";
+    Lexer lexer(source_code);
+
+    const std::vector<TT> expected = {
+        TT::IDENTIFIER, TT::ERROR, TT::NUMBER, TT::ERROR, TT::ERROR, TT::ERROR, TT::IDENTIFIER, TT::END,
+    };
+
+    const std::vector<Token> tokens = lexer.TokenizeAll();
+
+    // Verify token properties
+    BOOST_REQUIRE_EQUAL(tokens.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BOOST_CHECK_EQUAL(tokens[i].type, expected[i]);
+    }
+}
+
+// Check that every keyword is found and that near misses (prefixes, extensions, same first two characters
+// and length, different case) stay identifiers
+BOOST_AUTO_TEST_CASE(LexerKeywordLookup) {
+    for (const auto& [keyword, type] : KEYWORDS) {
+        BOOST_CHECK_EQUAL(LookupKeyword(keyword), type);
+        BOOST_CHECK_EQUAL(LookupKeyword(std::string(keyword) + "_"), TT::IDENTIFIER);
+        BOOST_CHECK_EQUAL(LookupKeyword(keyword.substr(0, keyword.size() - 1)), TT::IDENTIFIER);
+    }
+
+    const std::vector<std::string> identifiers = {
+        "", "a", "f", "for", "fux", "anx", "whale", "retire", "prinT", "TRUE", "Nil", "elsE", "ifx", "o", "variable",
+    };
+    for (const auto& identifier : identifiers) {
+        BOOST_CHECK_EQUAL(LookupKeyword(identifier), TT::IDENTIFIER);
+    }
+}
+
+// Check that identifiers are interned into dense symbol ids and that other tokens have no symbol
+BOOST_AUTO_TEST_CASE(LexerInternsIdentifiers) {
+    std::string source_code = "var alpha = beta + alpha; fun beta(gamma) { return alpha; }";
+    Lexer lexer(source_code);
+    const std::vector<Token> tokens = lexer.TokenizeAll();
+
+    const Interner& interner = lexer.GetInterner();
+    BOOST_REQUIRE_EQUAL(interner.Size(), 3);
+    for (const auto& token : tokens) {
+        if (token.type != TT::IDENTIFIER) {
+            BOOST_CHECK_EQUAL(token.symbol, NO_SYMBOL);
+            continue;
+        }
+        BOOST_REQUIRE_LT(token.symbol, interner.Size());
+        BOOST_CHECK_EQUAL(interner.GetName(token.symbol), token.lexeme);
+        BOOST_CHECK_EQUAL(interner.Find(token.lexeme), token.symbol);
+    }
+    BOOST_CHECK_EQUAL(interner.Find("alpha"), 0);
+    BOOST_CHECK_EQUAL(interner.Find("beta"), 1);
+    BOOST_CHECK_EQUAL(interner.Find("gamma"), 2);
+    BOOST_CHECK_EQUAL(interner.Find("var"), NO_SYMBOL);
+}
+
+// Check that symbol ids stay stable while the Interner grows
+BOOST_AUTO_TEST_CASE(LexerInternerGrowth) {
+    std::vector<std::string> names;
+    for (int i = 0; i < 10000; i++) names.push_back("name_" + std::to_string(i));
+
+    Interner interner;
+    for (size_t i = 0; i < names.size(); i++) {
+        BOOST_REQUIRE_EQUAL(interner.Intern(names[i]), i);
+    }
+    for (size_t i = 0; i < names.size(); i++) {
+        BOOST_REQUIRE_EQUAL(interner.Intern(names[i]), i);
+        BOOST_REQUIRE_EQUAL(interner.GetName(i), names[i]);
+    }
+    BOOST_CHECK_EQUAL(interner.Size(), names.size());
+}
+
+// Check that TokenBuffer returns the same tokens as TokenizeAll, including error tokens and multiline strings
+BOOST_AUTO_TEST_CASE(LexerTokenBuffer) {
+    std::string source_code = "var a = 1.5;\n// comment\nfun f(x) { return x @ \"multi\nline\" # ; }\n\n"
+                              "print \"unterminated\n";
+    const std::vector<Token> expected = Lexer(source_code).TokenizeAll();
+    const TokenBuffer tokens = Lexer(source_code).TokenizeToBuffer();
+
+    BOOST_REQUIRE_EQUAL(tokens.Size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BOOST_CHECK_EQUAL(tokens.GetType(i), expected[i].type);
+        BOOST_CHECK_EQUAL(tokens.GetLexeme(i), expected[i].lexeme);
+        BOOST_CHECK_EQUAL(tokens.GetLine(i), expected[i].line);
+        BOOST_CHECK_EQUAL(tokens.GetSymbol(i), expected[i].symbol);
+    }
+    BOOST_CHECK_EQUAL(tokens.GetType(tokens.Size() - 2), TT::ERROR);
+}
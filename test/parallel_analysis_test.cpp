@@ -0,0 +1,52 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include "parser.h"
+#include "semantic_analyser.h"
+
+struct Result {
+    size_t error_count;
+    std::string errors;
+};
+
+Result Analyse(const std::string& source_code, size_t thread_count) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    std::ostringstream errors;
+    auto* old_buffer = std::cerr.rdbuf(errors.rdbuf());
+    SemanticAnalyser analyser;
+    analyser.Analyse(*ast, thread_count);
+    std::cerr.rdbuf(old_buffer);
+    return {analyser.GetErrorCount(), errors.str()};
+}
+
+void CheckMatchesSerial(const std::string& source_code) {
+    const Result expected = Analyse(source_code, 1);
+    for (size_t thread_count : {2, 3, 8}) {
+        const Result result = Analyse(source_code, thread_count);
+        BOOST_REQUIRE_EQUAL(result.error_count, expected.error_count);
+        BOOST_REQUIRE_EQUAL(result.errors, expected.errors);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelAnalysisMatchesSerial) {
+    std::string source_code;
+    for (int i = 0; i < 200; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun f" + n + "(x) { var y = x + g" + n + "; f" + n + "(y); f0(1, 2); { var z = y; } z; }\n"
+                       "var g" + n + " = " + n + ";\n"
+                       "undefined_" + n + " = 1;\n";
+    }
+    CheckMatchesSerial(source_code);
+    CheckMatchesSerial("fun f() {} fun g() {}");
+    CheckMatchesSerial("");
+}
+
+BOOST_AUTO_TEST_CASE(ParallelAnalysisGlobalOrder) {
+    // Bodies only see the globals declared before them, and the first of two declarations with the same name
+    CheckMatchesSerial("fun f() { g(); print x; } var x = 1; fun g() { f(); print x; }");
+    CheckMatchesSerial("fun f(a) {} var x = f; fun f(a, b) { f(1); x(); } var f = 2; fun h() { f(1); }");
+
+    // The later var x is not visible in f, so there is exactly one error
+    BOOST_CHECK_EQUAL(Analyse("fun f() { print x; } var x = 1; fun g() { print x; }", 4).error_count, 1);
+}
@@ -0,0 +1,47 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "debug.h"
+
+void CheckMatchesSerial(const std::string& source_code) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    Compiler serial_compiler;
+    const Chunk expected = serial_compiler.Compile(ast.get());
+    for (size_t thread_count : {2, 3, 8}) {
+        Compiler compiler;
+        const Chunk chunk = compiler.Compile(ast.get(), thread_count);
+        BOOST_REQUIRE(chunk.GetCode() == expected.GetCode());
+        BOOST_REQUIRE_EQUAL(Debug::GetChunkStr(chunk), Debug::GetChunkStr(expected));
+    }
+}
+
+std::string Constants(size_t first, size_t count) {
+    std::string source_code;
+    for (size_t i = first; i < first + count; i++) source_code += std::to_string(i) + ";";
+    return source_code;
+}
+
+BOOST_AUTO_TEST_CASE(ParallelCompileMatchesSerial) {
+    std::string source_code;
+    for (int i = 0; i < 200; i++) {
+        auto n = std::to_string(i);
+        source_code += "fun f" + n + "(x) { if (" + n + " > 2) { print " + n + " * 2; } else { print -" + n + "; }"
+                       " while (false) { " + n + "; } return " + n + "; }\n"
+                       "var v" + n + " = " + n + " + 0.5;\n";
+    }
+    CheckMatchesSerial(source_code);
+    CheckMatchesSerial("fun f() {} fun g() {}");
+    CheckMatchesSerial("1 + 2;");
+    CheckMatchesSerial("");
+}
+
+BOOST_AUTO_TEST_CASE(ParallelCompileConstantWidths) {
+    // The body's constants only get indices above 255 once merged, so its CONSTANTs become CONSTANT_LONGs and
+    // the jump over them gets longer
+    CheckMatchesSerial(Constants(0, 300) + "fun f() { if (true) { " + Constants(1000, 20) + " } else { 1; } }");
+
+    // The other way around, the body's own pool overflows one byte but most of its constants already exist
+    CheckMatchesSerial(Constants(0, 250) + "fun f() { if (true) { " + Constants(0, 300) + " } 1; }");
+}
@@ -0,0 +1,66 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include "parallel_lexer.h"
+#include "debug.h"
+
+// Source made of pieces that are likely to end up on a segment boundary: multiline strings containing
+// code and comment markers, comments containing quotes, error characters and unterminated strings
+std::string GenerateSource(std::mt19937& rng, size_t size, bool unterminated) {
+    const std::vector<std::string> pieces = {
+        "var alpha = beta + 12.5;\n", "fun f(x, y) { return x * y; }\n", "\"string with\nvar fake = 1;\nlines\"",
+        "\"// not a comment\n\"", "// comment with a \" quote\n", "\n\n\t  ", "print \"short\";", "@ # ",
+        "if (a >= b and !c) { d = e; } else { f(g); }\n", "\"\n\n\n\"", "gamma_", "\"unclosed fake\nvar x;\n\"",
+    };
+    std::uniform_int_distribution<size_t> pick(0, pieces.size() - 1);
+    std::string source_code;
+    while (source_code.size() < size) source_code += pieces[pick(rng)];
+    if (unterminated) source_code += "\"never closed\nvar y = 2;\n";
+    return source_code;
+}
+
+void CheckMatchesLexer(const std::string& source_code, size_t thread_count, size_t min_segment_size) {
+    Lexer lexer(source_code);
+    const std::vector<Token> expected = lexer.TokenizeAll();
+    ParallelLexer parallel_lexer(source_code, thread_count, min_segment_size);
+    const TokenBuffer tokens = parallel_lexer.TokenizeAll();
+
+    BOOST_REQUIRE_EQUAL(tokens.Size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(tokens.GetType(i), expected[i].type);
+        BOOST_REQUIRE_EQUAL(tokens.GetLexeme(i), expected[i].lexeme);
+        BOOST_REQUIRE_EQUAL(tokens.GetLine(i), expected[i].line);
+        BOOST_REQUIRE_EQUAL(tokens.GetSymbol(i), expected[i].symbol);
+    }
+    BOOST_CHECK_EQUAL(parallel_lexer.GetInterner().Size(), lexer.GetInterner().Size());
+}
+
+// Differential test against Lexer::TokenizeAll with segments small enough that many boundaries need repair
+BOOST_AUTO_TEST_CASE(ParallelLexerMatchesLexer) {
+    std::mt19937 rng(42);
+    for (int round = 0; round < 50; round++) {
+        std::string source_code = GenerateSource(rng, 2000, round % 5 == 0);
+        for (size_t min_segment_size : {16, 64, 257, 1000}) {
+            CheckMatchesLexer(source_code, 4, min_segment_size);
+            CheckMatchesLexer(source_code, 64, min_segment_size);
+        }
+    }
+}
+
+// A single string spanning several segments, and sources without any newline to split at
+BOOST_AUTO_TEST_CASE(ParallelLexerLongString) {
+    std::string source_code = "var a = \"" + std::string(500, '\n') + "b c d\";\nvar e = f;\n";
+    CheckMatchesLexer(source_code, 16, 16);
+
+    CheckMatchesLexer(std::string(1000, 'a') + " b", 8, 16);
+    CheckMatchesLexer("", 8, 16);
+    CheckMatchesLexer("\n\n\n", 8, 1);
+}
+
+// The lexer stops at an embedded null character
+BOOST_AUTO_TEST_CASE(ParallelLexerEmbeddedNull) {
+    std::string source_code = "var a = 1;\nvar b = 2;\n";
+    for (int i = 0; i < 10; i++) source_code += source_code;
+    source_code[source_code.size() / 2] = '\0';
+    CheckMatchesLexer(source_code, 8, 32);
+}
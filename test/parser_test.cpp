@@ -6,7 +6,7 @@
 std::string ParseExpression(std::string input) {
     Parser parser(input);
     auto expression = parser.ParseExpression();
-    return Debug::GetExpressionStr(expression.get());
+    return Debug::GetExpressionStr(expression);
 }
 
 BOOST_AUTO_TEST_CASE(ParserExpression1) {
@@ -0,0 +1,111 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "pass_manager.h"
+#include "inliner.h"
+#include "debug.h"
+
+// Parses source_code and runs the AST passes, returns the expression of the last ExprStmt
+std::string FoldExpression(std::string source_code, OptLevel opt_level = OptLevel::O1) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    auto pass_manager = PassManager::CreateDefault(opt_level);
+    pass_manager.RunASTPasses(*ast);
+    auto* expr_stmt = dynamic_cast<ExprStmt*>(ast->declarations.back());
+    return Debug::GetExpressionStr(expr_stmt->expression);
+}
+
+size_t CountInlinedCalls(std::string source_code, size_t threshold = Inliner::DEFAULT_THRESHOLD) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    Inliner inliner(threshold);
+    inliner.Run(*ast);
+    return inliner.GetInlinedCount();
+}
+
+Chunk CompileWithPasses(std::string source_code, PassManager& pass_manager) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    pass_manager.RunASTPasses(*ast);
+    Compiler compiler;
+    Chunk chunk = compiler.Compile(ast.get());
+    pass_manager.RunBytecodePasses(chunk);
+    return chunk;
+}
+
+BOOST_AUTO_TEST_CASE(PassManagerO0RunsNothing) {
+    BOOST_CHECK_EQUAL(FoldExpression("a + 1 * 2;", OptLevel::O0), "a + (1.00 * 2.00)");
+
+    auto pass_manager = PassManager::CreateDefault(OptLevel::O0);
+    CompileWithPasses("1 + 2;", pass_manager);
+    BOOST_CHECK(pass_manager.GetStats().empty());
+}
+
+BOOST_AUTO_TEST_CASE(PassManagerFoldsConstants) {
+    BOOST_CHECK_EQUAL(FoldExpression("a + 1 * 2;"), "a + 2.00");
+    BOOST_CHECK_EQUAL(FoldExpression("-(4 - 1) * 2 < 0;"), "true");
+    // The compiler can't emit 'and' and 'or' yet, folding them would make -O1 accept programs -O0 rejects
+    BOOST_CHECK_EQUAL(FoldExpression("!(1 == 1) or b;"), "false or b");
+    BOOST_CHECK_EQUAL(FoldExpression("true and false;"), "true and false");
+}
+
+BOOST_AUTO_TEST_CASE(PassManagerKeepsRuntimeErrors) {
+    BOOST_CHECK_EQUAL(FoldExpression("1 / 0;"), "1.00 / 0.00");
+    BOOST_CHECK_EQUAL(FoldExpression("-true;"), "-true");
+}
+
+BOOST_AUTO_TEST_CASE(PassManagerPeephole) {
+    auto pass_manager = PassManager::CreateDefault(OptLevel::O1);
+    pass_manager.DisablePass("constant-folding");
+    Chunk chunk = CompileWithPasses("1 + 2; 3;", pass_manager);
+
+    // CONSTANT 3, POP is removed
+    BOOST_CHECK_EQUAL(chunk.InstructionCount(), 4);
+    BOOST_REQUIRE_EQUAL(pass_manager.GetStats().size(), 1);
+    BOOST_CHECK_EQUAL(pass_manager.GetStats()[0].name, "peephole");
+    BOOST_CHECK_EQUAL(pass_manager.GetStats()[0].before, 6);
+    BOOST_CHECK_EQUAL(pass_manager.GetStats()[0].after, 4);
+}
+
+BOOST_AUTO_TEST_CASE(PassManagerRecordsStats) {
+    auto pass_manager = PassManager::CreateDefault(OptLevel::O1);
+    Chunk chunk = CompileWithPasses("1 + 2 + 3 == 3 - 2 - 1;", pass_manager);
+
+    const auto& stats = pass_manager.GetStats();
+    BOOST_REQUIRE_EQUAL(stats.size(), 2);
+    BOOST_CHECK_EQUAL(stats[0].name, "constant-folding");
+    BOOST_CHECK_EQUAL(stats[0].before, 13);
+    BOOST_CHECK_EQUAL(stats[0].after, 3);
+    BOOST_CHECK_EQUAL(stats[1].name, "peephole");
+    BOOST_CHECK_EQUAL(stats[1].after, 0);
+    BOOST_CHECK_EQUAL(chunk.Size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(PassManagerInlinesHelpers) {
+    BOOST_CHECK_EQUAL(FoldExpression("fun add(a, b) { return a + b; } add(1, 2);", OptLevel::O2), "3.00");
+    BOOST_CHECK_EQUAL(FoldExpression("fun sq(x) { return x * x; } fun quad(x) { return sq(x) * sq(x); } quad(y);",
+                                     OptLevel::O2), "(y * y) * (y * y)");
+    BOOST_CHECK_EQUAL(FoldExpression("fun sub(a, b) { return a - b; } sub(x = 1, -y);", OptLevel::O2), "(x = 1.00) - (-y)");
+}
+
+BOOST_AUTO_TEST_CASE(InlinerRespectsThreshold) {
+    std::string source_code = "fun add(a, b) { return a + b; } add(1, 2); add(3, 4);";
+    BOOST_CHECK_EQUAL(CountInlinedCalls(source_code, 2), 0);
+    BOOST_CHECK_EQUAL(CountInlinedCalls(source_code, 3), 2);
+}
+
+BOOST_AUTO_TEST_CASE(InlinerKeepsEvaluationOrder) {
+    // Swapped or repeated parameters would change when/how often the assignment happens
+    BOOST_CHECK_EQUAL(CountInlinedCalls("fun sub(a, b) { return b - a; } sub(x = 1, y);"), 0);
+    BOOST_CHECK_EQUAL(CountInlinedCalls("fun sq(a) { return a * a; } sq(x = 2);"), 0);
+    BOOST_CHECK_EQUAL(CountInlinedCalls("fun first(a, b) { return a; } first(1, x = 2);"), 0);
+    BOOST_CHECK_EQUAL(CountInlinedCalls("fun sq(a) { return a * a; } sq(x);"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(InlinerSkipsUnsafeFunctions) {
+    BOOST_CHECK_EQUAL(CountInlinedCalls("fun f(a) { return a; } { var f = 1; } f(2);"), 0); // Shadowed
+    BOOST_CHECK_EQUAL(CountInlinedCalls("fun f(a) { print a; return a; } f(2);"), 0);      // Not a single return
+    BOOST_CHECK_EQUAL(CountInlinedCalls("fun f(a) { return a + g; } f(2);"), 0);           // Uses a global
+    BOOST_CHECK_EQUAL(CountInlinedCalls("fun f(a) { return f(a); } f(2);"), 0);            // Recursive
+}
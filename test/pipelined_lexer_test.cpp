@@ -0,0 +1,99 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <thread>
+#include "pipelined_lexer.h"
+#include "parser.h"
+#include "compiler.h"
+#include "semantic_analyser.h"
+#include "debug.h"
+
+std::string GenerateSource(size_t token_count) {
+    std::string source_code;
+    for (size_t i = 0; i < token_count / 10; i++) {
+        source_code += "var alpha_" + std::to_string(i % 100) + " = \"s\" + 12.5 @;\n";
+    }
+    return source_code;
+}
+
+// Sizes around the ring capacity and the batch size, so that the lexer thread both fills the ring and ends mid batch
+BOOST_AUTO_TEST_CASE(PipelinedLexerMatchesLexer) {
+    for (size_t token_count : {0ul, 10ul, PipelinedLexer::BATCH_SIZE, PipelinedLexer::CAPACITY,
+                               3 * PipelinedLexer::CAPACITY + 7}) {
+        const std::string source_code = GenerateSource(token_count);
+        Lexer reference_lexer(source_code);
+        const std::vector<Token> expected = reference_lexer.TokenizeAll();
+
+        Lexer lexer(source_code);
+        PipelinedLexer pipeline(lexer);
+        for (const auto& expected_token : expected) {
+            Token token = pipeline.ReadNextToken();
+            BOOST_REQUIRE_EQUAL(token.type, expected_token.type);
+            BOOST_REQUIRE_EQUAL(token.lexeme, expected_token.lexeme);
+            BOOST_REQUIRE_EQUAL(token.line, expected_token.line);
+            BOOST_REQUIRE_EQUAL(token.symbol, expected_token.symbol);
+        }
+        BOOST_CHECK_EQUAL(pipeline.ReadNextToken().type, TT::END);
+    }
+}
+
+size_t ThreadCount() {
+    auto tasks = std::filesystem::directory_iterator("/proc/self/task");
+    return static_cast<size_t>(std::distance(std::filesystem::begin(tasks), std::filesystem::end(tasks)));
+}
+
+BOOST_AUTO_TEST_CASE(PipelinedParserStartsOnFirstToken) {
+    // A Parser that is made but never used (say for a script whose AST then comes from the cache) lexes nothing.
+    // A lexer thread would otherwise fill the ring and then spin until the Parser is destroyed
+    const std::string source_code = GenerateSource(4 * PipelinedLexer::CAPACITY);
+    size_t thread_count = ThreadCount();
+    Parser parser(source_code, true);
+    BOOST_CHECK_EQUAL(ThreadCount(), thread_count);
+    BOOST_CHECK(parser.GenerateAST() != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(PipelinedLexerStopsEarly) {
+    // The lexer thread is blocked on a full ring when the consumer goes away
+    const std::string source_code = GenerateSource(4 * PipelinedLexer::CAPACITY);
+    Lexer lexer(source_code);
+    PipelinedLexer pipeline(lexer);
+    BOOST_CHECK_EQUAL(pipeline.ReadNextToken().type, TT::VAR);
+}
+
+BOOST_AUTO_TEST_CASE(PipelinedLexerBlocksOnFullRing) {
+    // Once the ring is full the lexer thread sleeps instead of spinning until the parser catches up
+    const std::string source_code = GenerateSource(4 * PipelinedLexer::CAPACITY);
+    Lexer lexer(source_code);
+    PipelinedLexer pipeline(lexer);
+    BOOST_CHECK_EQUAL(pipeline.ReadNextToken().type, TT::VAR);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Plenty of time to fill the ring
+    std::clock_t start = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    double cpu_ms = 1000.0 * static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+    BOOST_CHECK_LT(cpu_ms, 100.0);
+
+    // And wakes up again once tokens are read
+    Lexer reference_lexer(source_code);
+    reference_lexer.ReadNextToken();
+    for (size_t i = 0; i < 2 * PipelinedLexer::CAPACITY; i++) {
+        BOOST_REQUIRE_EQUAL(pipeline.ReadNextToken().type, reference_lexer.ReadNextToken().type);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PipelinedParserMatchesParser) {
+    std::string source_code;
+    for (int i = 0; i < 2000; i++) {
+        source_code += "var a" + std::to_string(i) + " = 1 + 2 * 3;\nif (1 < 2) { print \"yes\"; } else { -4; }\n";
+    }
+    auto compile = [&](bool pipelined) {
+        Parser parser(source_code, pipelined);
+        auto ast = parser.GenerateAST();
+        SemanticAnalyser analyser;
+        ast->accept(analyser);
+        Compiler compiler;
+        return Debug::GetChunkStr(compiler.Compile(ast.get()));
+    };
+    BOOST_CHECK_EQUAL(compile(true), compile(false));
+}
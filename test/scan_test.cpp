@@ -0,0 +1,75 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include "scan.h"
+#include "lexer.h"
+#include "debug.h"
+
+const std::vector<Scan::Kernel> ALL_KERNELS = {Scan::Kernel::SCALAR, Scan::Kernel::SSE2, Scan::Kernel::AVX2};
+
+// Random text over a small alphabet, so that every kernel sees long runs as well as stops at every position
+std::string GenerateText(std::mt19937& rng, size_t size) {
+    const std::string alphabet = "    \t\r\n\n\"\"a/";
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    std::uniform_int_distribution<size_t> run_length(1, 80);
+    std::string text;
+    while (text.size() < size) {
+        text.append(run_length(rng), alphabet[pick(rng)]);
+    }
+    return text;
+}
+
+// Check that the SIMD kernels return the same index and newline count as the scalar one from every start index
+BOOST_AUTO_TEST_CASE(ScanKernelsMatchScalar) {
+    const Scan::Kernel best_kernel = Scan::GetKernel();
+    std::mt19937 rng(1234);
+    for (int round = 0; round < 20; round++) {
+        std::string text = GenerateText(rng, 500);
+        for (size_t start = 0; start <= text.size(); start++) {
+            Scan::SetKernel(Scan::Kernel::SCALAR);
+            size_t expected_ws_line = 0, expected_str_line = 0;
+            size_t expected_ws = Scan::SkipWhitespace(text, start, expected_ws_line);
+            size_t expected_line_end = Scan::FindLineEnd(text, start);
+            size_t expected_str = Scan::FindStringEnd(text, start, expected_str_line);
+
+            for (auto kernel : ALL_KERNELS) {
+                if (!Scan::IsSupported(kernel)) continue;
+                Scan::SetKernel(kernel);
+                size_t ws_line = 0, str_line = 0;
+                BOOST_REQUIRE_EQUAL(Scan::SkipWhitespace(text, start, ws_line), expected_ws);
+                BOOST_REQUIRE_EQUAL(ws_line, expected_ws_line);
+                BOOST_REQUIRE_EQUAL(Scan::FindLineEnd(text, start), expected_line_end);
+                BOOST_REQUIRE_EQUAL(Scan::FindStringEnd(text, start, str_line), expected_str);
+                BOOST_REQUIRE_EQUAL(str_line, expected_str_line);
+            }
+        }
+    }
+    Scan::SetKernel(best_kernel);
+}
+
+// Check that the kernels stop at the null terminator, like the Lexer does
+BOOST_AUTO_TEST_CASE(ScanStopsAtNull) {
+    std::string text(100, ' ');
+    text[70] = '\0';
+    size_t line = 0;
+    BOOST_CHECK_EQUAL(Scan::FindLineEnd(text, 0), 70);
+    BOOST_CHECK_EQUAL(Scan::FindStringEnd(text, 0, line), 70);
+    BOOST_CHECK_EQUAL(Scan::SkipWhitespace(text, 0, line), 70);
+    BOOST_CHECK_EQUAL(Scan::SkipWhitespace(text, 71, line), 100);
+}
+
+// Check line numbers after long whitespace runs, comments and multiline strings
+BOOST_AUTO_TEST_CASE(ScanLexerLines) {
+    std::string source_code = std::string(40, ' ') + "\n\n\t\t\r\n" + std::string(100, ' ') + "a // " +
+                              std::string(60, 'x') + "\n\"" + std::string(50, '\n') + "\" b";
+    Lexer lexer(source_code);
+    const std::vector<Token> tokens = lexer.TokenizeAll();
+
+    BOOST_REQUIRE_EQUAL(tokens.size(), 4);
+    BOOST_CHECK_EQUAL(tokens[0].type, TT::IDENTIFIER);
+    BOOST_CHECK_EQUAL(tokens[0].line, 3);
+    BOOST_CHECK_EQUAL(tokens[1].type, TT::STRING);
+    BOOST_CHECK_EQUAL(tokens[1].line, 4);
+    BOOST_CHECK_EQUAL(tokens[2].type, TT::IDENTIFIER);
+    BOOST_CHECK_EQUAL(tokens[2].line, 54);
+}
@@ -0,0 +1,61 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "symbol_table.h"
+#include "parser.h"
+#include "semantic_analyser.h"
+
+Symbol Variable(std::string_view name) {
+    return {SymbolType::VARIABLE, VariableInfo(name)};
+}
+
+std::string_view NameOf(const Symbol* symbol) {
+    return std::get<VariableInfo>(symbol->object).name;
+}
+
+BOOST_AUTO_TEST_CASE(ScopeChainShadowing) {
+    ScopeChain scopes;
+    scopes.PushScope();
+    BOOST_CHECK(scopes.AddSymbol(1, Variable("global")));
+    BOOST_CHECK(!scopes.AddSymbol(1, Variable("duplicate")));
+    BOOST_CHECK_EQUAL(scopes.GetSymbol(2), nullptr);
+
+    scopes.PushScope();
+    BOOST_CHECK_EQUAL(NameOf(scopes.GetSymbol(1)), "global");
+    BOOST_CHECK(scopes.AddSymbol(1, Variable("outer")));
+    BOOST_CHECK(scopes.AddSymbol(2, Variable("local")));
+    scopes.PushScope();
+    scopes.PushScope(); // Empty scopes are popped too
+    BOOST_CHECK(scopes.AddSymbol(1, Variable("inner")));
+    BOOST_CHECK_EQUAL(NameOf(scopes.GetSymbol(1)), "inner");
+    BOOST_CHECK_EQUAL(NameOf(scopes.GetSymbol(2)), "local");
+    BOOST_CHECK_EQUAL(scopes.Depth(), 4);
+
+    scopes.PopScope();
+    scopes.PopScope();
+    BOOST_CHECK_EQUAL(NameOf(scopes.GetSymbol(1)), "outer");
+    scopes.PopScope();
+    BOOST_CHECK_EQUAL(NameOf(scopes.GetSymbol(1)), "global");
+    BOOST_CHECK_EQUAL(scopes.GetSymbol(2), nullptr);
+
+    // A popped name can be bound again
+    scopes.PushScope();
+    BOOST_CHECK(scopes.AddSymbol(2, Variable("again")));
+    BOOST_CHECK_EQUAL(NameOf(scopes.GetSymbol(2)), "again");
+    scopes.PopScope();
+    BOOST_CHECK_EQUAL(scopes.Depth(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(AnalyserScopes) {
+    auto error_count = [](const std::string& source_code) {
+        Parser parser(source_code);
+        auto ast = parser.GenerateAST();
+        SemanticAnalyser analyser;
+        ast->accept(analyser);
+        return analyser.GetErrorCount();
+    };
+    BOOST_CHECK_EQUAL(error_count("var a = 1; { var a = 2; { var a = 3; a; } a; } a;"), 0);
+    BOOST_CHECK_EQUAL(error_count("{ var b = 1; } b;"), 1);
+    BOOST_CHECK_EQUAL(error_count("{ var c = 1; var c = 2; }"), 1);
+    BOOST_CHECK_EQUAL(error_count("fun f(x) { x; { var x = 1; } x; } x;"), 1);
+    BOOST_CHECK_EQUAL(error_count("var g = 1; { fun g() {} g(); } g();"), 1);
+}
@@ -0,0 +1,77 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "semantic_analyser.h"
+#include "debug.h"
+
+struct Result {
+    std::string chunk;
+    size_t error_count;
+};
+
+Result CompileTree(const std::string& source_code) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    SemanticAnalyser analyser;
+    ast->accept(analyser);
+    Compiler compiler;
+    Chunk chunk = compiler.Compile(ast.get());
+    return {Debug::GetChunkStr(chunk), analyser.GetErrorCount()};
+}
+
+Result CompileSinglePass(const std::string& source_code) {
+    Parser parser(source_code);
+    SemanticAnalyser analyser;
+    Chunk chunk = parser.GenerateChunk(analyser);
+    return {Debug::GetChunkStr(chunk), analyser.GetErrorCount()};
+}
+
+BOOST_AUTO_TEST_CASE(SinglePassMatchesTree) {
+    const std::vector<std::string> scripts = {
+        "1 + 2 * 3 - 4 / 5;",
+        "-(1 + 2) == !true;",
+        "(1 >= 2) != (3 <= 4);",
+        "var a = 1; var b; a = a + 1;",
+        "if (1 < 2) print \"yes\";",
+        "if (1 > 2) { print 1; } else { print 2; } print 3;",
+        "var n = 10; while (n > 0) { n = n - 1; }",
+        "fun f(x, y) { var z = x + y; return z; } f(1, 2 * 3);",
+        "fun g() { return; } (g)();",
+    };
+    for (const auto& script : scripts) {
+        Result tree = CompileTree(script);
+        Result single_pass = CompileSinglePass(script);
+        BOOST_CHECK_EQUAL(tree.chunk, single_pass.chunk);
+        BOOST_CHECK_EQUAL(single_pass.error_count, 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SinglePassResolvesNames) {
+    const std::vector<std::string> invalid_scripts = {
+        "var a = 1; var a = 2;",
+        "fun f() {} fun f() {}",
+        "b = 1;",
+        "{ var c = 1; } c;",
+        "if (d) {}",
+        "while (1 + e) {}",
+        "fun f(x) {} f(1, 2);",
+        "fun f(x) {} f(y);",
+        "g();",
+        "var v = 1; v();",
+        "fun h(p) {} p;",
+    };
+    for (const auto& script : invalid_scripts) {
+        BOOST_CHECK_EQUAL(CompileSinglePass(script).error_count, 1);
+        BOOST_CHECK_EQUAL(CompileSinglePass(script).error_count, CompileTree(script).error_count);
+    }
+
+    // Parameters and locals are visible inside the function body only
+    BOOST_CHECK_EQUAL(CompileSinglePass("fun f(x) { var y = x; { y = x; } }").error_count, 0);
+}
+
+BOOST_AUTO_TEST_CASE(SinglePassLargeConstantPool) {
+    std::string script;
+    for (int i = 0; i < 300; i++) script += std::to_string(i) + ";";
+    BOOST_CHECK_EQUAL(CompileSinglePass(script).chunk, CompileTree(script).chunk);
+}
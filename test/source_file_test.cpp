@@ -0,0 +1,86 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include "source_file.h"
+#include "lexer.h"
+#include "debug.h"
+
+static std::string WriteTempFile(const std::string& name, const std::string& contents) {
+    auto path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+// Check that regular files are memory mapped and lexed in place
+BOOST_AUTO_TEST_CASE(SourceFileMapped) {
+    // A multiple of the page size, so the mapping has no zero padding after the last character
+    std::string contents = "var a = 1;\n" + std::string(4096 - 15, ' ') + "b;\"c";
+    BOOST_REQUIRE_EQUAL(contents.size(), 4096);
+    auto path = WriteTempFile("clox_source_file_test.lox", contents);
+
+    SourceFile source_file = SourceFile::Open(path);
+    BOOST_CHECK(source_file.IsMapped());
+    BOOST_CHECK_EQUAL(source_file.GetText(), contents);
+
+    Lexer lexer(source_file.GetText());
+    const std::vector<Token> tokens = lexer.TokenizeAll();
+    const std::vector<TT> expected = {
+        TT::VAR, TT::IDENTIFIER, TT::EQUAL, TT::NUMBER, TT::SEMICOLON, TT::IDENTIFIER, TT::SEMICOLON, TT::ERROR, TT::END,
+    };
+    BOOST_REQUIRE_EQUAL(tokens.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BOOST_CHECK_EQUAL(tokens[i].type, expected[i]);
+    }
+
+    // Moving keeps the text in place, so existing string_views stay valid
+    std::string_view text = source_file.GetText();
+    SourceFile moved = std::move(source_file);
+    BOOST_CHECK_EQUAL(moved.GetText().data(), text.data());
+    std::remove(path.c_str());
+}
+
+// Check that empty files and pipes are read instead of mapped
+BOOST_AUTO_TEST_CASE(SourceFileRead) {
+    auto path = WriteTempFile("clox_source_file_empty.lox", "");
+    SourceFile empty = SourceFile::Open(path);
+    BOOST_CHECK_EQUAL(empty.GetText(), "");
+    std::remove(path.c_str());
+
+    std::string contents;
+    for (int i = 0; i < 10000; i++) contents += "print " + std::to_string(i) + ";\n";
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds), 0);
+    std::thread writer([&] {
+        BOOST_REQUIRE_EQUAL(write(fds[1], contents.data(), contents.size()), contents.size());
+        close(fds[1]);
+    });
+    SourceFile piped = SourceFile::FromDescriptor(fds[0], "<pipe>");
+    writer.join();
+    close(fds[0]);
+    BOOST_CHECK(!piped.IsMapped());
+    BOOST_CHECK_EQUAL(piped.GetText(), contents);
+}
+
+// Check that missing files throw
+BOOST_AUTO_TEST_CASE(SourceFileMissing) {
+    BOOST_CHECK_THROW(SourceFile::Open("/nonexistent/clox/script.lox"), std::runtime_error);
+}
+
+// Check that the lexer doesn't read past the end of a source that isn't null terminated
+BOOST_AUTO_TEST_CASE(SourceFileLexerBounded) {
+    std::string buffer = "var abc = \"def\"";
+    const std::vector<Token> identifier = Lexer(std::string_view(buffer).substr(0, 6)).TokenizeAll();
+    BOOST_REQUIRE_EQUAL(identifier.size(), 3);
+    BOOST_CHECK_EQUAL(identifier[1].lexeme, "ab");
+
+    const std::vector<Token> string = Lexer(std::string_view(buffer).substr(0, 14)).TokenizeAll();
+    BOOST_REQUIRE_EQUAL(string.size(), 5);
+    BOOST_CHECK_EQUAL(string[3].type, TT::ERROR);
+
+    const std::vector<Token> comment = Lexer(std::string_view("1 // x\n2", 5)).TokenizeAll();
+    BOOST_REQUIRE_EQUAL(comment.size(), 2);
+}
@@ -0,0 +1,84 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "semantic_analyser.h"
+#include "verifier.h"
+#include "vm.h"
+#include "debug.h"
+
+const std::string SCRIPT =
+    "var a = 1 + 2;\n"
+    "fun f(x, y) { var z = x; return -z + 4; }\n"
+    "if (a > 2) { print \"big\"; } else { print !true; }\n"
+    "while (a != 0) { a = a - 1; }\n"
+    "f(1, 2);\n"
+    "(1 >= 2) == (3 < 4);\n";
+
+BOOST_AUTO_TEST_CASE(StreamingMatchesWholeProgram) {
+    Parser whole_parser(SCRIPT);
+    auto ast = whole_parser.GenerateAST();
+    SemanticAnalyser whole_analyser;
+    ast->accept(whole_analyser);
+    Compiler whole_compiler;
+    Chunk whole_chunk = whole_compiler.Compile(ast.get());
+
+    Parser parser(SCRIPT);
+    SemanticAnalyser analyser;
+    size_t declaration_count = 0;
+    size_t instruction_count = 0;
+    while (auto declaration = parser.GenerateNextDeclaration()) {
+        BOOST_REQUIRE_EQUAL(declaration->declarations.size(), 1);
+        declaration->accept(analyser);
+        Compiler compiler;
+        instruction_count += compiler.Compile(declaration.get()).InstructionCount();
+        declaration_count++;
+    }
+    BOOST_CHECK_EQUAL(declaration_count, ast->declarations.size());
+    BOOST_CHECK_EQUAL(instruction_count, whole_chunk.InstructionCount());
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 0);
+    BOOST_CHECK(parser.GenerateNextDeclaration() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(StreamingKeepsDeclarations) {
+    // Names declared by earlier declarations are still known to later ones
+    const std::string source_code = "var a = 1; fun f(x) {} a = 2; f(a); b;";
+    Parser parser(source_code);
+    SemanticAnalyser analyser;
+    while (auto declaration = parser.GenerateNextDeclaration()) {
+        declaration->accept(analyser);
+    }
+    BOOST_CHECK_EQUAL(analyser.GetErrorCount(), 1); // b
+}
+
+BOOST_AUTO_TEST_CASE(StreamingRunsEachChunk) {
+    const std::string source_code = "var a = 1; var b = a; 1 + 2; -true; 3;";
+    Parser parser(source_code);
+    VM vm;
+    std::vector<bool> results;
+    while (auto declaration = parser.GenerateNextDeclaration()) {
+        Compiler compiler;
+        Chunk chunk = compiler.Compile(declaration.get());
+        Verifier verifier;
+        BOOST_REQUIRE(verifier.Verify(chunk, vm.GetStackDepth()));
+        results.push_back(vm.Interpret(chunk));
+    }
+    BOOST_CHECK_EQUAL(results.size(), 5);
+    BOOST_CHECK(results[0] && results[1] && results[2]);
+    BOOST_CHECK(!results[3]); // Negating a bool is a runtime error
+}
+
+BOOST_AUTO_TEST_CASE(StreamingVerifiesOnTheCurrentStack) {
+    // The global a is on the stack from the first chunk, the second one is verified with it there
+    const std::string source_code = "var a = 1; print a + 2;";
+    Parser parser(source_code);
+    VM vm;
+    while (auto declaration = parser.GenerateNextDeclaration()) {
+        Compiler compiler;
+        Chunk chunk = compiler.Compile(declaration.get());
+        Verifier verifier;
+        BOOST_REQUIRE(verifier.Verify(chunk, vm.GetStackDepth()));
+        BOOST_CHECK_EQUAL(*chunk.GetMaxStackDepth(), 1);
+        BOOST_REQUIRE(vm.Interpret(chunk));
+    }
+}
@@ -0,0 +1,76 @@
+#define BOOST_TEST_MODULE MyTest
+#include <boost/test/unit_test.hpp>
+#include "parser.h"
+#include "compiler.h"
+#include "verifier.h"
+
+Chunk CompileSource(std::string source_code) {
+    Parser parser(source_code);
+    auto ast = parser.GenerateAST();
+    Compiler compiler;
+    return compiler.Compile(ast.get());
+}
+
+Chunk CreateChunk(std::vector<uint8_t> code, size_t constant_count = 1) {
+    Chunk chunk;
+    for (size_t i = 0; i < constant_count; i++) chunk.AddConstant(static_cast<double>(i));
+    for (auto byte : code) chunk.Write(byte);
+    return chunk;
+}
+
+uint8_t Byte(OP op) {
+    return static_cast<uint8_t>(op);
+}
+
+BOOST_AUTO_TEST_CASE(VerifierComputesMaxDepth) {
+    Chunk chunk = CompileSource("1 + 2 * 3; 4;");
+    BOOST_CHECK(!chunk.GetMaxStackDepth().has_value());
+
+    Verifier verifier;
+    BOOST_REQUIRE(verifier.Verify(chunk));
+    BOOST_CHECK_EQUAL(*chunk.GetMaxStackDepth(), 3);
+
+    // Writing to the chunk invalidates the result
+    chunk.Write(Byte(OP::POP));
+    BOOST_CHECK(!chunk.GetMaxStackDepth().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(VerifierFollowsJumps) {
+    Chunk chunk = CompileSource("if (1 < 2) 3 + 4; else 5;");
+    Verifier verifier;
+    BOOST_REQUIRE(verifier.Verify(chunk));
+    BOOST_CHECK_EQUAL(*chunk.GetMaxStackDepth(), 2);
+
+    Chunk empty;
+    BOOST_REQUIRE(verifier.Verify(empty));
+    BOOST_CHECK_EQUAL(*empty.GetMaxStackDepth(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(VerifierRejectsMalformedCode) {
+    Verifier verifier;
+
+    Chunk underflow = CreateChunk({Byte(OP::CONSTANT), 0, Byte(OP::ADD)});
+    BOOST_CHECK(!verifier.Verify(underflow));
+    BOOST_CHECK(!underflow.GetMaxStackDepth().has_value());
+
+    Chunk truncated = CreateChunk({Byte(OP::CONSTANT)});
+    BOOST_CHECK(!verifier.Verify(truncated));
+
+    Chunk invalid_opcode = CreateChunk({200});
+    BOOST_CHECK(!verifier.Verify(invalid_opcode));
+
+    Chunk invalid_constant = CreateChunk({Byte(OP::CONSTANT), 1});
+    BOOST_CHECK(!verifier.Verify(invalid_constant));
+
+    Chunk out_of_bounds_jump = CreateChunk({Byte(OP::JUMP), 0xff, 0xff});
+    BOOST_CHECK(!verifier.Verify(out_of_bounds_jump));
+
+    // Jumps into the operand of CONSTANT
+    Chunk misaligned_jump = CreateChunk({Byte(OP::JUMP), 1, 0, Byte(OP::CONSTANT), 0});
+    BOOST_CHECK(!verifier.Verify(misaligned_jump));
+
+    // POP is reached with depth 0 when jumping and with depth 1 when falling through
+    Chunk inconsistent = CreateChunk({Byte(OP::CONSTANT), 0, Byte(OP::JUMP_IF_FALSE), 2, 0,
+                                      Byte(OP::CONSTANT), 0, Byte(OP::POP)});
+    BOOST_CHECK(!verifier.Verify(inconsistent));
+}